@@ -0,0 +1,56 @@
+#include "bench.hpp"
+
+#include <luabind/allocator.hpp>
+
+#include <memory>
+
+// Churn of short-lived objects with a custom table each, in a state using pool_allocator.
+// The raw baseline is the same script in a state with the default allocator.
+
+namespace {
+
+class Particle : public luabind::Object {
+public:
+    double x = 0;
+};
+
+void bindParticle(lua_State* L) {
+    luabind::class_<Particle>(L, "Particle").property<&Particle::x>("x");
+}
+
+constexpr const char* churn = R"--(
+    return function(n)
+        for i = 1, n do
+            local p = Particle:new()
+            p.x = i
+            p.tag = i
+        end
+    end
+)--";
+
+// the pool and its state live as long as the operation
+struct pooled_state {
+    luabind::pool_allocator pool;
+    lua_State* L = nullptr;
+
+    ~pooled_state() {
+        lua_close(L);
+    }
+};
+
+} // namespace
+
+LUABIND_BENCH("allocator/pool/churn") {
+    static_cast<void>(L);
+    auto state = std::make_shared<pooled_state>();
+    state->L = lua_newstate(&luabind::pool_allocator::alloc, &state->pool);
+    luaL_openlibs(state->L);
+    bindParticle(state->L);
+    bench::operation loop = bench::lua_loop(state->L, churn);
+    return [state, loop](size_t n) { loop(n); };
+}
+
+LUABIND_BENCH_RAW("allocator/pool/churn") {
+    bindParticle(L);
+    return bench::lua_loop(L, churn);
+}
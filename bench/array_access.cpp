@@ -0,0 +1,141 @@
+#include "bench.hpp"
+
+#include <vector>
+
+namespace {
+
+class Buffer : public luabind::Object {
+public:
+    int get(size_t idx) {
+        return values[idx - 1];
+    }
+
+    void set(size_t idx, int value) {
+        values[idx - 1] = value;
+    }
+
+public:
+    std::vector<int> values = std::vector<int>(16);
+};
+
+void bindBuffer(lua_State* L) {
+    luabind::class_<Buffer>(L, "Buffer").array_access<&Buffer::get, &Buffer::set>();
+}
+
+int rawNew(lua_State* L) {
+    bench::raw::push<std::vector<int>>(L, "Buffer", 16);
+    return 1;
+}
+
+int rawIndex(lua_State* L) {
+    auto* values = bench::raw::check<std::vector<int>>(L, 1, "Buffer");
+    const lua_Integer idx = luaL_checkinteger(L, 2);
+    lua_pushinteger(L, (*values)[static_cast<size_t>(idx - 1)]);
+    return 1;
+}
+
+int rawNewIndex(lua_State* L) {
+    auto* values = bench::raw::check<std::vector<int>>(L, 1, "Buffer");
+    const lua_Integer idx = luaL_checkinteger(L, 2);
+    (*values)[static_cast<size_t>(idx - 1)] = static_cast<int>(luaL_checkinteger(L, 3));
+    return 0;
+}
+
+void bindRawBuffer(lua_State* L) {
+    static const luaL_Reg methods[] = {{"new", &rawNew}, {nullptr, nullptr}};
+    bench::raw::new_class<std::vector<int>>(L, "Buffer", methods);
+    luaL_getmetatable(L, "Buffer");
+    lua_pushcfunction(L, &rawIndex);
+    lua_setfield(L, -2, "__index");
+    lua_pushcfunction(L, &rawNewIndex);
+    lua_setfield(L, -2, "__newindex");
+    lua_pop(L, 1);
+}
+
+constexpr const char* array_get = R"--(
+    local b = Buffer:new()
+    return function(n)
+        for i = 1, n do local v = b[(i & 15) + 1] end
+    end
+)--";
+
+constexpr const char* array_set = R"--(
+    local b = Buffer:new()
+    return function(n)
+        for i = 1, n do b[(i & 15) + 1] = i end
+    end
+)--";
+
+std::vector<int> viewBuffer(16);
+
+luabind::array_view<int> bufferView() {
+    return {viewBuffer.data(), viewBuffer.size()};
+}
+
+// the same loops over a global `view`, an array_view or a raw Buffer
+constexpr const char* view_get = R"--(
+    local b = view
+    return function(n)
+        for i = 1, n do local v = b[(i & 15) + 1] end
+    end
+)--";
+
+constexpr const char* view_set = R"--(
+    local b = view
+    return function(n)
+        for i = 1, n do b[(i & 15) + 1] = i end
+    end
+)--";
+
+void pushView(lua_State* L) {
+    luabind::value_mirror<luabind::array_view<int>>::to_lua(L, bufferView());
+    lua_setglobal(L, "view");
+}
+
+void pushRawView(lua_State* L) {
+    bindRawBuffer(L);
+    rawNew(L);
+    lua_setglobal(L, "view");
+}
+
+} // namespace
+
+LUABIND_BENCH("array_access/get") {
+    bindBuffer(L);
+    return bench::lua_loop(L, array_get);
+}
+
+LUABIND_BENCH_RAW("array_access/get") {
+    bindRawBuffer(L);
+    return bench::lua_loop(L, array_get);
+}
+
+LUABIND_BENCH("array_access/set") {
+    bindBuffer(L);
+    return bench::lua_loop(L, array_set);
+}
+
+LUABIND_BENCH_RAW("array_access/set") {
+    bindRawBuffer(L);
+    return bench::lua_loop(L, array_set);
+}
+
+LUABIND_BENCH("array_view/get") {
+    pushView(L);
+    return bench::lua_loop(L, view_get);
+}
+
+LUABIND_BENCH_RAW("array_view/get") {
+    pushRawView(L);
+    return bench::lua_loop(L, view_get);
+}
+
+LUABIND_BENCH("array_view/set") {
+    pushView(L);
+    return bench::lua_loop(L, view_set);
+}
+
+LUABIND_BENCH_RAW("array_view/set") {
+    pushRawView(L);
+    return bench::lua_loop(L, view_set);
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <luabind/bind.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <new>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+// A benchmark case prepares its own lua_State and returns a callable which performs `n` operations.
+using operation = std::function<void(size_t n)>;
+using setup = std::function<operation(lua_State* L)>;
+
+struct bench_case {
+    std::string name;
+    setup prepare;
+};
+
+inline std::vector<bench_case>& cases() {
+    static std::vector<bench_case> instance;
+    return instance;
+}
+
+// Hand-written Lua C API counterparts of cases, by case name.
+inline std::map<std::string, setup, std::less<>>& baselines() {
+    static std::map<std::string, setup, std::less<>> instance;
+    return instance;
+}
+
+// Extra values of the running case, e.g. latency percentiles, printed after its line and written to the JSON.
+inline std::vector<std::pair<std::string, double>>& metrics() {
+    static std::vector<std::pair<std::string, double>> instance;
+    return instance;
+}
+
+// Sets a metric of the running case, the last value reported under a name is kept.
+inline void report(std::string_view name, double value) {
+    for (auto& [metric, v] : metrics()) {
+        if (metric == name) {
+            v = value;
+            return;
+        }
+    }
+    metrics().emplace_back(name, value);
+}
+
+struct registrar {
+    registrar(std::string name, setup prepare) {
+        cases().push_back({std::move(name), std::move(prepare)});
+    }
+};
+
+struct baseline_registrar {
+    baseline_registrar(std::string name, setup prepare) {
+        baselines().emplace(std::move(name), std::move(prepare));
+    }
+};
+
+// Compiles `script`, which should return a function taking the iteration count,
+// and returns an operation calling it.
+inline operation lua_loop(lua_State* L, const char* script) {
+    if (luaL_dostring(L, script) != LUA_OK) {
+        std::fprintf(stderr, "bench script failed: %s\n", lua_tostring(L, -1));
+        std::abort();
+    }
+    const int ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    return [L, ref](size_t n) {
+        lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
+        lua_pushinteger(L, static_cast<lua_Integer>(n));
+        if (lua_pcall(L, 1, 0, 0) != LUA_OK) {
+            std::fprintf(stderr, "bench loop failed: %s\n", lua_tostring(L, -1));
+            std::abort();
+        }
+    };
+}
+
+namespace raw {
+
+// Pushes a new userdata holding T with the metatable registered under `type_name`.
+template <typename T, typename... Args>
+T* push(lua_State* L, const char* type_name, Args&&... args) {
+    void* p = lua_newuserdatauv(L, sizeof(T), 0);
+    T* object = new (p) T(std::forward<Args>(args)...);
+    luaL_setmetatable(L, type_name);
+    return object;
+}
+
+template <typename T>
+T* check(lua_State* L, int idx, const char* type_name) {
+    return static_cast<T*>(luaL_checkudata(L, idx, type_name));
+}
+
+template <typename T>
+int gc(lua_State* L) {
+    static_cast<T*>(lua_touserdata(L, 1))->~T();
+    return 0;
+}
+
+// Creates a metatable for T with __gc, __index set to the methods table and the methods
+// registered as globals under `type_name` too, so scripts can call `TypeName.new()`.
+template <typename T>
+void new_class(lua_State* L, const char* type_name, const luaL_Reg* methods) {
+    luaL_newmetatable(L, type_name);
+    lua_pushcfunction(L, &gc<T>);
+    lua_setfield(L, -2, "__gc");
+    lua_newtable(L);
+    luaL_setfuncs(L, methods, 0);
+    lua_pushvalue(L, -1);
+    lua_setglobal(L, type_name);
+    lua_setfield(L, -2, "__index");
+    lua_pop(L, 1);
+}
+
+} // namespace raw
+
+struct measurement {
+    size_t iterations;
+    double ns_per_op;
+};
+
+// Doubles the iteration count until a single run takes at least `min_time`.
+inline measurement measure(const operation& op, std::chrono::nanoseconds min_time) {
+    using clock = std::chrono::steady_clock;
+    op(1); // warm up
+    for (size_t n = 1;; n *= 2) {
+        const auto start = clock::now();
+        op(n);
+        const auto elapsed = clock::now() - start;
+        if (elapsed >= min_time) {
+            const double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+            return {n, ns / static_cast<double>(n)};
+        }
+    }
+}
+
+} // namespace bench
+
+#define LUABIND_BENCH_CONCAT_IMPL(a, b) a##b
+#define LUABIND_BENCH_CONCAT(a, b) LUABIND_BENCH_CONCAT_IMPL(a, b)
+
+// LUABIND_BENCH("group/name") { ...; return bench::lua_loop(L, "..."); }
+#define LUABIND_BENCH(name) LUABIND_BENCH_IMPL(bench::registrar, name, __COUNTER__)
+// The same operation written against the raw Lua C API, reported next to the case of the same name.
+#define LUABIND_BENCH_RAW(name) LUABIND_BENCH_IMPL(bench::baseline_registrar, name, __COUNTER__)
+#define LUABIND_BENCH_IMPL(registrar_type, name, id)                                                     \
+    static bench::operation LUABIND_BENCH_CONCAT(bench_setup_, id)(lua_State * L);                       \
+    static const registrar_type LUABIND_BENCH_CONCAT(bench_registrar_, id) {                             \
+        name, &LUABIND_BENCH_CONCAT(bench_setup_, id)                                                     \
+    };                                                                                                   \
+    static bench::operation LUABIND_BENCH_CONCAT(bench_setup_, id)(lua_State * L)
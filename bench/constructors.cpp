@@ -0,0 +1,101 @@
+#include "bench.hpp"
+
+#include <memory>
+
+namespace {
+
+class Point : public luabind::Object {
+public:
+    Point(int x, int y)
+        : x(x)
+        , y(y) {}
+
+public:
+    int x;
+    int y;
+};
+
+void bindPoint(lua_State* L) {
+    luabind::class_<Point>(L, "Point").constructor<int, int>("new").construct_shared<int, int>("create");
+}
+
+// the same point bound as a value type, without Object
+struct ValuePoint final {
+    int x;
+    int y;
+};
+
+void bindValuePoint(lua_State* L) {
+    luabind::class_<ValuePoint>(L, "Point").constructor<int, int>("new");
+}
+
+struct RawPoint {
+    int x;
+    int y;
+};
+
+int rawNew(lua_State* L) {
+    const auto x = static_cast<int>(luaL_checkinteger(L, 2));
+    const auto y = static_cast<int>(luaL_checkinteger(L, 3));
+    bench::raw::push<RawPoint>(L, "Point", RawPoint {x, y});
+    return 1;
+}
+
+// a userdata holding a shared_ptr, as a hand-written binding of shared objects would do
+int rawCreate(lua_State* L) {
+    const auto x = static_cast<int>(luaL_checkinteger(L, 2));
+    const auto y = static_cast<int>(luaL_checkinteger(L, 3));
+    bench::raw::push<std::shared_ptr<RawPoint>>(L, "SharedPoint", std::make_shared<RawPoint>(RawPoint {x, y}));
+    return 1;
+}
+
+void bindRawPoint(lua_State* L) {
+    static const luaL_Reg shared_methods[] = {{nullptr, nullptr}};
+    bench::raw::new_class<std::shared_ptr<RawPoint>>(L, "SharedPoint", shared_methods);
+    static const luaL_Reg methods[] = {{"new", &rawNew}, {"create", &rawCreate}, {nullptr, nullptr}};
+    bench::raw::new_class<RawPoint>(L, "Point", methods);
+}
+
+constexpr const char* construct = R"--(
+    return function(n)
+        for i = 1, n do local p = Point:new(i, 2) end
+    end
+)--";
+
+constexpr const char* construct_shared = R"--(
+    return function(n)
+        for i = 1, n do local p = Point:create(i, 2) end
+    end
+)--";
+
+} // namespace
+
+LUABIND_BENCH("constructor/lua") {
+    bindPoint(L);
+    return bench::lua_loop(L, construct);
+}
+
+LUABIND_BENCH_RAW("constructor/lua") {
+    bindRawPoint(L);
+    return bench::lua_loop(L, construct);
+}
+
+LUABIND_BENCH("constructor/shared") {
+    bindPoint(L);
+    return bench::lua_loop(L, construct_shared);
+}
+
+LUABIND_BENCH_RAW("constructor/shared") {
+    bindRawPoint(L);
+    return bench::lua_loop(L, construct_shared);
+}
+
+LUABIND_BENCH("constructor/value") {
+    bindValuePoint(L);
+    return bench::lua_loop(L, construct);
+}
+
+LUABIND_BENCH_RAW("constructor/value") {
+    bindRawPoint(L);
+    return bench::lua_loop(L, construct);
+}
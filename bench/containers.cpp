@@ -0,0 +1,79 @@
+#include "bench.hpp"
+
+#include <numeric>
+#include <vector>
+
+// Converting a 1M element vector<int> to a table and back, one conversion per operation.
+
+namespace {
+
+constexpr size_t element_count = 1'000'000;
+
+const std::vector<int>& bigVector() {
+    static const std::vector<int> v = [] {
+        std::vector<int> r(element_count);
+        std::iota(r.begin(), r.end(), 0);
+        return r;
+    }();
+    return v;
+}
+
+const std::vector<int>& giveVector() {
+    return bigVector();
+}
+
+void takeVector(const std::vector<int>&) {}
+
+int rawGiveVector(lua_State* L) {
+    const std::vector<int>& v = bigVector();
+    lua_createtable(L, static_cast<int>(v.size()), 0);
+    for (size_t i = 0; i < v.size(); ++i) {
+        lua_pushinteger(L, v[i]);
+        lua_rawseti(L, -2, static_cast<lua_Integer>(i + 1));
+    }
+    return 1;
+}
+
+int rawTakeVector(lua_State* L) {
+    luaL_checktype(L, 1, LUA_TTABLE);
+    const size_t size = static_cast<size_t>(lua_rawlen(L, 1));
+    std::vector<int> v;
+    v.reserve(size);
+    for (size_t i = 1; i <= size; ++i) {
+        lua_rawgeti(L, 1, static_cast<lua_Integer>(i));
+        v.push_back(static_cast<int>(luaL_checkinteger(L, -1)));
+        lua_pop(L, 1);
+    }
+    return 0;
+}
+
+constexpr const char* give_loop = "local f = give\nreturn function(n) for i = 1, n do local r = f() end end";
+
+constexpr const char* take_loop = R"--(
+    local t = {}
+    for i = 1, 1000000 do t[i] = i end
+    local f = take
+    return function(n) for i = 1, n do f(t) end end
+)--";
+
+} // namespace
+
+LUABIND_BENCH("container/vector_1m/to_lua") {
+    luabind::function<&giveVector>(L, "give");
+    return bench::lua_loop(L, give_loop);
+}
+
+LUABIND_BENCH_RAW("container/vector_1m/to_lua") {
+    lua_register(L, "give", &rawGiveVector);
+    return bench::lua_loop(L, give_loop);
+}
+
+LUABIND_BENCH("container/vector_1m/from_lua") {
+    luabind::function<&takeVector>(L, "take");
+    return bench::lua_loop(L, take_loop);
+}
+
+LUABIND_BENCH_RAW("container/vector_1m/from_lua") {
+    lua_register(L, "take", &rawTakeVector);
+    return bench::lua_loop(L, take_loop);
+}
@@ -0,0 +1,88 @@
+#include "bench.hpp"
+
+#include <luabind/descriptor.hpp>
+
+#include <utility>
+
+// Creating a state and binding a class with 20 methods: with a class_ chain, or with a descriptor
+// evaluated at compile time. The raw baseline fills a metatable with luaL_setfuncs.
+
+namespace {
+
+constexpr size_t method_count = 20;
+
+class Wide : public luabind::Object {
+public:
+    template <size_t I>
+    int get() const {
+        return value + static_cast<int>(I);
+    }
+
+public:
+    int value = 0;
+};
+
+constexpr const char* method_names[method_count] = {
+    "m00", "m01", "m02", "m03", "m04", "m05", "m06", "m07", "m08", "m09",
+    "m10", "m11", "m12", "m13", "m14", "m15", "m16", "m17", "m18", "m19",
+};
+
+using WideDescriptor = luabind::descriptor<Wide>;
+
+template <size_t... I>
+constexpr auto describeWide(std::index_sequence<I...>) {
+    return WideDescriptor::make("Wide", {WideDescriptor::function<&Wide::get<I>>(method_names[I])...});
+}
+
+constexpr auto wide_class = describeWide(std::make_index_sequence<method_count> {});
+
+template <size_t... I>
+void bindWide(lua_State* L, std::index_sequence<I...>) {
+    luabind::class_<Wide> c(L, "Wide");
+    (c.function<&Wide::get<I>>(method_names[I]), ...);
+}
+
+template <size_t I>
+int rawGet(lua_State* L) {
+    lua_pushinteger(L, bench::raw::check<Wide>(L, 1, "Wide")->get<I>());
+    return 1;
+}
+
+template <size_t... I>
+void bindRaw(lua_State* L, std::index_sequence<I...>) {
+    static const luaL_Reg methods[] = {{method_names[I], &rawGet<I>}..., {nullptr, nullptr}};
+    bench::raw::new_class<Wide>(L, "Wide", methods);
+}
+
+template <typename Bind>
+bench::operation newStates(Bind bind) {
+    return [bind](size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            lua_State* state = luaL_newstate();
+            bind(state);
+            lua_close(state);
+        }
+    };
+}
+
+} // namespace
+
+LUABIND_BENCH("descriptor/new_state/class_chain") {
+    static_cast<void>(L);
+    return newStates([](lua_State* state) { bindWide(state, std::make_index_sequence<method_count> {}); });
+}
+
+LUABIND_BENCH_RAW("descriptor/new_state/class_chain") {
+    static_cast<void>(L);
+    return newStates([](lua_State* state) { bindRaw(state, std::make_index_sequence<method_count> {}); });
+}
+
+LUABIND_BENCH("descriptor/new_state/descriptor") {
+    static_cast<void>(L);
+    return newStates([](lua_State* state) { luabind::bind<wide_class>(state); });
+}
+
+LUABIND_BENCH_RAW("descriptor/new_state/descriptor") {
+    static_cast<void>(L);
+    return newStates([](lua_State* state) { bindRaw(state, std::make_index_sequence<method_count> {}); });
+}
@@ -0,0 +1,94 @@
+#include "bench.hpp"
+
+#include <array>
+
+namespace {
+
+class Probe : public luabind::Object {
+public:
+    void setValue(int v) {
+        value = v;
+    }
+
+public:
+    int value = 0;
+};
+
+void bindProbe(lua_State* L) {
+    luabind::class_<Probe>(L, "Probe").function<&Probe::setValue>("setValue");
+}
+
+int sum(const std::array<int, 4>& v) {
+    return v[0] + v[1] + v[2] + v[3];
+}
+
+// Raw Lua C API version of Probe, reporting the type error with luaL_checkinteger.
+struct RawProbe {
+    int value = 0;
+};
+
+int rawNew(lua_State* L) {
+    bench::raw::push<RawProbe>(L, "Probe");
+    return 1;
+}
+
+int rawSetValue(lua_State* L) {
+    bench::raw::check<RawProbe>(L, 1, "Probe")->value = static_cast<int>(luaL_checkinteger(L, 2));
+    return 0;
+}
+
+void bindRawProbe(lua_State* L) {
+    static const luaL_Reg methods[] = {{"new", &rawNew}, {"setValue", &rawSetValue}, {nullptr, nullptr}};
+    bench::raw::new_class<RawProbe>(L, "Probe", methods);
+}
+
+constexpr const char* argument_type = R"--(
+    local p = Probe:new()
+    return function(n)
+        for i = 1, n do pcall(p.setValue, p, 'abc') end
+    end
+)--";
+
+} // namespace
+
+LUABIND_BENCH("error/argument_type") {
+    bindProbe(L);
+    return bench::lua_loop(L, argument_type);
+}
+
+LUABIND_BENCH_RAW("error/argument_type") {
+    bindRawProbe(L);
+    return bench::lua_loop(L, argument_type);
+}
+
+// elements of an array of integers are converted with nothing to destroy, their errors are raised directly too
+LUABIND_BENCH("error/element_type") {
+    luabind::function<&sum>(L, "sum");
+    return bench::lua_loop(L, R"--(
+        local v = {1, 2, 'x', 4}
+        return function(n)
+            for i = 1, n do pcall(sum, v) end
+        end
+    )--");
+}
+
+LUABIND_BENCH("error/argument_count") {
+    bindProbe(L);
+    return bench::lua_loop(L, R"--(
+        local p = Probe:new()
+        return function(n)
+            for i = 1, n do pcall(p.setValue, p) end
+        end
+    )--");
+}
+
+LUABIND_BENCH("error/unknown_member") {
+    luabind::class_<Probe>(L, "Probe", luabind::class_options::sealed);
+    return bench::lua_loop(L, R"--(
+        local p = Probe:new()
+        local get = function() return p.missing end
+        return function(n)
+            for i = 1, n do pcall(get) end
+        end
+    )--");
+}
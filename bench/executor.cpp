@@ -0,0 +1,79 @@
+#include "bench.hpp"
+
+#include <luabind/executor.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <thread>
+
+// Throughput of independent scripts on an executor with 1 to hardware_concurrency workers.
+// The raw baseline runs the same jobs one after another in a single state, so the ratio shows the scaling.
+
+namespace {
+
+class Accumulator : public luabind::Object {
+public:
+    void add(int v) {
+        sum += v;
+    }
+
+public:
+    int sum = 0;
+};
+
+const char job_key = 0;
+
+void initState(lua_State* L) {
+    luaL_openlibs(L);
+    luabind::class_<Accumulator>(L, "Accumulator").function<&Accumulator::add>("add");
+    const char* script = "return function() "
+                         "  local a = Accumulator:new() "
+                         "  for i = 1, 200 do a:add(i) end "
+                         "end";
+    if (luaL_dostring(L, script) != LUA_OK) {
+        std::fprintf(stderr, "bench script failed: %s\n", lua_tostring(L, -1));
+        std::abort();
+    }
+    lua_rawsetp(L, LUA_REGISTRYINDEX, &job_key);
+}
+
+void runJob(lua_State* L) {
+    lua_rawgetp(L, LUA_REGISTRYINDEX, &job_key);
+    if (lua_pcall(L, 0, 0, 0) != LUA_OK) {
+        std::fprintf(stderr, "bench job failed: %s\n", lua_tostring(L, -1));
+        std::abort();
+    }
+}
+
+bench::operation executorCase(size_t workers) {
+    auto executor = std::make_shared<luabind::executor>(workers, &initState);
+    return [executor](size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            executor->submit(&runJob);
+        }
+        executor->wait_idle();
+    };
+}
+
+const bool registered = [] {
+    const size_t max_workers = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t workers = 1; workers <= max_workers; workers *= 2) {
+        const std::string name = "executor/throughput/" + std::to_string(workers);
+        bench::cases().push_back({name, [workers](lua_State*) { return executorCase(workers); }});
+        bench::baselines().emplace(name, [](lua_State* L) {
+            initState(L);
+            return [L](size_t n) {
+                for (size_t i = 0; i < n; ++i) {
+                    runJob(L);
+                }
+            };
+        });
+        if (workers < max_workers && workers * 2 > max_workers) {
+            workers = max_workers / 2;
+        }
+    }
+    return true;
+}();
+
+} // namespace
@@ -0,0 +1,108 @@
+#include "bench.hpp"
+
+#include <luabind/function_ref.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+
+// Calling a Lua callback from C++: through a function_ref resolved once,
+// or by looking the function up and calling it with lua_pcall every time.
+// The reference is kept by an object owned by Lua, as a host would do, so it's released before the state closes.
+
+namespace {
+
+class Host : public luabind::Object {
+public:
+    luabind::function_ref<int(int, int)> on_update;
+};
+
+void run(lua_State* L, const char* script) {
+    if (luaL_dostring(L, script) != LUA_OK) {
+        std::fprintf(stderr, "bench script failed: %s\n", lua_tostring(L, -1));
+        std::abort();
+    }
+}
+
+// Loads the callbacks and creates a Host owned by Lua.
+Host* newHost(lua_State* L) {
+    run(L, R"--(
+        function on_update(a, b) return a + b end
+        handlers = {ui = {on_update = on_update}}
+    )--");
+    luabind::class_<Host>(L, "Host");
+    run(L, "host = Host:new()");
+    lua_getglobal(L, "host");
+    Host* host = luabind::value_mirror<Host*>::from_lua(L, -1);
+    lua_pop(L, 1);
+    return host;
+}
+
+bench::operation callHost(Host* host) {
+    return [host](size_t n) {
+        int sum = 0;
+        for (size_t i = 0; i < n; ++i) {
+            sum = host->on_update(sum, 1);
+        }
+        if (sum != static_cast<int>(n)) {
+            std::abort();
+        }
+    };
+}
+
+// Calls the function found at the top of the stack after running `lookup`, which pushes `pushed` values.
+template <typename Lookup>
+bench::operation callRaw(lua_State* L, Lookup lookup, int pushed) {
+    return [L, lookup, pushed](size_t n) {
+        int sum = 0;
+        for (size_t i = 0; i < n; ++i) {
+            lookup(L);
+            lua_pushinteger(L, sum);
+            lua_pushinteger(L, 1);
+            if (lua_pcall(L, 2, 1, 0) != LUA_OK) {
+                std::fprintf(stderr, "bench call failed: %s\n", lua_tostring(L, -1));
+                std::abort();
+            }
+            sum = static_cast<int>(lua_tointeger(L, -1));
+            lua_pop(L, pushed);
+        }
+        if (sum != static_cast<int>(n)) {
+            std::abort();
+        }
+    };
+}
+
+void lookupGlobal(lua_State* L) {
+    lua_getglobal(L, "on_update");
+}
+
+void lookupNested(lua_State* L) {
+    lua_getglobal(L, "handlers");
+    lua_getfield(L, -1, "ui");
+    lua_getfield(L, -1, "on_update");
+}
+
+} // namespace
+
+LUABIND_BENCH("function_ref/call") {
+    Host* host = newHost(L);
+    host->on_update = luabind::function_ref<int(int, int)>(L, "on_update");
+    return callHost(host);
+}
+
+LUABIND_BENCH_RAW("function_ref/call") {
+    newHost(L);
+    return callRaw(L, &lookupGlobal, 1);
+}
+
+LUABIND_BENCH("function_ref/call_nested") {
+    Host* host = newHost(L);
+    lookupNested(L);
+    host->on_update = luabind::function_ref<int(int, int)>(L, -1);
+    lua_pop(L, 3);
+    return callHost(host);
+}
+
+LUABIND_BENCH_RAW("function_ref/call_nested") {
+    newHost(L);
+    return callRaw(L, &lookupNested, 3);
+}
@@ -0,0 +1,56 @@
+#include "bench.hpp"
+
+namespace {
+
+void noop() {}
+
+int add(int a, int b) {
+    return a + b;
+}
+
+int rawNoop(lua_State*) {
+    return 0;
+}
+
+int rawAdd(lua_State* L) {
+    const auto a = static_cast<int>(luaL_checkinteger(L, 1));
+    const auto b = static_cast<int>(luaL_checkinteger(L, 2));
+    lua_pushinteger(L, a + b);
+    return 1;
+}
+
+constexpr const char* call_noop = R"--(
+    local f = noop
+    return function(n)
+        for i = 1, n do f() end
+    end
+)--";
+
+constexpr const char* call_add = R"--(
+    local f = add
+    return function(n)
+        for i = 1, n do local r = f(i, 1) end
+    end
+)--";
+
+} // namespace
+
+LUABIND_BENCH("function/noop") {
+    luabind::function<&noop>(L, "noop");
+    return bench::lua_loop(L, call_noop);
+}
+
+LUABIND_BENCH_RAW("function/noop") {
+    lua_register(L, "noop", &rawNoop);
+    return bench::lua_loop(L, call_noop);
+}
+
+LUABIND_BENCH("function/add") {
+    luabind::function<&add>(L, "add");
+    return bench::lua_loop(L, call_add);
+}
+
+LUABIND_BENCH_RAW("function/add") {
+    lua_register(L, "add", &rawAdd);
+    return bench::lua_loop(L, call_add);
+}
@@ -0,0 +1,77 @@
+#include "bench.hpp"
+
+#include <string>
+
+namespace {
+
+template <int Depth>
+struct Level : Level<Depth - 1> {};
+
+template <>
+struct Level<0> : luabind::Object {
+    int value = 0;
+
+    int get() const {
+        return value;
+    }
+};
+
+template <int Depth>
+void bindLevels(lua_State* L) {
+    if constexpr (Depth == 0) {
+        luabind::class_<Level<0>>(L, "Level0")
+            .template function<&Level<0>::get>("get")
+            .template property<&Level<0>::value>("value");
+    } else {
+        bindLevels<Depth - 1>(L);
+        luabind::class_<Level<Depth>, Level<Depth - 1>>(L, "Level" + std::to_string(Depth));
+    }
+}
+
+struct RawLevel {
+    int value = 0;
+};
+
+int rawNew(lua_State* L) {
+    bench::raw::push<RawLevel>(L, "RawLevel");
+    return 1;
+}
+
+int rawGet(lua_State* L) {
+    lua_pushinteger(L, bench::raw::check<RawLevel>(L, 1, "RawLevel")->value);
+    return 1;
+}
+
+// a hand-written binding has no hierarchy to walk, the baseline is the same at any depth
+void bindRawLevel(lua_State* L, int depth) {
+    static const luaL_Reg methods[] = {{"new", &rawNew}, {"get", &rawGet}, {nullptr, nullptr}};
+    bench::raw::new_class<RawLevel>(L, "RawLevel", methods);
+    std::string name = "Level";
+    name += std::to_string(depth);
+    lua_getglobal(L, "RawLevel");
+    lua_setglobal(L, name.c_str());
+}
+
+} // namespace
+
+#define LUABIND_INHERITANCE_BENCH(depth)                                                           \
+    LUABIND_BENCH("inheritance/method/depth" #depth) {                                             \
+        bindLevels<depth>(L);                                                                      \
+        return bench::lua_loop(L, "local o = Level" #depth ":new()\n"                              \
+                                  "return function(n) for i = 1, n do local v = o:get() end end"); \
+    }                                                                                              \
+    LUABIND_BENCH_RAW("inheritance/method/depth" #depth) {                                         \
+        bindRawLevel(L, depth);                                                                    \
+        return bench::lua_loop(L, "local o = Level" #depth ":new()\n"                              \
+                                  "return function(n) for i = 1, n do local v = o:get() end end"); \
+    }                                                                                              \
+    LUABIND_BENCH("inheritance/property/depth" #depth) {                                           \
+        bindLevels<depth>(L);                                                                      \
+        return bench::lua_loop(L, "local o = Level" #depth ":new()\n"                              \
+                                  "return function(n) for i = 1, n do local v = o.value end end"); \
+    }
+
+LUABIND_INHERITANCE_BENCH(1)
+LUABIND_INHERITANCE_BENCH(2)
+LUABIND_INHERITANCE_BENCH(4)
+LUABIND_INHERITANCE_BENCH(8)
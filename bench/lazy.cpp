@@ -0,0 +1,91 @@
+#include "bench.hpp"
+
+#include <luabind/lazy.hpp>
+
+#include <string>
+#include <utility>
+
+// Creating a state with 100 classes of which a script uses 5: binding all of them with class_ chains,
+// or recording lazy binders which run on first access.
+
+namespace {
+
+constexpr size_t class_count = 100;
+
+template <size_t N>
+class Lazy : public luabind::Object {
+public:
+    int get() const {
+        return value;
+    }
+
+    void set(int v) {
+        value = v;
+    }
+
+public:
+    int value = 0;
+};
+
+template <size_t N>
+std::string className() {
+    return "Lazy" + std::to_string(N);
+}
+
+template <size_t N>
+void bindLazy(lua_State* L) {
+    luabind::class_<Lazy<N>>(L, className<N>())
+        .template function<&Lazy<N>::get>("get")
+        .template function<&Lazy<N>::set>("set")
+        .template property<&Lazy<N>::value>("value");
+}
+
+void bindAll(lua_State* L) {
+    [L]<size_t... N>(std::index_sequence<N...>) { (bindLazy<N>(L), ...); }(std::make_index_sequence<class_count> {});
+}
+
+void registerAll(lua_State* L) {
+    [L]<size_t... N>(std::index_sequence<N...>) {
+        (luabind::lazy_class<Lazy<N>>(L, className<N>().c_str(), &bindLazy<N>), ...);
+    }(std::make_index_sequence<class_count> {});
+}
+
+constexpr const char* script = "for _, c in ipairs({Lazy3, Lazy17, Lazy42, Lazy64, Lazy99}) do c:new():set(1) end";
+
+template <typename Bind>
+bench::operation newStates(Bind bind, const char* run) {
+    return [bind, run](size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            lua_State* state = luaL_newstate();
+            luaL_openlibs(state);
+            bind(state);
+            if (run != nullptr && luaL_dostring(state, run) != LUA_OK) {
+                std::fprintf(stderr, "bench script failed: %s\n", lua_tostring(state, -1));
+                std::abort();
+            }
+            lua_close(state);
+        }
+    };
+}
+
+} // namespace
+
+LUABIND_BENCH("lazy/new_state/bind_100_classes") {
+    static_cast<void>(L);
+    return newStates(&bindAll, nullptr);
+}
+
+LUABIND_BENCH("lazy/new_state/register_100_classes") {
+    static_cast<void>(L);
+    return newStates(&registerAll, nullptr);
+}
+
+LUABIND_BENCH("lazy/new_state/bind_100_classes_use_5") {
+    static_cast<void>(L);
+    return newStates(&bindAll, script);
+}
+
+LUABIND_BENCH("lazy/new_state/register_100_classes_use_5") {
+    static_cast<void>(L);
+    return newStates(&registerAll, script);
+}
@@ -0,0 +1,212 @@
+#include "bench.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <sstream>
+
+namespace {
+
+struct options {
+    const char* filter = nullptr;
+    const char* json_path = nullptr;
+    const char* thresholds_path = nullptr;
+    std::chrono::milliseconds min_time {200};
+};
+
+struct result {
+    std::string name;
+    bench::measurement luabind;
+    std::optional<bench::measurement> raw;
+    // reported by the luabind run
+    std::vector<std::pair<std::string, double>> metrics;
+
+    std::optional<double> ratio() const {
+        if (!raw || raw->ns_per_op <= 0) {
+            return std::nullopt;
+        }
+        return luabind.ns_per_op / raw->ns_per_op;
+    }
+};
+
+// Limit of one case: either ns/op (`120ns`) or times its raw baseline (`2.5x`).
+struct threshold {
+    std::string name;
+    double limit;
+    bool is_ratio;
+};
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: luabind_bench [--json <file|->] [--thresholds <file>] [--min-time <ms>] [name-filter]\n");
+}
+
+bool parse_options(int argc, char** argv, options& opts) {
+    for (int i = 1; i < argc; ++i) {
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--json") == 0 && has_value) {
+            opts.json_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--thresholds") == 0 && has_value) {
+            opts.thresholds_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--min-time") == 0 && has_value) {
+            opts.min_time = std::chrono::milliseconds(std::atol(argv[++i]));
+        } else if (argv[i][0] == '-') {
+            return false;
+        } else {
+            opts.filter = argv[i];
+        }
+    }
+    return true;
+}
+
+bench::measurement run(const bench::setup& prepare, std::chrono::milliseconds min_time) {
+    lua_State* L = luaL_newstate();
+    luaL_openlibs(L);
+    const bench::operation op = prepare(L);
+    const bench::measurement m = bench::measure(op, min_time);
+    lua_close(L);
+    return m;
+}
+
+// Case names are plain ASCII paths, no escaping is needed.
+void write_json(std::FILE* out, const std::vector<result>& results) {
+    std::fprintf(out, "[\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const result& r = results[i];
+        std::fprintf(out,
+                     "  {\"name\": \"%s\", \"iterations\": %zu, \"ns_per_op\": %.3f",
+                     r.name.c_str(),
+                     r.luabind.iterations,
+                     r.luabind.ns_per_op);
+        if (r.raw) {
+            std::fprintf(out, ", \"raw_ns_per_op\": %.3f, \"ratio\": %.3f", r.raw->ns_per_op, *r.ratio());
+        }
+        if (!r.metrics.empty()) {
+            std::fprintf(out, ", \"metrics\": {");
+            for (size_t m = 0; m < r.metrics.size(); ++m) {
+                const auto& [name, value] = r.metrics[m];
+                std::fprintf(out, "%s\"%s\": %.3f", m != 0 ? ", " : "", name.c_str(), value);
+            }
+            std::fprintf(out, "}");
+        }
+        std::fprintf(out, "}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(out, "]\n");
+}
+
+// One `<case-name> <limit>` per line, `#` starts a comment.
+std::optional<std::vector<threshold>> read_thresholds(const char* path) {
+    std::ifstream in(path);
+    if (!in) {
+        return std::nullopt;
+    }
+    std::vector<threshold> thresholds;
+    std::string line;
+    while (std::getline(in, line)) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string name;
+        std::string limit;
+        if (!(fields >> name >> limit)) {
+            continue;
+        }
+        char* end = nullptr;
+        const double value = std::strtod(limit.c_str(), &end);
+        const std::string_view unit(end);
+        if (unit != "ns" && unit != "x") {
+            std::fprintf(stderr, "invalid threshold '%s' for %s\n", limit.c_str(), name.c_str());
+            return std::nullopt;
+        }
+        thresholds.push_back({name, value, unit == "x"});
+    }
+    return thresholds;
+}
+
+int check_thresholds(const std::vector<threshold>& thresholds, const std::vector<result>& results) {
+    int failures = 0;
+    for (const threshold& t : thresholds) {
+        for (const result& r : results) {
+            if (r.name != t.name) {
+                continue;
+            }
+            const std::optional<double> value = t.is_ratio ? r.ratio() : r.luabind.ns_per_op;
+            if (!value) {
+                std::fprintf(stderr, "%s has no raw baseline for a ratio threshold\n", r.name.c_str());
+                ++failures;
+            } else if (*value > t.limit) {
+                std::fprintf(stderr,
+                             "%s regressed: %.2f%s, limit %.2f%s\n",
+                             r.name.c_str(),
+                             *value,
+                             t.is_ratio ? "x" : "ns",
+                             t.limit,
+                             t.is_ratio ? "x" : "ns");
+                ++failures;
+            }
+        }
+    }
+    return failures;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    options opts;
+    if (!parse_options(argc, argv, opts)) {
+        usage();
+        return 2;
+    }
+
+    std::vector<threshold> thresholds;
+    if (opts.thresholds_path != nullptr) {
+        auto read = read_thresholds(opts.thresholds_path);
+        if (!read) {
+            std::fprintf(stderr, "cannot read thresholds from %s\n", opts.thresholds_path);
+            return 2;
+        }
+        thresholds = std::move(*read);
+    }
+
+    // with JSON on stdout the table goes to stderr
+    const bool json_to_stdout = opts.json_path != nullptr && std::strcmp(opts.json_path, "-") == 0;
+    std::FILE* table = json_to_stdout ? stderr : stdout;
+
+    std::vector<result> results;
+    for (const bench::bench_case& c : bench::cases()) {
+        if (opts.filter != nullptr && c.name.find(opts.filter) == std::string::npos) {
+            continue;
+        }
+        bench::metrics().clear();
+        result r {c.name, run(c.prepare, opts.min_time), std::nullopt, {}};
+        r.metrics = std::move(bench::metrics());
+        std::fprintf(table,
+                     "%-48s %12zu iterations %10.2f ns/op",
+                     c.name.c_str(),
+                     r.luabind.iterations,
+                     r.luabind.ns_per_op);
+        if (auto it = bench::baselines().find(c.name); it != bench::baselines().end()) {
+            r.raw = run(it->second, opts.min_time);
+            std::fprintf(table, " %10.2f ns/op raw %6.2fx", r.raw->ns_per_op, *r.ratio());
+        }
+        std::fprintf(table, "\n");
+        for (const auto& [name, value] : r.metrics) {
+            std::fprintf(table, "    %-44s %12.3f\n", name.c_str(), value);
+        }
+        std::fflush(table);
+        results.push_back(std::move(r));
+    }
+
+    if (opts.json_path != nullptr) {
+        std::FILE* out = json_to_stdout ? stdout : std::fopen(opts.json_path, "w");
+        if (out == nullptr) {
+            std::fprintf(stderr, "cannot write %s\n", opts.json_path);
+            return 2;
+        }
+        write_json(out, results);
+        if (out != stdout) {
+            std::fclose(out);
+        }
+    }
+
+    return check_thresholds(thresholds, results) == 0 ? 0 : 1;
+}
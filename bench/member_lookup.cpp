@@ -0,0 +1,63 @@
+#include "bench.hpp"
+
+#include <string>
+
+namespace {
+
+class Wide : public luabind::Object {};
+
+int constant(lua_State* L) {
+    lua_pushinteger(L, 1);
+    return 1;
+}
+
+// binds `count` read-only properties m1..m<count>, all served by the same getter
+void bindWide(lua_State* L, int count) {
+    luabind::class_<Wide> wide(L, "Wide");
+    for (int i = 1; i <= count; ++i) {
+        std::string name = "m";
+        name += std::to_string(i);
+        wide.property_readonly<&constant>(name);
+    }
+}
+
+std::string lookupLoop(int count) {
+    // touch the first, the middle and the last member
+    std::string script = "local o = Wide:new()\nreturn function(n) for i = 1, n do local a, b, c = o.m1, o.m";
+    script += std::to_string((count + 1) / 2);
+    script += ", o.m";
+    script += std::to_string(count);
+    script += " end end";
+    return script;
+}
+
+// type_storage::find_member alone, without the cost of calling __index from Lua
+bench::operation directLookup(lua_State* L, int count) {
+    bindWide(L, count);
+    lua_pushliteral(L, "m1");
+    lua_pushfstring(L, "m%d", (count + 1) / 2);
+    lua_pushfstring(L, "m%d", count);
+    luabind::type_storage& storage = luabind::type_storage::get_instance(L);
+    luabind::type_info* info = luabind::type_storage::find_type_info<Wide>(L);
+    return [L, &storage, info](size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            const luabind::member_data* m = storage.find_member(L, info, 1 + static_cast<int>(i % 3));
+            asm volatile("" : : "r"(m));
+        }
+    };
+}
+
+} // namespace
+
+#define LUABIND_MEMBER_LOOKUP_BENCH(count)                                \
+    LUABIND_BENCH("member_lookup/" #count "_members") {                   \
+        bindWide(L, count);                                               \
+        return bench::lua_loop(L, lookupLoop(count).c_str());             \
+    }                                                                     \
+    LUABIND_BENCH("member_lookup/direct/" #count "_members") {            \
+        return directLookup(L, count);                                    \
+    }
+
+LUABIND_MEMBER_LOOKUP_BENCH(5)
+LUABIND_MEMBER_LOOKUP_BENCH(50)
+LUABIND_MEMBER_LOOKUP_BENCH(500)
@@ -0,0 +1,264 @@
+#include "bench.hpp"
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+// Conversions of every value_mirror, as an argument of a bound function (from_lua)
+// and as its result (to_lua), next to the raw Lua C API equivalent.
+
+namespace {
+
+class Node : public luabind::Object {
+public:
+    int value = 0;
+};
+
+struct RawNode {
+    int value = 0;
+};
+
+Node globalNode;
+RawNode globalRawNode;
+const std::shared_ptr<Node> sharedNode = std::make_shared<Node>();
+const std::shared_ptr<RawNode> sharedRawNode = std::make_shared<RawNode>();
+
+void bindNode(lua_State* L) {
+    luabind::class_<Node>(L, "Node").construct_shared<>("create");
+}
+
+int rawNewNode(lua_State* L) {
+    bench::raw::push<RawNode>(L, "Node");
+    return 1;
+}
+
+int rawCreateNode(lua_State* L) {
+    bench::raw::push<std::shared_ptr<RawNode>>(L, "SharedNode", std::make_shared<RawNode>());
+    return 1;
+}
+
+void bindRawNode(lua_State* L) {
+    static const luaL_Reg shared_methods[] = {{nullptr, nullptr}};
+    bench::raw::new_class<std::shared_ptr<RawNode>>(L, "SharedNode", shared_methods);
+    static const luaL_Reg methods[] = {{"new", &rawNewNode}, {"create", &rawCreateNode}, {nullptr, nullptr}};
+    bench::raw::new_class<RawNode>(L, "Node", methods);
+}
+
+// calls the global `take` with the value of `argument`
+bench::operation takeLoop(lua_State* L, const char* argument) {
+    std::string script = "local f, a = take, ";
+    script += argument;
+    script += "\nreturn function(n) for i = 1, n do f(a) end end";
+    return bench::lua_loop(L, script.c_str());
+}
+
+// calls the global `give`
+bench::operation giveLoop(lua_State* L) {
+    return bench::lua_loop(L, "local f = give\nreturn function(n) for i = 1, n do local r = f() end end");
+}
+
+void takeBool(bool) {}
+void takeInt(int) {}
+void takeDouble(double) {}
+void takeString(std::string) {}
+void takeStringView(std::string_view) {}
+void takePair(std::pair<int, int>) {}
+void takePointer(Node*) {}
+void takeReference(const Node&) {}
+void takeShared(std::shared_ptr<Node>) {}
+void takeSharedRef(const std::shared_ptr<Node>&) {}
+
+bool giveBool() {
+    return true;
+}
+
+int giveInt() {
+    return 1;
+}
+
+double giveDouble() {
+    return 1.5;
+}
+
+std::string giveString() {
+    return "value";
+}
+
+std::string_view giveStringView() {
+    return "value";
+}
+
+std::pair<int, int> givePair() {
+    return {1, 2};
+}
+
+Node* givePointer() {
+    return &globalNode;
+}
+
+Node giveValue() {
+    return Node {};
+}
+
+std::shared_ptr<Node> giveShared() {
+    return sharedNode;
+}
+
+int rawTakeBool(lua_State* L) {
+    luaL_checktype(L, 1, LUA_TBOOLEAN);
+    static_cast<void>(lua_toboolean(L, 1));
+    return 0;
+}
+
+int rawTakeInt(lua_State* L) {
+    static_cast<void>(luaL_checkinteger(L, 1));
+    return 0;
+}
+
+int rawTakeDouble(lua_State* L) {
+    static_cast<void>(luaL_checknumber(L, 1));
+    return 0;
+}
+
+int rawTakeString(lua_State* L) {
+    size_t length;
+    const char* s = luaL_checklstring(L, 1, &length);
+    std::string copy(s, length);
+    return 0;
+}
+
+int rawTakeStringView(lua_State* L) {
+    size_t length;
+    static_cast<void>(luaL_checklstring(L, 1, &length));
+    return 0;
+}
+
+int rawTakePair(lua_State* L) {
+    luaL_checktype(L, 1, LUA_TTABLE);
+    lua_rawgeti(L, 1, 1);
+    lua_rawgeti(L, 1, 2);
+    static_cast<void>(luaL_checkinteger(L, -2));
+    static_cast<void>(luaL_checkinteger(L, -1));
+    lua_pop(L, 2);
+    return 0;
+}
+
+int rawTakePointer(lua_State* L) {
+    static_cast<void>(bench::raw::check<RawNode>(L, 1, "Node"));
+    return 0;
+}
+
+int rawTakeShared(lua_State* L) {
+    std::shared_ptr<RawNode> copy = *bench::raw::check<std::shared_ptr<RawNode>>(L, 1, "SharedNode");
+    return 0;
+}
+
+int rawTakeSharedRef(lua_State* L) {
+    static_cast<void>(bench::raw::check<std::shared_ptr<RawNode>>(L, 1, "SharedNode"));
+    return 0;
+}
+
+int rawGiveBool(lua_State* L) {
+    lua_pushboolean(L, 1);
+    return 1;
+}
+
+int rawGiveInt(lua_State* L) {
+    lua_pushinteger(L, 1);
+    return 1;
+}
+
+int rawGiveDouble(lua_State* L) {
+    lua_pushnumber(L, 1.5);
+    return 1;
+}
+
+int rawGiveString(lua_State* L) {
+    const std::string s = "value";
+    lua_pushlstring(L, s.data(), s.size());
+    return 1;
+}
+
+int rawGiveStringView(lua_State* L) {
+    lua_pushliteral(L, "value");
+    return 1;
+}
+
+int rawGivePair(lua_State* L) {
+    lua_createtable(L, 2, 0);
+    lua_pushinteger(L, 1);
+    lua_rawseti(L, -2, 1);
+    lua_pushinteger(L, 2);
+    lua_rawseti(L, -2, 2);
+    return 1;
+}
+
+// a non-owning userdata holding the pointer
+int rawGivePointer(lua_State* L) {
+    bench::raw::push<RawNode*>(L, "NodePointer", &globalRawNode);
+    return 1;
+}
+
+int rawGiveValue(lua_State* L) {
+    bench::raw::push<RawNode>(L, "Node");
+    return 1;
+}
+
+int rawGiveShared(lua_State* L) {
+    bench::raw::push<std::shared_ptr<RawNode>>(L, "SharedNode", sharedRawNode);
+    return 1;
+}
+
+void bindRawPointer(lua_State* L) {
+    static const luaL_Reg methods[] = {{nullptr, nullptr}};
+    bench::raw::new_class<RawNode*>(L, "NodePointer", methods);
+}
+
+} // namespace
+
+#define LUABIND_MIRROR_BENCH(name, argument, take, raw_take)         \
+    LUABIND_BENCH("mirror/" name "/from_lua") {                      \
+        bindNode(L);                                                 \
+        luabind::function<take>(L, "take");                          \
+        return takeLoop(L, argument);                                \
+    }                                                                \
+    LUABIND_BENCH_RAW("mirror/" name "/from_lua") {                  \
+        bindRawNode(L);                                              \
+        lua_register(L, "take", raw_take);                           \
+        return takeLoop(L, argument);                                \
+    }
+
+#define LUABIND_MIRROR_BENCH_RESULT(name, give, raw_give)            \
+    LUABIND_BENCH("mirror/" name "/to_lua") {                        \
+        bindNode(L);                                                 \
+        luabind::function<give>(L, "give");                          \
+        return giveLoop(L);                                          \
+    }                                                                \
+    LUABIND_BENCH_RAW("mirror/" name "/to_lua") {                    \
+        bindRawNode(L);                                              \
+        bindRawPointer(L);                                           \
+        lua_register(L, "give", raw_give);                           \
+        return giveLoop(L);                                          \
+    }
+
+LUABIND_MIRROR_BENCH("bool", "true", &takeBool, &rawTakeBool)
+LUABIND_MIRROR_BENCH("int", "1", &takeInt, &rawTakeInt)
+LUABIND_MIRROR_BENCH("double", "1.5", &takeDouble, &rawTakeDouble)
+LUABIND_MIRROR_BENCH("string", "'value'", &takeString, &rawTakeString)
+LUABIND_MIRROR_BENCH("string_view", "'value'", &takeStringView, &rawTakeStringView)
+LUABIND_MIRROR_BENCH("pair", "{1, 2}", &takePair, &rawTakePair)
+LUABIND_MIRROR_BENCH("pointer", "Node:new()", &takePointer, &rawTakePointer)
+LUABIND_MIRROR_BENCH("reference", "Node:new()", &takeReference, &rawTakePointer)
+LUABIND_MIRROR_BENCH("shared_ptr", "Node:create()", &takeShared, &rawTakeShared)
+LUABIND_MIRROR_BENCH("shared_ptr_ref", "Node:create()", &takeSharedRef, &rawTakeSharedRef)
+
+LUABIND_MIRROR_BENCH_RESULT("bool", &giveBool, &rawGiveBool)
+LUABIND_MIRROR_BENCH_RESULT("int", &giveInt, &rawGiveInt)
+LUABIND_MIRROR_BENCH_RESULT("double", &giveDouble, &rawGiveDouble)
+LUABIND_MIRROR_BENCH_RESULT("string", &giveString, &rawGiveString)
+LUABIND_MIRROR_BENCH_RESULT("string_view", &giveStringView, &rawGiveStringView)
+LUABIND_MIRROR_BENCH_RESULT("pair", &givePair, &rawGivePair)
+LUABIND_MIRROR_BENCH_RESULT("pointer", &givePointer, &rawGivePointer)
+LUABIND_MIRROR_BENCH_RESULT("value", &giveValue, &rawGiveValue)
+LUABIND_MIRROR_BENCH_RESULT("shared_ptr", &giveShared, &rawGiveShared)
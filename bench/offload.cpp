@@ -0,0 +1,113 @@
+#include "bench.hpp"
+
+#include <luabind/offload.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+
+// Overhead of an offloaded call: a Lua coroutine calling a bound function run by the pool, and a loop polling
+// the results, against a C function yielding with lua_yield and a loop resuming with lua_resume.
+// The pool runs jobs as they are submitted, so no thread switch is measured. 1000 coroutines wait at the same time.
+
+namespace {
+
+constexpr int coroutine_count = 1000;
+
+class inline_pool : public luabind::offload_pool {
+public:
+    void submit(job j) override {
+        j();
+    }
+};
+
+int increment(int v) {
+    return v + 1;
+}
+
+int rawIncrement(lua_State* L) {
+    return lua_yieldk(L, 0, 0, [](lua_State* L, int, lua_KContext) -> int {
+        lua_pushinteger(L, luaL_checkinteger(L, 1) + 1);
+        return 1;
+    });
+}
+
+// Starts the coroutines, each of them making `n` calls.
+void start(lua_State* L, size_t n) {
+    lua_getglobal(L, "start");
+    lua_pushinteger(L, coroutine_count);
+    lua_pushinteger(L, static_cast<lua_Integer>(n / coroutine_count + 1));
+    if (lua_pcall(L, 2, 0, 0) != LUA_OK) {
+        std::fprintf(stderr, "bench script failed: %s\n", lua_tostring(L, -1));
+        std::abort();
+    }
+}
+
+constexpr const char* script = R"--(
+    threads = {}
+    function start(count, n)
+        for i = 1, count do
+            local co = coroutine.create(function()
+                local v = 0
+                for _ = 1, n do v = increment(v) end
+            end)
+            threads[i] = co
+            assert(coroutine.resume(co))
+        end
+    end
+)--";
+
+// The queue lives as long as the state, it's released by a finalizer closing it first.
+luabind::offload_queue* newQueue(lua_State* L) {
+    static inline_pool pool;
+    using holder = std::unique_ptr<luabind::offload_queue>;
+    auto* h = static_cast<holder*>(lua_newuserdatauv(L, sizeof(holder), 0));
+    new (h) holder(std::make_unique<luabind::offload_queue>(L, pool));
+    lua_createtable(L, 0, 1);
+    lua_pushcfunction(L, [](lua_State* L) -> int {
+        static_cast<holder*>(lua_touserdata(L, 1))->~holder();
+        return 0;
+    });
+    lua_setfield(L, -2, "__gc");
+    lua_setmetatable(L, -2);
+    luaL_ref(L, LUA_REGISTRYINDEX);
+    return h->get();
+}
+
+} // namespace
+
+LUABIND_BENCH("offload/call") {
+    luabind::offload_queue* queue = newQueue(L);
+    luabind::function<luabind::offload<&increment>>(L, "increment");
+    luaL_dostring(L, script);
+    return [L, queue](size_t n) {
+        start(L, n);
+        while (queue->poll() != 0) {
+        }
+    };
+}
+
+LUABIND_BENCH_RAW("offload/call") {
+    lua_register(L, "increment", &rawIncrement);
+    luaL_dostring(L, script);
+    return [L](size_t n) {
+        start(L, n);
+        for (bool waiting = true; waiting;) {
+            waiting = false;
+            lua_getglobal(L, "threads");
+            for (int i = 1; i <= coroutine_count; ++i) {
+                lua_rawgeti(L, -1, i);
+                lua_State* co = lua_tothread(L, -1);
+                if (lua_status(co) == LUA_YIELD) {
+                    int results = 0;
+                    lua_resume(co, L, 0, &results);
+                    lua_pop(co, results);
+                    waiting = true;
+                }
+                lua_pop(L, 1);
+            }
+            lua_pop(L, 1);
+        }
+    };
+}
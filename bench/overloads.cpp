@@ -0,0 +1,133 @@
+#include "bench.hpp"
+
+namespace {
+
+class Vec : public luabind::Object {
+public:
+    Vec(int x, int y)
+        : x(x)
+        , y(y) {}
+
+public:
+    int x;
+    int y;
+};
+
+class Sprite : public luabind::Object {
+public:
+    void setPos(int px, int py) {
+        x = px;
+        y = py;
+    }
+
+    void setPos(const Vec& v) {
+        x = v.x;
+        y = v.y;
+    }
+
+    void setPos(int px, int py, int pz) {
+        x = px;
+        y = py;
+        z = pz;
+    }
+
+    void set(int v) {
+        x = v;
+    }
+
+    void set(double v) {
+        y = static_cast<int>(v);
+    }
+
+    void set(bool v) {
+        z = v ? 1 : 0;
+    }
+
+public:
+    int x = 0;
+    int y = 0;
+    int z = 0;
+};
+
+void bindSingle(lua_State* L) {
+    luabind::class_<Vec>(L, "Vec").constructor<int, int>("new");
+    luabind::class_<Sprite>(L, "Sprite")
+        .function<static_cast<void (Sprite::*)(int, int)>(&Sprite::setPos)>("setPos")
+        .function<static_cast<void (Sprite::*)(const Vec&)>(&Sprite::setPos)>("setPosVec")
+        .function<static_cast<void (Sprite::*)(bool)>(&Sprite::set)>("set");
+}
+
+void bindOverloaded(lua_State* L) {
+    luabind::class_<Vec>(L, "Vec").constructor<int, int>("new");
+    luabind::class_<Sprite>(L, "Sprite")
+        .function<static_cast<void (Sprite::*)(int, int)>(&Sprite::setPos),
+                  static_cast<void (Sprite::*)(const Vec&)>(&Sprite::setPos),
+                  static_cast<void (Sprite::*)(int, int, int)>(&Sprite::setPos)>("setPos")
+        .function<static_cast<void (Sprite::*)(int)>(&Sprite::set),
+                  static_cast<void (Sprite::*)(double)>(&Sprite::set),
+                  static_cast<void (Sprite::*)(bool)>(&Sprite::set)>("set");
+    // the same name for the single signature script
+    luabind::class_<Sprite>(L, "Sprite").function<static_cast<void (Sprite::*)(const Vec&)>(&Sprite::setPos)>(
+        "setPosVec");
+}
+
+constexpr const char* set_pos = R"--(
+    local s = Sprite:new()
+    return function(n)
+        for i = 1, n do s:setPos(i, 2) end
+    end
+)--";
+
+constexpr const char* set_pos_vec_single = R"--(
+    local s, v = Sprite:new(), Vec:new(1, 2)
+    return function(n)
+        for i = 1, n do s:setPosVec(v) end
+    end
+)--";
+
+constexpr const char* set_pos_vec = R"--(
+    local s, v = Sprite:new(), Vec:new(1, 2)
+    return function(n)
+        for i = 1, n do s:setPos(v) end
+    end
+)--";
+
+// the last of three candidates with the same arity
+constexpr const char* set_bool = R"--(
+    local s = Sprite:new()
+    return function(n)
+        for i = 1, n do s:set(true) end
+    end
+)--";
+
+} // namespace
+
+LUABIND_BENCH("overload/single/by_arity") {
+    bindSingle(L);
+    return bench::lua_loop(L, set_pos);
+}
+
+LUABIND_BENCH("overload/overloaded/by_arity") {
+    bindOverloaded(L);
+    return bench::lua_loop(L, set_pos);
+}
+
+LUABIND_BENCH("overload/single/userdata") {
+    bindSingle(L);
+    return bench::lua_loop(L, set_pos_vec_single);
+}
+
+LUABIND_BENCH("overload/overloaded/userdata") {
+    bindOverloaded(L);
+    return bench::lua_loop(L, set_pos_vec);
+}
+
+LUABIND_BENCH("overload/single/by_type") {
+    bindSingle(L);
+    return bench::lua_loop(L, set_bool);
+}
+
+LUABIND_BENCH("overload/overloaded/by_type") {
+    bindOverloaded(L);
+    return bench::lua_loop(L, set_bool);
+}
@@ -0,0 +1,165 @@
+#include "bench.hpp"
+
+#include <cstring>
+
+namespace {
+
+class Account : public luabind::Object {
+public:
+    int getBalance() const {
+        return balance;
+    }
+
+    void setBalance(int b) {
+        balance = b;
+    }
+
+public:
+    int balance = 0;
+};
+
+void bindAccount(lua_State* L, luabind::class_options options = luabind::class_options::none) {
+    luabind::class_<Account>(L, "Account", options)
+        .function<&Account::getBalance>("getBalance")
+        .function<&Account::setBalance>("setBalance")
+        .property<&Account::balance>("balance");
+}
+
+// Raw Lua C API version of Account, usable from the same scripts.
+struct RawAccount {
+    int balance = 0;
+};
+
+int rawNew(lua_State* L) {
+    bench::raw::push<RawAccount>(L, "Account");
+    return 1;
+}
+
+int rawGetBalance(lua_State* L) {
+    lua_pushinteger(L, bench::raw::check<RawAccount>(L, 1, "Account")->balance);
+    return 1;
+}
+
+int rawSetBalance(lua_State* L) {
+    bench::raw::check<RawAccount>(L, 1, "Account")->balance = static_cast<int>(luaL_checkinteger(L, 2));
+    return 0;
+}
+
+// __index with the methods table as upvalue, the property is checked first as in a bound class
+int rawIndex(lua_State* L) {
+    RawAccount* a = bench::raw::check<RawAccount>(L, 1, "Account");
+    if (std::strcmp(luaL_checkstring(L, 2), "balance") == 0) {
+        lua_pushinteger(L, a->balance);
+        return 1;
+    }
+    lua_pushvalue(L, 2);
+    lua_rawget(L, lua_upvalueindex(1));
+    return 1;
+}
+
+int rawNewIndex(lua_State* L) {
+    RawAccount* a = bench::raw::check<RawAccount>(L, 1, "Account");
+    if (std::strcmp(luaL_checkstring(L, 2), "balance") != 0) {
+        return luaL_error(L, "no member %s", lua_tostring(L, 2));
+    }
+    a->balance = static_cast<int>(luaL_checkinteger(L, 3));
+    return 0;
+}
+
+void bindRawAccount(lua_State* L) {
+    static const luaL_Reg methods[] = {
+        {"new", &rawNew}, {"getBalance", &rawGetBalance}, {"setBalance", &rawSetBalance}, {nullptr, nullptr}};
+    bench::raw::new_class<RawAccount>(L, "Account", methods);
+    luaL_getmetatable(L, "Account");
+    lua_getglobal(L, "Account");
+    lua_pushcclosure(L, &rawIndex, 1);
+    lua_setfield(L, -2, "__index");
+    lua_pushcfunction(L, &rawNewIndex);
+    lua_setfield(L, -2, "__newindex");
+    lua_pop(L, 1);
+}
+
+constexpr const char* property_get = R"--(
+    local a = Account:new()
+    return function(n)
+        for i = 1, n do local b = a.balance end
+    end
+)--";
+
+constexpr const char* property_set = R"--(
+    local a = Account:new()
+    return function(n)
+        for i = 1, n do a.balance = i end
+    end
+)--";
+
+constexpr const char* method_getter = R"--(
+    local a = Account:new()
+    return function(n)
+        for i = 1, n do local b = a:getBalance() end
+    end
+)--";
+
+constexpr const char* method_setter = R"--(
+    local a = Account:new()
+    return function(n)
+        for i = 1, n do a:setBalance(i) end
+    end
+)--";
+
+} // namespace
+
+LUABIND_BENCH("property/get") {
+    bindAccount(L);
+    return bench::lua_loop(L, property_get);
+}
+
+LUABIND_BENCH_RAW("property/get") {
+    bindRawAccount(L);
+    return bench::lua_loop(L, property_get);
+}
+
+LUABIND_BENCH("property/set") {
+    bindAccount(L);
+    return bench::lua_loop(L, property_set);
+}
+
+LUABIND_BENCH_RAW("property/set") {
+    bindRawAccount(L);
+    return bench::lua_loop(L, property_set);
+}
+
+LUABIND_BENCH("method/getter") {
+    bindAccount(L);
+    return bench::lua_loop(L, method_getter);
+}
+
+LUABIND_BENCH_RAW("method/getter") {
+    bindRawAccount(L);
+    return bench::lua_loop(L, method_getter);
+}
+
+LUABIND_BENCH("method/setter") {
+    bindAccount(L);
+    return bench::lua_loop(L, method_setter);
+}
+
+LUABIND_BENCH_RAW("method/setter") {
+    bindRawAccount(L);
+    return bench::lua_loop(L, method_setter);
+}
+
+LUABIND_BENCH("method_table/property/get") {
+    bindAccount(L, luabind::class_options::method_table);
+    return bench::lua_loop(L, property_get);
+}
+
+LUABIND_BENCH("method_table/method/getter") {
+    bindAccount(L, luabind::class_options::method_table);
+    return bench::lua_loop(L, method_getter);
+}
+
+LUABIND_BENCH("method_table/method/setter") {
+    bindAccount(L, luabind::class_options::method_table);
+    return bench::lua_loop(L, method_setter);
+}
@@ -0,0 +1,185 @@
+#include "bench.hpp"
+
+#include <luabind/scheduler.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <new>
+#include <queue>
+#include <vector>
+
+// 100k coroutines sleeping in a loop. scheduler/sleep measures one wakeup: the timer wheel, the ready queue and
+// the resume, with a manual clock moved by a tick at a time. The baseline keeps the due times in a binary heap and
+// resumes with lua_resume. scheduler/wakeup_latency sleeps 0.1-1 s on the real clock and reports how late the
+// coroutines wake up, as seen by Lua.
+
+namespace {
+
+using namespace std::chrono_literals;
+
+constexpr int coroutine_count = 100000;
+
+std::chrono::steady_clock::time_point manual_now;
+
+// The scheduler lives as long as the state, it's released by a finalizer closing it first.
+luabind::scheduler* newScheduler(lua_State* L, luabind::scheduler_options options) {
+    using holder = std::unique_ptr<luabind::scheduler>;
+    auto* h = static_cast<holder*>(lua_newuserdatauv(L, sizeof(holder), 0));
+    new (h) holder(std::make_unique<luabind::scheduler>(L, std::move(options)));
+    lua_createtable(L, 0, 1);
+    lua_pushcfunction(L, [](lua_State* L) -> int {
+        static_cast<holder*>(lua_touserdata(L, 1))->~holder();
+        return 0;
+    });
+    lua_setfield(L, -2, "__gc");
+    lua_setmetatable(L, -2);
+    luaL_ref(L, LUA_REGISTRYINDEX);
+    return h->get();
+}
+
+void load(lua_State* L, const char* script) {
+    if (luaL_dostring(L, script) != LUA_OK) {
+        std::fprintf(stderr, "bench script failed: %s\n", lua_tostring(L, -1));
+        std::abort();
+    }
+}
+
+// sleep(d) for 1-100 ms
+constexpr const char* sleep_script = R"--(
+    function sleeper(i)
+        local d = (i % 100 + 1) / 1000
+        while true do sleep(d) end
+    end
+)--";
+
+int rawSleep(lua_State* L) {
+    luaL_checknumber(L, 1);
+    return lua_yield(L, 1);
+}
+
+struct raw_sleeper {
+    uint64_t due;
+    lua_State* thread;
+
+    bool operator>(const raw_sleeper& other) const {
+        return due > other.due;
+    }
+};
+
+struct raw_loop {
+    std::priority_queue<raw_sleeper, std::vector<raw_sleeper>, std::greater<>> sleeping;
+    uint64_t tick = 0;
+
+    // Resumes the coroutine and queues it for the time it yielded.
+    void resume(lua_State* L, lua_State* co, int nargs) {
+        int results = 0;
+        if (lua_resume(co, L, nargs, &results) != LUA_YIELD) {
+            std::fprintf(stderr, "bench coroutine failed: %s\n", lua_tostring(co, -1));
+            std::abort();
+        }
+        const auto ticks = static_cast<uint64_t>(std::ceil(lua_tonumber(co, -1) * 1000));
+        lua_pop(co, results);
+        sleeping.push({tick + ticks, co});
+    }
+};
+
+// now() - due of every wakeup of the current run, in seconds
+std::vector<double> latencies;
+
+void record(double latency) {
+    latencies.push_back(latency);
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+    const auto i = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1));
+    return sorted[i];
+}
+
+} // namespace
+
+LUABIND_BENCH("scheduler/sleep") {
+    manual_now = {};
+    luabind::scheduler_options options;
+    options.budget = coroutine_count;
+    options.now = [] { return manual_now; };
+    luabind::scheduler* s = newScheduler(L, std::move(options));
+    load(L, "sleep = scheduler.sleep");
+    load(L, sleep_script);
+    for (int i = 1; i <= coroutine_count; ++i) {
+        lua_getglobal(L, "sleeper");
+        lua_pushinteger(L, i);
+        s->spawn(L, 1);
+    }
+    s->run_once();
+    return [s](size_t n) {
+        const size_t target = s->get_stats().resumed + n;
+        while (s->get_stats().resumed < target) {
+            manual_now += 1ms;
+            s->run_once();
+        }
+    };
+}
+
+LUABIND_BENCH_RAW("scheduler/sleep") {
+    lua_register(L, "sleep", &rawSleep);
+    load(L, sleep_script);
+    auto loop = std::make_shared<raw_loop>();
+    lua_createtable(L, coroutine_count, 0);
+    for (int i = 1; i <= coroutine_count; ++i) {
+        lua_State* co = lua_newthread(L);
+        lua_rawseti(L, -2, i);
+        lua_getglobal(co, "sleeper");
+        lua_pushinteger(co, i);
+        loop->resume(L, co, 1);
+    }
+    luaL_ref(L, LUA_REGISTRYINDEX);
+    return [L, loop](size_t n) {
+        for (size_t resumed = 0; resumed < n;) {
+            ++loop->tick;
+            while (!loop->sleeping.empty() && loop->sleeping.top().due <= loop->tick) {
+                lua_State* co = loop->sleeping.top().thread;
+                loop->sleeping.pop();
+                loop->resume(L, co, 0);
+                ++resumed;
+            }
+        }
+    };
+}
+
+LUABIND_BENCH("scheduler/wakeup_latency") {
+    luabind::scheduler_options options;
+    options.budget = coroutine_count;
+    luabind::scheduler* s = newScheduler(L, std::move(options));
+    luabind::function<&record>(L, "record");
+    load(L, R"--(
+        function sleeper(i)
+            local now, sleep, record = scheduler.now, scheduler.sleep, record
+            local d = 0.1 + (i % 1000) * 0.0009
+            while true do
+                local due = now() + d
+                sleep(d)
+                record(now() - due)
+            end
+        end
+    )--");
+    for (int i = 1; i <= coroutine_count; ++i) {
+        lua_getglobal(L, "sleeper");
+        lua_pushinteger(L, i);
+        s->spawn(L, 1);
+    }
+    s->run_once();
+    return [s](size_t n) {
+        latencies.clear();
+        while (latencies.size() < n) {
+            s->run_once(true);
+        }
+        std::sort(latencies.begin(), latencies.end());
+        bench::report("p50_us", percentile(latencies, 0.5) * 1e6);
+        bench::report("p99_us", percentile(latencies, 0.99) * 1e6);
+        bench::report("p99.9_us", percentile(latencies, 0.999) * 1e6);
+    };
+}
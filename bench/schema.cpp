@@ -0,0 +1,65 @@
+#include "bench.hpp"
+
+#include <string>
+#include <utility>
+
+// Creating a state with 100 bound classes: running the class_ chains in every state,
+// or attaching a schema captured once.
+
+namespace {
+
+constexpr size_t class_count = 100;
+
+template <size_t N>
+class Generated : public luabind::Object {
+public:
+    int get() const {
+        return value;
+    }
+
+    void set(int v) {
+        value = v;
+    }
+
+public:
+    int value = 0;
+};
+
+template <size_t N>
+void bindGenerated(lua_State* L) {
+    std::string name = "Generated";
+    name += std::to_string(N);
+    luabind::class_<Generated<N>>(L, name)
+        .template function<&Generated<N>::get>("get")
+        .template function<&Generated<N>::set>("set")
+        .template property<&Generated<N>::value>("value");
+}
+
+void bindAll(lua_State* L) {
+    [L]<size_t... N>(std::index_sequence<N...>) { (bindGenerated<N>(L), ...); }(std::make_index_sequence<class_count> {});
+}
+
+} // namespace
+
+LUABIND_BENCH("schema/new_state/bind_100_classes") {
+    static_cast<void>(L);
+    return [](size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            lua_State* state = luaL_newstate();
+            bindAll(state);
+            lua_close(state);
+        }
+    };
+}
+
+LUABIND_BENCH("schema/new_state/attach_100_classes") {
+    bindAll(L);
+    std::shared_ptr<const luabind::schema> schema = luabind::schema::capture(L);
+    return [schema](size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            lua_State* state = luaL_newstate();
+            luabind::schema::attach(state, schema);
+            lua_close(state);
+        }
+    };
+}
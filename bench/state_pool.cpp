@@ -0,0 +1,54 @@
+#include "bench.hpp"
+
+#include <luabind/state_pool.hpp>
+
+#include <memory>
+
+// Running a short script in a ready state: taken from a state_pool, or created and bound for the script.
+
+namespace {
+
+class Request : public luabind::Object {
+public:
+    int id = 0;
+};
+
+void initState(lua_State* L) {
+    luaL_openlibs(L);
+    luabind::class_<Request>(L, "Request").property<&Request::id>("id");
+}
+
+constexpr const char* script = "local r = Request:new() r.id = 1 result = r.id";
+
+void runScript(lua_State* L) {
+    if (luaL_dostring(L, script) != LUA_OK) {
+        std::fprintf(stderr, "bench script failed: %s\n", lua_tostring(L, -1));
+        std::abort();
+    }
+}
+
+} // namespace
+
+LUABIND_BENCH("state_pool/run_script") {
+    static_cast<void>(L);
+    auto pool = std::make_shared<luabind::state_pool>(&initState, 1);
+    pool->warm_up(1);
+    return [pool](size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            auto state = pool->acquire();
+            runScript(state);
+        }
+    };
+}
+
+LUABIND_BENCH_RAW("state_pool/run_script") {
+    static_cast<void>(L);
+    return [](size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            lua_State* state = luaL_newstate();
+            initState(state);
+            runScript(state);
+            lua_close(state);
+        }
+    };
+}
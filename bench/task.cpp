@@ -0,0 +1,109 @@
+#include "bench.hpp"
+
+#include <luabind/task.hpp>
+
+#include <coroutine>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+// A Lua coroutine calling a bound function whose task suspends until the next tick, and a loop
+// firing the ticks, against a C function yielding with lua_yield and a loop resuming with lua_resume.
+// 1000 coroutines wait at the same time.
+
+namespace {
+
+constexpr int coroutine_count = 1000;
+
+struct event {
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+        waiters.push_back(handle);
+    }
+
+    void await_resume() const noexcept {}
+
+    std::vector<std::coroutine_handle<>> waiters;
+};
+
+event tick;
+
+luabind::task<int> nextTick(int v) {
+    co_await tick;
+    co_return v + 1;
+}
+
+int rawNextTick(lua_State* L) {
+    return lua_yieldk(L, 0, 0, [](lua_State* L, int, lua_KContext) -> int {
+        lua_pushinteger(L, luaL_checkinteger(L, 1) + 1);
+        return 1;
+    });
+}
+
+// Starts the coroutines, each of them waiting `n` ticks.
+void start(lua_State* L, size_t n) {
+    lua_getglobal(L, "start");
+    lua_pushinteger(L, coroutine_count);
+    lua_pushinteger(L, static_cast<lua_Integer>(n / coroutine_count + 1));
+    if (lua_pcall(L, 2, 0, 0) != LUA_OK) {
+        std::fprintf(stderr, "bench script failed: %s\n", lua_tostring(L, -1));
+        std::abort();
+    }
+}
+
+constexpr const char* script = R"--(
+    threads = {}
+    function start(count, n)
+        for i = 1, count do
+            local co = coroutine.create(function()
+                local v = 0
+                for _ = 1, n do v = next_tick(v) end
+            end)
+            threads[i] = co
+            assert(coroutine.resume(co))
+        end
+    end
+)--";
+
+} // namespace
+
+LUABIND_BENCH("task/await") {
+    luabind::function<&nextTick>(L, "next_tick");
+    luaL_dostring(L, script);
+    return [L](size_t n) {
+        start(L, n);
+        while (!tick.waiters.empty()) {
+            for (std::coroutine_handle<> handle : std::exchange(tick.waiters, {})) {
+                handle.resume();
+            }
+        }
+    };
+}
+
+LUABIND_BENCH_RAW("task/await") {
+    lua_register(L, "next_tick", &rawNextTick);
+    luaL_dostring(L, script);
+    return [L](size_t n) {
+        start(L, n);
+        for (bool waiting = true; waiting;) {
+            waiting = false;
+            lua_getglobal(L, "threads");
+            for (int i = 1; i <= coroutine_count; ++i) {
+                lua_rawgeti(L, -1, i);
+                lua_State* co = lua_tothread(L, -1);
+                if (lua_status(co) == LUA_YIELD) {
+                    int results = 0;
+                    lua_resume(co, L, 0, &results);
+                    lua_pop(co, results);
+                    waiting = true;
+                }
+                lua_pop(L, 1);
+            }
+            lua_pop(L, 1);
+        }
+    };
+}
@@ -0,0 +1,76 @@
+#include "bench.hpp"
+
+// Access to data members of a class with 2000 bound int fields, f000 to f1999.
+// Data member properties share generic accessors, so the binding code does not grow per field.
+
+namespace {
+
+#define WIDE_FIELDS_10(X, p) X(p##0) X(p##1) X(p##2) X(p##3) X(p##4) X(p##5) X(p##6) X(p##7) X(p##8) X(p##9)
+#define WIDE_FIELDS_100(X, p)                                                                                          \
+    WIDE_FIELDS_10(X, p##0)                                                                                            \
+    WIDE_FIELDS_10(X, p##1)                                                                                            \
+    WIDE_FIELDS_10(X, p##2)                                                                                            \
+    WIDE_FIELDS_10(X, p##3)                                                                                            \
+    WIDE_FIELDS_10(X, p##4)                                                                                            \
+    WIDE_FIELDS_10(X, p##5)                                                                                            \
+    WIDE_FIELDS_10(X, p##6)                                                                                            \
+    WIDE_FIELDS_10(X, p##7)                                                                                            \
+    WIDE_FIELDS_10(X, p##8)                                                                                            \
+    WIDE_FIELDS_10(X, p##9)
+#define WIDE_FIELDS_2000(X)                                                                                            \
+    WIDE_FIELDS_100(X, 0)                                                                                              \
+    WIDE_FIELDS_100(X, 1)                                                                                              \
+    WIDE_FIELDS_100(X, 2)                                                                                              \
+    WIDE_FIELDS_100(X, 3)                                                                                              \
+    WIDE_FIELDS_100(X, 4)                                                                                              \
+    WIDE_FIELDS_100(X, 5)                                                                                              \
+    WIDE_FIELDS_100(X, 6)                                                                                              \
+    WIDE_FIELDS_100(X, 7)                                                                                              \
+    WIDE_FIELDS_100(X, 8)                                                                                              \
+    WIDE_FIELDS_100(X, 9)                                                                                              \
+    WIDE_FIELDS_100(X, 10)                                                                                             \
+    WIDE_FIELDS_100(X, 11)                                                                                             \
+    WIDE_FIELDS_100(X, 12)                                                                                             \
+    WIDE_FIELDS_100(X, 13)                                                                                             \
+    WIDE_FIELDS_100(X, 14)                                                                                             \
+    WIDE_FIELDS_100(X, 15)                                                                                             \
+    WIDE_FIELDS_100(X, 16)                                                                                             \
+    WIDE_FIELDS_100(X, 17)                                                                                             \
+    WIDE_FIELDS_100(X, 18)                                                                                             \
+    WIDE_FIELDS_100(X, 19)
+
+#define WIDE_DECLARE(n) int f##n = 0;
+#define WIDE_BIND(n) c.property<&Wide::f##n>("f" #n);
+
+class Wide : public luabind::Object {
+public:
+    WIDE_FIELDS_2000(WIDE_DECLARE)
+};
+
+void bindWide(lua_State* L) {
+    luabind::class_<Wide> c(L, "Wide");
+    WIDE_FIELDS_2000(WIDE_BIND)
+}
+
+} // namespace
+
+LUABIND_BENCH("wide_fields/get") {
+    bindWide(L);
+    return bench::lua_loop(L, R"--(
+        local w = Wide:new()
+        return function(n)
+            local x
+            for i = 1, n do x = w.f1500 end
+        end
+    )--");
+}
+
+LUABIND_BENCH("wide_fields/set") {
+    bindWide(L);
+    return bench::lua_loop(L, R"--(
+        local w = Wide:new()
+        return function(n)
+            for i = 1, n do w.f1500 = i end
+        end
+    )--");
+}
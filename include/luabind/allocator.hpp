@@ -0,0 +1,235 @@
+#ifndef LUABIND_ALLOCATOR_HPP
+#define LUABIND_ALLOCATOR_HPP
+
+#include "lua.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace luabind {
+
+// lua_Alloc recycling small blocks through free lists, one list per size class.
+// Userdata, tables and strings of short-lived objects are mostly small, so once the pool is warm
+// they are allocated and freed without calling malloc.
+// One pool serves one state and is not thread safe, it has to outlive the state:
+//
+//     luabind::pool_allocator pool;
+//     lua_State* L = lua_newstate(&luabind::pool_allocator::alloc, &pool);
+//
+// Blocks up to max_pooled_size are rounded up to a multiple of granularity and carved from slabs,
+// freed blocks are kept for reuse until the pool is destroyed. Larger blocks go to malloc.
+// A large block shrunk to a pooled size when no slab can be taken is kept by the pool like slab memory.
+class pool_allocator {
+public:
+    static constexpr size_t granularity = 16;
+    static constexpr size_t max_pooled_size = 512;
+    static constexpr size_t slab_size = 64 * 1024;
+
+    struct stats {
+        // pooled allocations served from a free list
+        size_t hits = 0;
+        // allocations which had to take new memory, from a slab or from malloc
+        size_t misses = 0;
+        // memory taken from the system: slabs and large blocks
+        size_t bytes_held = 0;
+        // memory handed to Lua, pooled blocks are counted by their size class
+        size_t bytes_in_use = 0;
+    };
+
+    pool_allocator() = default;
+    pool_allocator(const pool_allocator&) = delete;
+    pool_allocator& operator=(const pool_allocator&) = delete;
+
+    ~pool_allocator() {
+        while (_slabs != nullptr) {
+            slab_header* next = _slabs->next;
+            ::operator delete(_slabs);
+            _slabs = next;
+        }
+        while (_adopted != nullptr) {
+            adopted_header* next = _adopted->next;
+            std::free(_adopted->block);
+            _adopted = next;
+        }
+    }
+
+    static void* alloc(void* ud, void* ptr, size_t osize, size_t nsize) {
+        auto* pool = static_cast<pool_allocator*>(ud);
+        if (nsize == 0) {
+            if (ptr != nullptr) {
+                pool->deallocate(ptr, osize);
+            }
+            return nullptr;
+        }
+        if (ptr == nullptr) {
+            // osize is the type of the new object then, not a size
+            return pool->allocate(nsize);
+        }
+        return pool->reallocate(ptr, osize, nsize);
+    }
+
+    const stats& get_stats() const {
+        return _stats;
+    }
+
+private:
+    static constexpr size_t class_count = max_pooled_size / granularity;
+
+    struct free_block {
+        free_block* next;
+    };
+
+    // slabs are chained through their first granule, so keeping them allocates nothing else
+    struct slab_header {
+        slab_header* next;
+    };
+
+    // malloc blocks kept as pooled ones are chained through a header after their pooled part
+    struct adopted_header {
+        adopted_header* next;
+        void* block;
+    };
+
+    static_assert(sizeof(adopted_header) <= granularity);
+
+    static bool is_pooled(size_t size) {
+        return size <= max_pooled_size;
+    }
+
+    static size_t class_index(size_t size) {
+        return (size - 1) / granularity;
+    }
+
+    static size_t class_size(size_t size) {
+        return (class_index(size) + 1) * granularity;
+    }
+
+    void* allocate(size_t size) {
+        if (!is_pooled(size)) {
+            void* p = std::malloc(size);
+            if (p != nullptr) {
+                ++_stats.misses;
+                _stats.bytes_held += size;
+                _stats.bytes_in_use += size;
+            }
+            return p;
+        }
+        free_block*& head = _free[class_index(size)];
+        if (head != nullptr) [[likely]] {
+            free_block* block = head;
+            head = block->next;
+            ++_stats.hits;
+            _stats.bytes_in_use += class_size(size);
+            return block;
+        }
+        void* p = carve(class_size(size));
+        if (p != nullptr) {
+            ++_stats.misses;
+            _stats.bytes_in_use += class_size(size);
+        }
+        return p;
+    }
+
+    void deallocate(void* ptr, size_t size) {
+        if (!is_pooled(size)) {
+            std::free(ptr);
+            _stats.bytes_held -= size;
+            _stats.bytes_in_use -= size;
+            return;
+        }
+        push_free(ptr, size);
+        _stats.bytes_in_use -= class_size(size);
+    }
+
+    void push_free(void* ptr, size_t size) {
+        free_block*& head = _free[class_index(size)];
+        head = new (ptr) free_block {head};
+    }
+
+    void* reallocate(void* ptr, size_t osize, size_t nsize) {
+        if (is_pooled(osize) && is_pooled(nsize) && class_index(osize) == class_index(nsize)) {
+            return ptr;
+        }
+        if (!is_pooled(osize) && !is_pooled(nsize)) {
+            void* p = std::realloc(ptr, nsize);
+            if (p != nullptr) {
+                _stats.bytes_held += nsize - osize;
+                _stats.bytes_in_use += nsize - osize;
+            }
+            return p;
+        }
+        void* p = allocate(nsize);
+        if (p == nullptr) {
+            // Lua expects shrinking to succeed, so the block is kept and recycled in its new size class when freed
+            if (nsize < osize && is_pooled(nsize)) {
+                if (!is_pooled(osize)) {
+                    return adopt(ptr, osize, nsize);
+                }
+                _stats.bytes_in_use -= class_size(osize);
+                _stats.bytes_in_use += class_size(nsize);
+                return ptr;
+            }
+            return nullptr;
+        }
+        std::memcpy(p, ptr, osize < nsize ? osize : nsize);
+        deallocate(ptr, osize);
+        return p;
+    }
+
+    // Shrinks a malloc block to the size class of `nsize` plus a header, which chains it so the destructor frees it.
+    // Only a block a few bytes larger than the biggest class has to grow for the header, and may fail then.
+    void* adopt(void* ptr, size_t osize, size_t nsize) {
+        const size_t size = class_size(nsize) + granularity;
+        size_t held = size;
+        void* p = std::realloc(ptr, size);
+        if (p == nullptr) {
+            if (size > osize) {
+                return nullptr;
+            }
+            // the block is left as it was
+            p = ptr;
+            held = osize;
+        }
+        _adopted = new (static_cast<char*>(p) + class_size(nsize)) adopted_header {_adopted, p};
+        _stats.bytes_held = _stats.bytes_held - osize + held;
+        _stats.bytes_in_use = _stats.bytes_in_use - osize + class_size(nsize);
+        return p;
+    }
+
+    // Takes `size` bytes from the current slab, starting a new one when it is exhausted.
+    // The rest of an exhausted slab becomes a free block of its size.
+    void* carve(size_t size) {
+        if (_slab_left < size) {
+            void* p = ::operator new(slab_size, std::nothrow);
+            if (p == nullptr) {
+                return nullptr;
+            }
+            if (_slab_left >= granularity) {
+                push_free(_slab_next, _slab_left);
+            }
+            _slabs = new (p) slab_header {_slabs};
+            _slab_next = static_cast<char*>(p) + granularity;
+            _slab_left = slab_size - granularity;
+            _stats.bytes_held += slab_size;
+        }
+        void* p = _slab_next;
+        _slab_next += size;
+        _slab_left -= size;
+        return p;
+    }
+
+private:
+    std::array<free_block*, class_count> _free {};
+    slab_header* _slabs = nullptr;
+    adopted_header* _adopted = nullptr;
+    char* _slab_next = nullptr;
+    size_t _slab_left = 0;
+    stats _stats;
+};
+
+} // namespace luabind
+
+#endif // LUABIND_ALLOCATOR_HPP
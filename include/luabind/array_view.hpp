@@ -0,0 +1,197 @@
+#ifndef LUABIND_ARRAY_VIEW_HPP
+#define LUABIND_ARRAY_VIEW_HPP
+
+#include "lua.hpp"
+#include "exception.hpp"
+#include "mirror.hpp"
+#include "wrapper.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+
+namespace luabind {
+
+// Non-owning view of a contiguous buffer, pushed to Lua without copying the elements.
+// Lua sees it as a userdata with 1-based integer indexing, `#` and bounds checks,
+// elements of a view of const T are read only. Only numeric elements are supported.
+// The buffer has to outlive every Lua reference to the view, unless an owner is given,
+// which the userdata keeps alive.
+template <typename T>
+class array_view {
+    static_assert(std::is_arithmetic_v<std::remove_const_t<T>>, "Only views of numbers are supported.");
+
+public:
+    using element_type = T;
+
+    array_view() = default;
+
+    array_view(T* data, size_t size, std::shared_ptr<const void> owner = nullptr)
+        : _data(data)
+        , _size(size)
+        , _owner(std::move(owner)) {}
+
+    array_view(std::span<T> span, std::shared_ptr<const void> owner = nullptr)
+        : array_view(span.data(), span.size(), std::move(owner)) {}
+
+    // view of a contiguous container, which is kept alive by the view
+    template <typename Container>
+        requires(std::is_convertible_v<decltype(std::declval<Container&>().data()), T*>)
+    explicit array_view(std::shared_ptr<Container> container)
+        : array_view(container->data(), container->size(), container) {}
+
+    T* data() const {
+        return _data;
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+    T& operator[](size_t idx) const {
+        return _data[idx];
+    }
+
+    const std::shared_ptr<const void>& owner() const {
+        return _owner;
+    }
+
+private:
+    T* _data = nullptr;
+    size_t _size = 0;
+    std::shared_ptr<const void> _owner;
+};
+
+template <typename T>
+struct value_mirror<array_view<T>> {
+    using type = array_view<T>;
+
+    static int to_lua(lua_State* L, const type& v) {
+        void* p = lua_newuserdatauv(L, sizeof(type), 0);
+        new (p) type(v);
+        push_metatable(L);
+        lua_setmetatable(L, -2);
+        return 1;
+    }
+
+    static type from_lua(lua_State* L, const place& at) {
+        if (const type* v = test(L, at.idx)) [[likely]] {
+            return *v;
+        }
+        if constexpr (std::is_const_v<T>) {
+            // a writable view is accepted where a read only one is expected
+            if (const auto* v = value_mirror<array_view<std::remove_const_t<T>>>::test(L, at.idx)) {
+                return type(v->data(), v->size(), v->owner());
+            }
+        }
+        reportError(L,
+                    at,
+                    "Argument",
+                    "has invalid type. Expecting 'array_view', but got '%s'.",
+                    lua_typename(L, lua_type(L, at.idx)));
+    }
+
+    static bool matches(lua_State* L, int idx) {
+        if constexpr (std::is_const_v<T>) {
+            if (value_mirror<array_view<std::remove_const_t<T>>>::test(L, idx) != nullptr) {
+                return true;
+            }
+        }
+        return test(L, idx) != nullptr;
+    }
+
+    // The view at `idx`, or nullptr if it is not a view of T.
+    static const type* test(lua_State* L, int idx) {
+        if (lua_type(L, idx) != LUA_TUSERDATA || lua_getmetatable(L, idx) == 0) {
+            return nullptr;
+        }
+        lua_rawgetp(L, LUA_REGISTRYINDEX, &metatable_key);
+        const bool same = lua_rawequal(L, -1, -2) != 0;
+        lua_pop(L, 2);
+        return same ? static_cast<const type*>(lua_touserdata(L, idx)) : nullptr;
+    }
+
+private:
+    // One metatable per element type. Element access has the shape of array_access getters and setters
+    // and is installed as __index and __newindex directly, there are no named members to look up.
+    static void push_metatable(lua_State* L) {
+        if (lua_rawgetp(L, LUA_REGISTRYINDEX, &metatable_key) == LUA_TTABLE) [[likely]] {
+            return;
+        }
+        lua_pop(L, 1);
+        lua_createtable(L, 0, 5);
+        lua_pushliteral(L, "array_view");
+        lua_setfield(L, -2, "__name");
+        lua_pushcfunction(L, lua_function<index>::safe_invoke);
+        lua_setfield(L, -2, "__index");
+        lua_pushcfunction(L, lua_function<new_index>::safe_invoke);
+        lua_setfield(L, -2, "__newindex");
+        lua_pushcfunction(L, &length);
+        lua_setfield(L, -2, "__len");
+        lua_pushcfunction(L, &destruct);
+        lua_setfield(L, -2, "__gc");
+        lua_pushvalue(L, -1);
+        lua_rawsetp(L, LUA_REGISTRYINDEX, &metatable_key);
+    }
+
+    // the metamethods are only reachable through the metatable, so the userdata is a view of T
+    static type& self(lua_State* L) {
+        return *static_cast<type*>(lua_touserdata(L, 1));
+    }
+
+    static size_t element_index(lua_State* L, const type& v) {
+        if (lua_isinteger(L, 2) == 0) [[unlikely]] {
+            raiseError(L,
+                       "Key type of array_view should be integer, '%s' is provided.",
+                       lua_typename(L, lua_type(L, 2)));
+        }
+        const lua_Integer idx = lua_tointeger(L, 2);
+        if (idx < 1 || static_cast<lua_Unsigned>(idx) > v.size()) [[unlikely]] {
+            raiseError(L,
+                       "Index %I is out of bounds of array_view of size %I.",
+                       static_cast<lua_Integer>(idx),
+                       static_cast<lua_Integer>(v.size()));
+        }
+        return static_cast<size_t>(idx - 1);
+    }
+
+    static int index(lua_State* L) {
+        const type& v = self(L);
+        return value_mirror<std::remove_const_t<T>>::to_lua(L, v[element_index(L, v)]);
+    }
+
+    static int new_index(lua_State* L) {
+        const type& v = self(L);
+        if constexpr (std::is_const_v<T>) {
+            raiseError(L, "array_view of const elements is read only.");
+        } else {
+            const size_t idx = element_index(L, v);
+            v[idx] = value_mirror<T>::from_lua(L, 3);
+        }
+        return 0;
+    }
+
+    static int length(lua_State* L) {
+        lua_pushinteger(L, static_cast<lua_Integer>(self(L).size()));
+        return 1;
+    }
+
+    static int destruct(lua_State* L) {
+        self(L).~type();
+        return 0;
+    }
+
+    static inline const char metatable_key = 0;
+};
+
+template <typename T>
+struct value_mirror<const array_view<T>> : value_mirror<array_view<T>> {};
+
+template <typename T>
+struct value_mirror<const array_view<T>&> : value_mirror<array_view<T>> {};
+
+} // namespace luabind
+
+#endif // LUABIND_ARRAY_VIEW_HPP
@@ -1,6 +1,7 @@
 #ifndef LUABIND_BIND_HPP
 #define LUABIND_BIND_HPP
 
+#include "array_view.hpp"
 #include "object.hpp"
 #include "exception.hpp"
 #include "mirror.hpp"
@@ -18,55 +19,68 @@ namespace luabind {
 
 template <typename Type, typename... Bases>
 class class_ {
-    static_assert(std::is_base_of_v<Object, Type>, "Type should be descendant from luabind::Object.");
+    static_assert(std::is_base_of_v<Object, Type> || is_value_type_v<Type>,
+                  "Type should be descendant from luabind::Object, or a final trivially copyable value type.");
+    static_assert(!is_value_type_v<Type> || sizeof...(Bases) == 0, "Value types cannot have bound bases.");
 
 public:
-    class_(lua_State* L, const std::string_view name)
+    class_(lua_State* L, const std::string_view name, class_options options = class_options::none)
         : _L(L) {
-        _info = type_storage::add_type_info<Type, Bases...>(L, std::string {name}, index_impl, new_index_impl);
-        _info->get_metatable(L);
-        int mt_idx = lua_gettop(L);
-
+        if constexpr (is_value_type_v<Type>) {
+            // there is no custom table to store unknown keys in
+            options = options | class_options::sealed;
+        }
+        // options of an already bound type are kept
+        _info = type_storage::add_type_info<Type, Bases...>(L, std::string {name}, options);
+        // metatable functions are recorded in type_info, so states attaching a schema can recreate them
         if constexpr (std::is_default_constructible_v<Type>) {
-            lua_pushliteral(L, "new");
-            lua_CFunction default_ctor = ctor_wrapper<Type>::invoke;
-            lua_pushcfunction(L, default_ctor);
-            lua_rawset(L, mt_idx);
+            _info->add_metatable_function(L, "new", ctor_wrapper<Type>::invoke);
         }
 
-        // one __index to rule them all and in lua bind them
-        lua_pushliteral(L, "__index");
-        lua_pushcfunction(L, lua_function<index_>::safe_invoke);
-        lua_rawset(L, mt_idx);
-
-        lua_pushliteral(L, "__newindex");
-        lua_pushcfunction(L, lua_function<new_index>::safe_invoke);
-        lua_rawset(L, mt_idx);
+        // one __index to rule them all and in lua bind them,
+        // with class_options::method_table it is the fallback of a Lua dispatcher
+        _info->add_metatable_function(L, "__index", lua_function<index_>::safe_invoke);
+        _info->add_metatable_function(L, "__newindex", lua_function<new_index>::safe_invoke);
 
-        user_data::add_destructing_functions(L, mt_idx);
-        function<user_data::destruct>("delete");
-        lua_pop(L, 1); // pop metatable
+        if constexpr (!is_value_type_v<Type>) {
+            // values are trivially destructible, Lua just frees their memory
+            _info->add_metatable_function(L, "__gc", &user_data::destruct);
+            function<user_data::destruct>("delete");
+        }
     }
 
     template <typename... Args>
+        requires(sizeof...(Args) == 0 || !(is_signature<Args>::value && ...))
     class_& constructor(const std::string_view name) {
         static_assert(std::is_constructible_v<Type, Args...>, "class should be constructible with given arguments");
         return constructor<ctor_wrapper<Type, Args...>::invoke>(name);
     }
 
+    // overloaded constructor, one signature<Args...> per overload
+    template <typename... Signatures>
+        requires(sizeof...(Signatures) > 1 && (is_signature<Signatures>::value && ...))
+    class_& constructor(const std::string_view name) {
+        return constructor<overload_wrapper<typename signature_wrapper<ctor_wrapper, Type, Signatures>::type...>::invoke>(
+            name);
+    }
+
     template <typename... Args>
+        requires(sizeof...(Args) == 0 || !(is_signature<Args>::value && ...))
     class_& construct_shared(const std::string_view name) {
         static_assert(std::is_constructible_v<Type, Args...>, "class should be constructible with given arguments");
         return constructor<shared_ctor_wrapper<Type, Args...>::invoke>(name);
     }
 
+    template <typename... Signatures>
+        requires(sizeof...(Signatures) > 1 && (is_signature<Signatures>::value && ...))
+    class_& construct_shared(const std::string_view name) {
+        return constructor<
+            overload_wrapper<typename signature_wrapper<shared_ctor_wrapper, Type, Signatures>::type...>::invoke>(name);
+    }
+
     template <lua_CFunction func>
     class_& constructor(const std::string_view name) {
-        _info->get_metatable(_L);
-        value_mirror<std::string_view>::to_lua(_L, name);
-        lua_pushcfunction(_L, lua_function<func>::safe_invoke);
-        lua_rawset(_L, -3);
-        lua_pop(_L, 1); // pop metatable
+        _info->add_metatable_function(_L, name, lua_function<func>::safe_invoke);
         return *this;
     }
 
@@ -76,9 +90,16 @@ public:
         return function<function_wrapper<decltype(func), func>::invoke>(name);
     }
 
+    // overloaded method, the first function accepting the arguments is called
+    template <auto... funcs>
+        requires(sizeof...(funcs) > 1)
+    class_& function(const std::string_view name) {
+        return function<overload_wrapper<function_wrapper<decltype(funcs), funcs>...>::invoke>(name);
+    }
+
     template <lua_CFunction func>
     class_& function(const std::string_view name) {
-        _info->functions[std::string {name}] = lua_function<func>::safe_invoke;
+        _info->add_function(_L, name, lua_function<func>::safe_invoke);
         return *this;
     }
 
@@ -88,25 +109,32 @@ public:
         return class_function<class_function_wrapper<decltype(func), func>::invoke>(name);
     }
 
+    template <auto... funcs>
+        requires(sizeof...(funcs) > 1)
+    class_& class_function(const std::string_view name) {
+        return class_function<overload_wrapper<class_function_wrapper<decltype(funcs), funcs>...>::invoke>(name);
+    }
+
     template <lua_CFunction func>
     class_& class_function(const std::string_view name) {
-        _info->get_metatable(_L);
-        value_mirror<std::string_view>::to_lua(_L, name);
-        lua_pushcfunction(_L, lua_function<func>::safe_invoke);
-        lua_rawset(_L, -3);
-        lua_pop(_L, 1); // pop metatable
+        _info->add_metatable_function(_L, name, lua_function<func>::safe_invoke);
         return *this;
     }
 
     template <auto prop>
         requires(std::is_member_pointer_v<decltype(prop)>)
     class_& property_readonly(const std::string_view name) {
-        return property_readonly<property_wrapper<get, decltype(prop), prop>::invoke>(name);
+        if constexpr (std::is_member_object_pointer_v<decltype(prop)>) {
+            _info->add_property(_L, name, field_accessor<decltype(prop)>::field(prop, false));
+            return *this;
+        } else {
+            return property_readonly<property_wrapper<get, decltype(prop), prop>::invoke>(name);
+        }
     }
 
     template <lua_CFunction func>
     class_& property_readonly(const std::string_view name) {
-        _info->properties.emplace(name, property_data(lua_function<func>::safe_invoke, nullptr));
+        _info->add_property(_L, name, property_data(lua_function<func>::safe_invoke, nullptr));
         return *this;
     }
 
@@ -114,8 +142,9 @@ public:
         requires(std::is_member_pointer_v<decltype(prop)>)
     class_& property(const std::string_view name) {
         if constexpr (std::is_member_object_pointer_v<decltype(prop)>) {
-            return property<property_wrapper<get, decltype(prop), prop>::invoke,
-                            property_wrapper<set, decltype(prop), prop>::invoke>(name);
+            // data members share accessors per member type, only the offset is stored per member
+            _info->add_property(_L, name, field_accessor<decltype(prop)>::field(prop, true));
+            return *this;
         } else {
             return property_readonly<property_wrapper<get, decltype(prop), prop>::invoke>(name);
         }
@@ -130,20 +159,20 @@ public:
 
     template <lua_CFunction getter, lua_CFunction setter>
     class_& property(const std::string_view name) {
-        _info->properties.emplace(name,
-                                  property_data(lua_function<getter>::safe_invoke, lua_function<setter>::safe_invoke));
+        _info->add_property(_L, name,
+                            property_data(lua_function<getter>::safe_invoke, lua_function<setter>::safe_invoke));
         return *this;
     }
 
     template <auto getter>
         requires(!std::is_same_v<decltype(getter), lua_CFunction>)
     class_& array_access() {
-        return array_access(function_wrapper<decltype(getter), getter>::invoke);
+        return array_access<function_wrapper<decltype(getter), getter>::invoke>();
     }
 
     template <lua_CFunction getter>
     class_& array_access() {
-        _info->array_access_getter = lua_function<getter>::safe_invoke;
+        _info->set_array_access(_L, lua_function<getter>::safe_invoke, nullptr);
         return *this;
     }
 
@@ -156,69 +185,75 @@ public:
 
     template <lua_CFunction getter, lua_CFunction setter>
     class_& array_access() {
-        _info->array_access_getter = lua_function<getter>::safe_invoke;
-        _info->array_access_setter = lua_function<setter>::safe_invoke;
+        _info->set_array_access(_L, lua_function<getter>::safe_invoke, lua_function<setter>::safe_invoke);
         return *this;
     }
 
 private:
+    template <typename, typename...>
+    friend class descriptor;
+
     static int index_(lua_State* L) {
         int r = index_impl(L);
         if (r != 0) return r;
+        type_info* info = type_storage::find_type_info<Type>(L);
+        if (has_option(info->options, class_options::sealed)) {
+            raiseError(L, "Type '%s' has no member named '%s'.", info->name.c_str(), lua_tostring(L, 2));
+        }
         // if there is no result from bound C++, look in the lua table bound to this object
-        user_data::get_custom_table(L, 1); // custom table
+        user_data::get_custom_table(L, 1); // custom table or nil, if nothing was stored yet
+        if (!lua_istable(L, -1)) {
+            return 1;
+        }
         lua_pushvalue(L, 2); // key
         lua_rawget(L, -2);
         return 1;
     }
 
     static int index_impl(lua_State* L) {
-        type_info* info = type_storage::find_type_info<Type>(L);
+        type_storage& storage = type_storage::get_instance(L);
+        type_info* info = storage.find_by_id(type_id<Type>());
+        // method tables are filled by the first lookup after members change, where a Lua error can be raised
+        storage.update_method_table(L, info);
 
         const bool is_integer = lua_isinteger(L, 2);
         const int key_type = lua_type(L, 2);
         if (!is_integer && key_type != LUA_TSTRING) {
-            reportError("Key type should be integer or string, '%s' is provided.", lua_typename(L, key_type));
+            raiseError(L, "Key type should be integer or string, '%s' is provided.", lua_typename(L, key_type));
         }
 
         if (is_integer) {
-            if (info->array_access_getter == nullptr) {
-                reportError("Type '%s' does not provide array get access.", info->name.c_str());
+            lua_CFunction getter = info->find_array_access_getter();
+            if (getter == nullptr) {
+                raiseError(L, "Type '%s' does not provide array get access.", info->name.c_str());
             }
-            return info->array_access_getter(L);
+            return getter(L);
         }
 
-        // key is string
-        auto key = value_mirror<std::string_view>::from_lua(L, 2);
-        auto p_it = info->properties.find(key);
-        if (p_it != info->properties.end()) {
-            if (p_it->second.getter == nullptr) {
-                reportError("Property named '%s' does not have a getter.", key.data());
-            }
-            return p_it->second.getter(L);
+        // key is string, inherited members are already resolved in the type's member table
+        const member_data* member = storage.find_member(L, info, 2);
+        if (member == nullptr) {
+            return 0;
         }
-        auto f_it = info->functions.find(key);
-        if (f_it != info->functions.end()) {
-            lua_pushcfunction(L, f_it->second);
-            return 1;
-        }
-        // lua doesn't do recursive index lookup through metatables
-        // if __index is bound to a C function, so we do it ourselves.
-        for (type_info* base : info->bases) {
-            int r = base->index(L);
-            if (r != 0) {
-                return r;
+        if (member->property != nullptr) {
+            if (!member->property->has_getter()) {
+                raiseError(L, "Property named '%s' does not have a getter.", lua_tostring(L, 2));
             }
+            return member->property->get(L);
         }
-
-        return 0;
+        lua_pushcfunction(L, member->function);
+        return 1;
     }
 
     static int new_index(lua_State* L) {
         int r = new_index_impl(L);
         if (r != 0) return 0;
+        type_info* info = type_storage::find_type_info<Type>(L);
+        if (has_option(info->options, class_options::sealed)) {
+            raiseError(L, "Type '%s' has no member named '%s'.", info->name.c_str(), lua_tostring(L, 2));
+        }
         // if there is no result in C++ add new value to the lua table bound to this object
-        user_data::get_custom_table(L, 1); // custom table
+        user_data::get_or_create_custom_table(L, 1);
         lua_pushvalue(L, 2); // key
         lua_pushvalue(L, 3); // new value
         lua_rawset(L, -3);
@@ -226,40 +261,32 @@ private:
     }
 
     static int new_index_impl(lua_State* L) {
-        type_info* info = type_storage::find_type_info<Type>(L);
+        type_storage& storage = type_storage::get_instance(L);
+        type_info* info = storage.find_by_id(type_id<Type>());
 
         const bool is_integer = lua_isinteger(L, 2);
         const int key_type = lua_type(L, 2);
         if (!is_integer && key_type != LUA_TSTRING) {
-            reportError("Key type should be integer or string, '%s' is provided.", lua_typename(L, key_type));
+            raiseError(L, "Key type should be integer or string, '%s' is provided.", lua_typename(L, key_type));
         }
         if (is_integer) {
-            if (info->array_access_setter == nullptr) {
-                reportError("Type '%s' does not provide array set access.", info->name.c_str());
+            lua_CFunction setter = info->find_array_access_setter();
+            if (setter == nullptr) {
+                raiseError(L, "Type '%s' does not provide array set access.", info->name.c_str());
             }
-            info->array_access_setter(L);
+            setter(L);
             return 1;
         }
         // key is a string
-        auto key = value_mirror<std::string_view>::from_lua(L, 2);
-        auto p_it = info->properties.find(key);
-        if (p_it != info->properties.end()) {
-            if (p_it->second.setter == nullptr) {
-                reportError("Property '%s' is read only.", key.data());
-            }
-            p_it->second.setter(L);
-            return 1;
+        const member_data* member = storage.find_member(L, info, 2);
+        if (member == nullptr || member->property == nullptr) {
+            return 0;
         }
-
-        // lua doesn't do recursive index lookup through metatables
-        // if __new_index is bound to a C function, so we do it ourselves.
-        for (type_info* base : info->bases) {
-            int r = base->new_index(L);
-            if (r != 0) {
-                return r;
-            }
+        if (!member->property->has_setter()) {
+            raiseError(L, "Property '%s' is read only.", lua_tostring(L, 2));
         }
-        return 0;
+        member->property->set(L);
+        return 1;
     }
 
 private:
@@ -279,6 +306,13 @@ void function(lua_State* L, const std::string_view name) {
     function<function_wrapper<decltype(func), func>::invoke>(L, name);
 }
 
+// overloaded free function, the first function accepting the arguments is called
+template <auto... funcs>
+    requires(sizeof...(funcs) > 1)
+void function(lua_State* L, const std::string_view name) {
+    function<overload_wrapper<function_wrapper<decltype(funcs), funcs>...>::invoke>(L, name);
+}
+
 } // namespace luabind
 
 #endif // LUABIND_BIND_HPP
@@ -0,0 +1,313 @@
+#ifndef LUABIND_DESCRIPTOR_HPP
+#define LUABIND_DESCRIPTOR_HPP
+
+#include "bind.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace luabind {
+
+// One entry of a class description, made by the static functions of descriptor.
+struct descriptor_entry {
+    enum class kind : unsigned char { member, metatable_function, array_access };
+
+    kind type;
+    // for array access, the getter and setter are the property of the member
+    static_member member;
+};
+
+// Members of a class in static storage, sorted by name at compile time, see descriptor::make.
+template <typename Type, size_t Capacity, typename... Bases>
+class class_descriptor {
+public:
+    using type = Type;
+
+    const char* name = nullptr;
+    class_options options = class_options::none;
+    std::array<static_member, Capacity> members {};
+    size_t member_count = 0;
+    // constructors, class functions and metamethods, the luaL_setfuncs array ends with {nullptr, nullptr}
+    std::array<luaL_Reg, Capacity + 1> metatable_functions {};
+    lua_CFunction array_access_getter = nullptr;
+    lua_CFunction array_access_setter = nullptr;
+
+    constexpr std::span<const static_member> get_members() const {
+        return {members.data(), member_count};
+    }
+
+private:
+    template <const auto& descriptor>
+    friend type_info* bind(lua_State* L);
+
+    type_info* bind(lua_State* L) const {
+        type_info* info = type_storage::add_type_info<Type, Bases...>(L, std::string {name}, options);
+        info->add_static_members(L,
+                                 get_members(),
+                                 metatable_functions.data(),
+                                 array_access_getter,
+                                 array_access_setter);
+        type_storage::get_instance(L).update_method_tables(L, info);
+        return info;
+    }
+};
+
+inline void report_duplicate_member(const char* name) {
+    reportError("Member '%s' is described twice.", name);
+}
+
+// Declarative counterpart of class_, evaluated at compile time:
+//
+//     using D = luabind::descriptor<Account>;
+//     static constexpr auto account = D::make("Account", {
+//         D::constructor<int>("new"),
+//         D::function<&Account::credit>("credit"),
+//         D::property_readonly<&Account::balance>("balance"),
+//     });
+//     ...
+//     luabind::bind<account>(L);
+//
+// The entries take the same template arguments as the class_ methods of the same names.
+// Binding does not allocate per member: type_info refers to the sorted static arrays, which are merged into
+// the member list of the type without sorting, and the metatable is filled with a single luaL_setfuncs.
+template <typename Type, typename... Bases>
+class descriptor {
+    using binder = class_<Type, Bases...>;
+    using entry = descriptor_entry;
+
+    // new, __index, __newindex, __gc and delete
+    static constexpr size_t default_count = 5;
+
+public:
+    static constexpr auto make(const char* name) {
+        return build<0>(name, class_options::none, nullptr);
+    }
+
+    template <size_t N>
+    static constexpr auto make(const char* name, const entry (&entries)[N]) {
+        return build<N>(name, class_options::none, entries);
+    }
+
+    template <size_t N>
+    static constexpr auto make(const char* name, class_options options, const entry (&entries)[N]) {
+        return build<N>(name, options, entries);
+    }
+
+    template <typename... Args>
+        requires(sizeof...(Args) == 0 || !(is_signature<Args>::value && ...))
+    static constexpr entry constructor(const char* name) {
+        static_assert(std::is_constructible_v<Type, Args...>, "class should be constructible with given arguments");
+        return constructor<ctor_wrapper<Type, Args...>::invoke>(name);
+    }
+
+    template <typename... Signatures>
+        requires(sizeof...(Signatures) > 1 && (is_signature<Signatures>::value && ...))
+    static constexpr entry constructor(const char* name) {
+        return constructor<overload_wrapper<typename signature_wrapper<ctor_wrapper, Type, Signatures>::type...>::invoke>(
+            name);
+    }
+
+    template <typename... Args>
+        requires(sizeof...(Args) == 0 || !(is_signature<Args>::value && ...))
+    static constexpr entry construct_shared(const char* name) {
+        static_assert(std::is_constructible_v<Type, Args...>, "class should be constructible with given arguments");
+        return constructor<shared_ctor_wrapper<Type, Args...>::invoke>(name);
+    }
+
+    template <typename... Signatures>
+        requires(sizeof...(Signatures) > 1 && (is_signature<Signatures>::value && ...))
+    static constexpr entry construct_shared(const char* name) {
+        return constructor<
+            overload_wrapper<typename signature_wrapper<shared_ctor_wrapper, Type, Signatures>::type...>::invoke>(name);
+    }
+
+    template <lua_CFunction func>
+    static constexpr entry constructor(const char* name) {
+        return metatable_function(name, lua_function<func>::safe_invoke);
+    }
+
+    template <auto func>
+        requires(!std::is_same_v<decltype(func), lua_CFunction>)
+    static constexpr entry function(const char* name) {
+        return function<function_wrapper<decltype(func), func>::invoke>(name);
+    }
+
+    template <auto... funcs>
+        requires(sizeof...(funcs) > 1)
+    static constexpr entry function(const char* name) {
+        return function<overload_wrapper<function_wrapper<decltype(funcs), funcs>...>::invoke>(name);
+    }
+
+    template <lua_CFunction func>
+    static constexpr entry function(const char* name) {
+        return {entry::kind::member, static_member {name, lua_function<func>::safe_invoke}};
+    }
+
+    template <auto func>
+        requires(!std::is_same_v<decltype(func), lua_CFunction>)
+    static constexpr entry class_function(const char* name) {
+        return class_function<class_function_wrapper<decltype(func), func>::invoke>(name);
+    }
+
+    template <auto... funcs>
+        requires(sizeof...(funcs) > 1)
+    static constexpr entry class_function(const char* name) {
+        return class_function<overload_wrapper<class_function_wrapper<decltype(funcs), funcs>...>::invoke>(name);
+    }
+
+    template <lua_CFunction func>
+    static constexpr entry class_function(const char* name) {
+        return metatable_function(name, lua_function<func>::safe_invoke);
+    }
+
+    template <auto prop>
+        requires(std::is_member_pointer_v<decltype(prop)>)
+    static constexpr entry property_readonly(const char* name) {
+        return property_readonly<property_wrapper<get, decltype(prop), prop>::invoke>(name);
+    }
+
+    template <lua_CFunction func>
+    static constexpr entry property_readonly(const char* name) {
+        return {entry::kind::member,
+                static_member {name, nullptr, property_data(lua_function<func>::safe_invoke, nullptr)}};
+    }
+
+    template <auto prop>
+        requires(std::is_member_pointer_v<decltype(prop)>)
+    static constexpr entry property(const char* name) {
+        if constexpr (std::is_member_object_pointer_v<decltype(prop)>) {
+            return property<property_wrapper<get, decltype(prop), prop>::invoke,
+                            property_wrapper<set, decltype(prop), prop>::invoke>(name);
+        } else {
+            return property_readonly<property_wrapper<get, decltype(prop), prop>::invoke>(name);
+        }
+    }
+
+    template <auto getter, auto setter>
+        requires(std::is_member_pointer_v<decltype(getter)> && std::is_member_pointer_v<decltype(setter)>)
+    static constexpr entry property(const char* name) {
+        return property<property_wrapper<get, decltype(getter), getter>::invoke,
+                        property_wrapper<set, decltype(setter), setter>::invoke>(name);
+    }
+
+    template <lua_CFunction getter, lua_CFunction setter>
+    static constexpr entry property(const char* name) {
+        return {entry::kind::member,
+                static_member {name,
+                               nullptr,
+                               property_data(lua_function<getter>::safe_invoke, lua_function<setter>::safe_invoke)}};
+    }
+
+    template <auto getter>
+        requires(!std::is_same_v<decltype(getter), lua_CFunction>)
+    static constexpr entry array_access() {
+        return array_access<function_wrapper<decltype(getter), getter>::invoke>();
+    }
+
+    template <lua_CFunction getter>
+    static constexpr entry array_access() {
+        return {entry::kind::array_access,
+                static_member {nullptr, nullptr, property_data(lua_function<getter>::safe_invoke, nullptr)}};
+    }
+
+    template <auto getter, auto setter>
+        requires(!std::is_same_v<decltype(getter), lua_CFunction> && !std::is_same_v<decltype(setter), lua_CFunction>)
+    static constexpr entry array_access() {
+        return array_access<function_wrapper<decltype(getter), getter>::invoke,
+                            function_wrapper<decltype(setter), setter>::invoke>();
+    }
+
+    template <lua_CFunction getter, lua_CFunction setter>
+    static constexpr entry array_access() {
+        return {entry::kind::array_access,
+                static_member {nullptr,
+                               nullptr,
+                               property_data(lua_function<getter>::safe_invoke, lua_function<setter>::safe_invoke)}};
+    }
+
+private:
+    static constexpr entry metatable_function(const char* name, lua_CFunction func) {
+        return {entry::kind::metatable_function, static_member {name, func}};
+    }
+
+    template <size_t N>
+    static constexpr auto build(const char* name, class_options options, const entry* entries) {
+        class_descriptor<Type, N + default_count, Bases...> d;
+        d.name = name;
+        // the same defaults as class_ sets up
+        d.options = is_value_type_v<Type> ? options | class_options::sealed : options;
+
+        // a described entry replaces a default of the same name, two described entries of one name are an error
+        std::array<bool, N + default_count> default_members {};
+        std::array<bool, N + default_count> default_functions {};
+        auto add = [](auto& array, size_t& count, auto& defaults, const auto& value, bool by_default) {
+            for (size_t i = 0; i < count; ++i) {
+                if (std::string_view {array[i].name} == value.name) {
+                    if (!defaults[i] && !by_default) {
+                        report_duplicate_member(value.name);
+                    }
+                    array[i] = value;
+                    defaults[i] = by_default;
+                    return;
+                }
+            }
+            defaults[count] = by_default;
+            array[count++] = value;
+        };
+        size_t function_count = 0;
+        auto add_function = [&](const char* key, lua_CFunction func, bool by_default) {
+            add(d.metatable_functions, function_count, default_functions, luaL_Reg {key, func}, by_default);
+        };
+
+        if constexpr (std::is_default_constructible_v<Type>) {
+            add_function("new", ctor_wrapper<Type>::invoke, true);
+        }
+        add_function("__index", lua_function<binder::index_>::safe_invoke, true);
+        add_function("__newindex", lua_function<binder::new_index>::safe_invoke, true);
+        if constexpr (!is_value_type_v<Type>) {
+            add_function("__gc", &user_data::destruct, true);
+            add(d.members,
+                d.member_count,
+                default_members,
+                static_member {"delete", lua_function<user_data::destruct>::safe_invoke},
+                true);
+        }
+
+        for (size_t i = 0; i < N; ++i) {
+            const entry& e = entries[i];
+            if (e.type == entry::kind::member) {
+                add(d.members, d.member_count, default_members, e.member, false);
+            } else if (e.type == entry::kind::metatable_function) {
+                add_function(e.member.name, e.member.function, false);
+            } else {
+                d.array_access_getter = e.member.property.getter;
+                d.array_access_setter = e.member.property.setter;
+            }
+        }
+
+        const auto by_name = [](const auto& a, const auto& b) {
+            return std::string_view {a.name} < std::string_view {b.name};
+        };
+        std::sort(d.members.begin(), d.members.begin() + static_cast<std::ptrdiff_t>(d.member_count), by_name);
+        std::sort(d.metatable_functions.begin(),
+                  d.metatable_functions.begin() + static_cast<std::ptrdiff_t>(function_count),
+                  by_name);
+        return d;
+    }
+};
+
+// Binds a class described by descriptor::make. The descriptor has to have static storage duration,
+// the bindings refer to its arrays.
+template <const auto& descriptor>
+type_info* bind(lua_State* L) {
+    return descriptor.bind(L);
+}
+
+} // namespace luabind
+
+#endif // LUABIND_DESCRIPTOR_HPP
@@ -1,7 +1,11 @@
 #ifndef LUABIND_EXCEPTION_HPP
 #define LUABIND_EXCEPTION_HPP
 
+#include "lua.hpp"
+
+#include <cctype>
 #include <cstdarg>
+#include <cstdio>
 #include <exception>
 #include <string>
 #include <string_view>
@@ -22,15 +26,180 @@ private:
     std::string _message;
 };
 
+// Error of a conversion formatted on the Lua stack by reportError(L, ...). It keeps its own copy of the message
+// and pops the string, so host code calling value_mirror conversions outside of Lua gets a plain luabind::error.
+class stack_error : public error {
+public:
+    explicit stack_error(lua_State* L)
+        : error(to_string(L)) {
+        lua_pop(L, 1);
+    }
+
+private:
+    static std::string to_string(lua_State* L) {
+        size_t size = 0;
+        const char* message = lua_tolstring(L, -1, &size);
+        return std::string(message, size);
+    }
+};
+
 // TODO replace with std::format when supported by compilers
 [[gnu::format(printf, 1, 2)]] inline void reportError(const char* fmt, ...) {
     std::va_list args;
     va_start(args, fmt);
-    constexpr size_t bufferSize = 256;
-    char buffer[bufferSize];
-    std::vsnprintf(buffer, bufferSize, fmt, args);
+    std::va_list measure;
+    va_copy(measure, args);
+    const int size = std::vsnprintf(nullptr, 0, fmt, measure);
+    va_end(measure);
+    std::string message(size > 0 ? static_cast<size_t>(size) : 0, '\0');
+    std::vsnprintf(message.data(), message.size() + 1, fmt, args);
+    va_end(args);
+    throw error {std::move(message)};
+}
+
+// Raises a Lua error right away, for code called from Lua with no C++ objects to destroy
+// between it and the lua_CFunction boundary, e.g. argument count and member lookup checks.
+// Formatted by lua_pushvfstring, like reportError(L, ...).
+[[noreturn]] inline void raiseError(lua_State* L, const char* fmt, ...) {
+    std::va_list args;
+    va_start(args, fmt);
+    lua_pushvfstring(L, fmt, args);
+    va_end(args);
+    lua_error(L);
+    std::terminate(); // lua_error does not return
+}
+
+// Error of a value_mirror conversion. The message is formatted by lua_pushvfstring, so only its conversions are
+// supported (%d, %s, %f, %p, %c, %I, %U, %%), with no width or precision, and not checked by the compiler.
+// It is thrown as a C++ exception even when Lua raises errors as exceptions: mirrors are called by host code too,
+// where a lua_error would have no protected call to land in. exception_safe_wrapper turns it into a Lua error
+// after the C++ frames in between are unwound.
+[[noreturn]] inline void reportError(lua_State* L, const char* fmt, ...) {
+    std::va_list args;
+    va_start(args, fmt);
+    lua_pushvfstring(L, fmt, args);
+    va_end(args);
+    throw stack_error {L};
+}
+
+// Where a value converted by value_mirror comes from, named by its errors: an argument by its stack index,
+// e.g. "Argument at 2 has invalid type...", and a part of another value by the path to it,
+// e.g. "Element 'x' of argument 1 has invalid type..." or "Element 2 of result 1 of the Lua function ...".
+// An int converts to the place of an argument, so mirrors are called by stack index as well.
+struct place {
+    // stack index of the value
+    int idx;
+    // the value this one is a part of, nullptr for arguments and results
+    const place* parent = nullptr;
+    // "argument", "result", "element" or "key"
+    const char* what = "argument";
+    // number of the argument, result or element, unused when named by a key
+    lua_Integer number = 0;
+    // absolute stack index of the table key naming an element or a key, 0 when named by number
+    int key = 0;
+    // owner of a result, e.g. "the Lua function"
+    const char* owner = nullptr;
+    // Errors are raised as Lua errors right away instead of thrown. Set by wrappers of lua_CFunctions
+    // for conversions which leave nothing to destroy between them and the lua_CFunction, see exception_safe_wrapper.
+    bool raise = false;
+
+    place(int idx, bool raise = false)
+        : idx(idx)
+        , number(idx)
+        , raise(raise) {}
+
+    // A result of a call, counted from 1.
+    static place result(int idx, int number, const char* owner) {
+        place p(idx);
+        p.what = "result";
+        p.number = number;
+        p.owner = owner;
+        return p;
+    }
+
+    // The element at `idx` of this table, counted from 1. It raises its errors only if this does and `may_raise`,
+    // i.e. the container converted so far has nothing to destroy.
+    place element(int idx, lua_Integer position, bool may_raise) const {
+        place p(idx, raise && may_raise);
+        p.parent = this;
+        p.what = "element";
+        p.number = position;
+        return p;
+    }
+
+    // The element at `idx` of this table, named by its key at `key_idx`.
+    place element_at_key(lua_State* L, int idx, int key_idx, bool may_raise) const {
+        place p = element(idx, 0, may_raise);
+        p.key = lua_absindex(L, key_idx);
+        return p;
+    }
+
+    // The key at `idx` of this table, named by itself.
+    place key_of(lua_State* L, int idx, bool may_raise) const {
+        place p = element_at_key(L, idx, idx, may_raise);
+        p.what = "key";
+        return p;
+    }
+
+    // Pushes the name of the value, followed by a space. An argument is named by `subject` and its stack index,
+    // e.g. "Provided table at 2 ", anything else by its path, e.g. "Key 'x' of element 3 of argument 1 ".
+    void push_name(lua_State* L, const char* subject) const {
+        if (parent == nullptr && owner == nullptr) {
+            lua_pushfstring(L, "%s at %d ", subject, idx);
+            return;
+        }
+        const int top = lua_gettop(L);
+        for (const place* p = this; p != nullptr; p = p->parent) {
+            if (p == this) {
+                lua_pushfstring(L, "%c%s ", std::toupper(static_cast<unsigned char>(what[0])), what + 1);
+            } else {
+                lua_pushfstring(L, "of %s ", p->what);
+            }
+            p->push_key(L);
+            if (p->owner != nullptr) {
+                lua_pushfstring(L, "of %s ", p->owner);
+            }
+        }
+        lua_concat(L, lua_gettop(L) - top);
+    }
+
+private:
+    void push_key(lua_State* L) const {
+        if (key == 0) {
+            lua_pushfstring(L, "%I ", number);
+            return;
+        }
+        switch (lua_type(L, key)) {
+        case LUA_TSTRING:
+            lua_pushfstring(L, "'%s' ", lua_tostring(L, key));
+            break;
+        case LUA_TNUMBER:
+            if (lua_isinteger(L, key)) {
+                lua_pushfstring(L, "%I ", lua_tointeger(L, key));
+            } else {
+                lua_pushfstring(L, "%f ", lua_tonumber(L, key));
+            }
+            break;
+        default:
+            lua_pushfstring(L, "(%s) ", luaL_typename(L, key));
+        }
+    }
+};
+
+// Error of a value_mirror conversion of the value at `at`, formatted once on the Lua stack: the name of the value,
+// see place::push_name, followed by the message formatted like reportError(L, ...).
+// Raised right away if the place allows it, thrown as stack_error otherwise.
+[[noreturn]] inline void reportError(lua_State* L, const place& at, const char* subject, const char* fmt, ...) {
+    at.push_name(L, subject);
+    std::va_list args;
+    va_start(args, fmt);
+    lua_pushvfstring(L, fmt, args);
     va_end(args);
-    throw error {buffer};
+    lua_concat(L, 2);
+    if (at.raise) {
+        lua_error(L);
+    }
+    throw stack_error {L};
 }
 
 } // namespace luabind
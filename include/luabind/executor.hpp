@@ -0,0 +1,221 @@
+#ifndef LUABIND_EXECUTOR_HPP
+#define LUABIND_EXECUTOR_HPP
+
+#include "lua.hpp"
+#include "idle_waiter.hpp"
+#include "mpmc_queue.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace luabind {
+
+// Runs jobs on a fixed set of worker threads, each owning its own state for its whole life.
+// Every worker creates its state and runs the initializer on its own thread at startup, e.g. with
+// luaL_openlibs and bindings or schema::attach, so states never move between threads.
+// Jobs given to submit() go to lock-free per worker queues round-robin, and an idle worker steals
+// from the queues of the others. Jobs given to submit_to() run on that worker only, for data kept in its state.
+// A job runs unprotected: Lua errors should be caught inside it, e.g. with lua_pcall or luaL_dostring,
+// exceptions thrown out of it are counted as failed.
+class executor {
+public:
+    using initializer = std::function<void(lua_State* L)>;
+    using job = std::function<void(lua_State* L)>;
+
+    struct stats {
+        size_t executed = 0;
+        // jobs run by a worker other than the one they were queued to
+        size_t stolen = 0;
+        // jobs which threw
+        size_t failed = 0;
+    };
+
+    // Starts `workers` threads and waits until their states are initialized.
+    // An exception thrown by `init` stops the workers and is rethrown.
+    // Every worker has two queues of `queue_capacity` jobs, submitting to a full queue waits.
+    executor(size_t workers, initializer init, size_t queue_capacity = 1024)
+        : _init(std::move(init)) {
+        if (workers == 0) {
+            throw std::invalid_argument("executor needs at least one worker");
+        }
+        _workers.reserve(workers);
+        for (size_t i = 0; i < workers; ++i) {
+            _workers.push_back(std::make_unique<worker>(queue_capacity));
+        }
+        std::latch ready(static_cast<std::ptrdiff_t>(workers));
+        for (size_t i = 0; i < workers; ++i) {
+            _workers[i]->thread = std::thread([this, i, &ready] { run(i, ready); });
+        }
+        ready.wait();
+        if (_init_error) {
+            stop();
+            std::rethrow_exception(_init_error);
+        }
+    }
+
+    executor(const executor&) = delete;
+    executor& operator=(const executor&) = delete;
+
+    // Runs the jobs already submitted, then closes the states.
+    ~executor() {
+        wait_idle();
+        stop();
+    }
+
+    // Queues a job for any worker.
+    void submit(job j) {
+        _pending.fetch_add(1, std::memory_order_relaxed);
+        const size_t n = _workers.size();
+        const size_t first = _next.fetch_add(1, std::memory_order_relaxed) % n;
+        for (;;) {
+            for (size_t k = 0; k < n; ++k) {
+                if (_workers[(first + k) % n]->shared.try_push(j)) {
+                    _idle.wake(false);
+                    return;
+                }
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    // Queues a job for the worker with index `worker_index`, no other worker takes it.
+    void submit_to(size_t worker_index, job j) {
+        if (worker_index >= _workers.size()) {
+            throw std::out_of_range("executor has no worker with such index");
+        }
+        _pending.fetch_add(1, std::memory_order_relaxed);
+        while (!_workers[worker_index]->pinned.try_push(j)) {
+            std::this_thread::yield();
+        }
+        // any sleeping worker can run a shared job, a pinned one needs its own worker awake
+        _idle.wake(true);
+    }
+
+    // Blocks until every job submitted so far has run.
+    void wait_idle() {
+        for (size_t pending = _pending.load(std::memory_order_acquire); pending != 0;
+             pending = _pending.load(std::memory_order_acquire)) {
+            _pending.wait(pending, std::memory_order_acquire);
+        }
+    }
+
+    size_t size() const {
+        return _workers.size();
+    }
+
+    stats get_stats() const {
+        stats total;
+        for (const auto& w : _workers) {
+            total.executed += w->executed.load(std::memory_order_relaxed);
+            total.stolen += w->stolen.load(std::memory_order_relaxed);
+            total.failed += w->failed.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+private:
+    struct worker {
+        explicit worker(size_t capacity)
+            : shared(capacity)
+            , pinned(capacity) {}
+
+        mpmc_queue<job> shared;
+        mpmc_queue<job> pinned;
+        std::thread thread;
+        // counters are written by the worker only
+        std::atomic<size_t> executed {0};
+        std::atomic<size_t> stolen {0};
+        std::atomic<size_t> failed {0};
+    };
+
+    void run(size_t index, std::latch& ready) {
+        lua_State* L = luaL_newstate();
+        try {
+            _init(L);
+            lua_settop(L, 0);
+        } catch (...) {
+            std::lock_guard lock(_init_mutex);
+            if (!_init_error) {
+                _init_error = std::current_exception();
+            }
+        }
+        ready.count_down();
+
+        worker& self = *_workers[index];
+        job j;
+        _idle.run([&] {
+            bool stolen = false;
+            if (!take(index, j, stolen)) {
+                return false;
+            }
+            execute(self, L, j, stolen);
+            return true;
+        });
+        lua_close(L);
+    }
+
+    // Own pinned queue first, then own shared queue, then the shared queues of the others.
+    bool take(size_t index, job& j, bool& stolen) {
+        worker& self = *_workers[index];
+        if (self.pinned.try_pop(j) || self.shared.try_pop(j)) {
+            return true;
+        }
+        const size_t n = _workers.size();
+        for (size_t k = 1; k < n; ++k) {
+            if (_workers[(index + k) % n]->shared.try_pop(j)) {
+                stolen = true;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void execute(worker& self, lua_State* L, job& j, bool stolen) {
+        try {
+            j(L);
+        } catch (...) {
+            self.failed.fetch_add(1, std::memory_order_relaxed);
+        }
+        lua_settop(L, 0);
+        j = nullptr;
+        self.executed.fetch_add(1, std::memory_order_relaxed);
+        if (stolen) {
+            self.stolen.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            _pending.notify_all();
+        }
+    }
+
+    void stop() {
+        _idle.stop();
+        for (const auto& w : _workers) {
+            if (w->thread.joinable()) {
+                w->thread.join();
+            }
+        }
+    }
+
+private:
+    const initializer _init;
+    std::vector<std::unique_ptr<worker>> _workers;
+    std::atomic<size_t> _next {0};
+    std::atomic<size_t> _pending {0};
+    idle_waiter _idle;
+    std::mutex _init_mutex;
+    std::exception_ptr _init_error;
+};
+
+} // namespace luabind
+
+#endif // LUABIND_EXECUTOR_HPP
@@ -0,0 +1,238 @@
+#ifndef LUABIND_FUNCTION_REF_HPP
+#define LUABIND_FUNCTION_REF_HPP
+
+#include "lua.hpp"
+#include "exception.hpp"
+#include "mirror.hpp"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace luabind {
+
+template <typename Signature>
+class function_ref;
+
+// Lua function called from C++. The function is looked up once and kept in a registry slot, released slots are
+// reused by luaL_ref. A call pushes the function and the arguments through value_mirror and runs it with
+// lua_pcall without a message handler, an error is thrown as luabind::error with the Lua message.
+// Calls run on the main thread of the state by default, `call(thread, ...)` runs them on another one,
+// e.g. from a C++ function called by a coroutine. The reference must not outlive the state.
+// R is void, a type supported by value_mirror or a std::tuple of them for several results.
+template <typename R, typename... Args>
+class function_ref<R(Args...)> {
+public:
+    function_ref() = default;
+
+    // Refers to the function at `idx`, reports an error if there is something else.
+    function_ref(lua_State* L, int idx) {
+        if (lua_type(L, idx) != LUA_TFUNCTION) [[unlikely]] {
+            reportError("Expecting a function, but got '%s'.", lua_typename(L, lua_type(L, idx)));
+        }
+        lua_pushvalue(L, idx);
+        _ref = luaL_ref(L, LUA_REGISTRYINDEX);
+        _L = main_thread(L);
+    }
+
+    // Refers to the global function `name`.
+    function_ref(lua_State* L, const char* name) {
+        if (lua_getglobal(L, name) != LUA_TFUNCTION) [[unlikely]] {
+            const char* type = lua_typename(L, lua_type(L, -1));
+            lua_pop(L, 1);
+            reportError("Global '%s' is not a function, but '%s'.", name, type);
+        }
+        _ref = luaL_ref(L, LUA_REGISTRYINDEX);
+        _L = main_thread(L);
+    }
+
+    function_ref(const function_ref& other)
+        : _L(other._L) {
+        if (_L != nullptr) {
+            other.push(_L);
+            _ref = luaL_ref(_L, LUA_REGISTRYINDEX);
+        }
+    }
+
+    function_ref(function_ref&& other) noexcept
+        : _L(std::exchange(other._L, nullptr))
+        , _ref(std::exchange(other._ref, LUA_NOREF)) {}
+
+    function_ref& operator=(const function_ref& other) {
+        if (this != &other) {
+            function_ref copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    function_ref& operator=(function_ref&& other) noexcept {
+        if (this != &other) {
+            reset();
+            _L = std::exchange(other._L, nullptr);
+            _ref = std::exchange(other._ref, LUA_NOREF);
+        }
+        return *this;
+    }
+
+    ~function_ref() {
+        reset();
+    }
+
+    void reset() {
+        if (_L != nullptr) {
+            luaL_unref(_L, LUA_REGISTRYINDEX, _ref);
+            _L = nullptr;
+            _ref = LUA_NOREF;
+        }
+    }
+
+    explicit operator bool() const {
+        return _L != nullptr;
+    }
+
+    lua_State* state() const {
+        return _L;
+    }
+
+    // Pushes the function to the stack of L, a thread of the state it was taken from.
+    void push(lua_State* L) const {
+        lua_rawgeti(L, LUA_REGISTRYINDEX, _ref);
+    }
+
+    R operator()(Args... args) const {
+        return call(_L, std::forward<Args>(args)...);
+    }
+
+    R call(lua_State* L, Args... args) const {
+        if (_L == nullptr) [[unlikely]] {
+            reportError("Calling an empty function_ref.");
+        }
+        if (!lua_checkstack(L, static_cast<int>(sizeof...(Args)) + result_count + 1)) [[unlikely]] {
+            reportError("Not enough Lua stack space to call a function with %d arguments.",
+                        static_cast<int>(sizeof...(Args)));
+        }
+        push(L);
+        (value_mirror<Args>::to_lua(L, std::forward<Args>(args)), ...);
+        if (lua_pcall(L, static_cast<int>(sizeof...(Args)), result_count, 0) != LUA_OK) [[unlikely]] {
+            raise(L);
+        }
+        if constexpr (result_count == 0) {
+            return;
+        } else {
+            // the stack is restored when leaving, also when a conversion throws
+            struct results_guard {
+                lua_State* L;
+                int top;
+
+                ~results_guard() {
+                    lua_settop(L, top);
+                }
+            } guard {L, lua_gettop(L) - result_count};
+            return results(L, std::make_index_sequence<result_count> {});
+        }
+    }
+
+private:
+    template <typename T>
+    struct result_traits {
+        static constexpr bool tuple = false;
+        static constexpr int count = 1;
+    };
+
+    template <typename... Ts>
+    struct result_traits<std::tuple<Ts...>> {
+        static constexpr bool tuple = true;
+        static constexpr int count = static_cast<int>(sizeof...(Ts));
+    };
+
+    static constexpr bool is_tuple = result_traits<R>::tuple;
+    static constexpr int result_count = std::is_void_v<R> ? 0 : result_traits<R>::count;
+
+    // results are popped before returning, a view of a Lua string would dangle
+    static_assert(!std::is_same_v<std::remove_cv_t<R>, std::string_view>, "Return std::string instead.");
+
+    static lua_State* main_thread(lua_State* L) {
+        lua_rawgeti(L, LUA_REGISTRYINDEX, LUA_RIDX_MAINTHREAD);
+        lua_State* main = lua_tothread(L, -1);
+        lua_pop(L, 1);
+        return main;
+    }
+
+    // `position` counts results from 1. Mirrors only check the outer shape of a value, errors of its parts,
+    // e.g. container elements, name the result too.
+    template <typename T>
+    static T result(lua_State* L, int position) {
+        const int idx = position - result_count - 1;
+        if (!mirror_matches<T>(L, idx)) [[unlikely]] {
+            reportError("Result %d of the Lua function has invalid type '%s'.",
+                        position,
+                        lua_typename(L, lua_type(L, idx)));
+        }
+        return mirror_from_lua<T>(L, place::result(idx, position, "the Lua function"));
+    }
+
+    template <size_t... Indices>
+    static R results(lua_State* L, std::index_sequence<Indices...>) {
+        if constexpr (is_tuple) {
+            return R {result<std::tuple_element_t<Indices, R>>(L, static_cast<int>(Indices) + 1)...};
+        } else {
+            return result<R>(L, 1);
+        }
+    }
+
+    [[noreturn]] static void raise(lua_State* L) {
+        size_t size = 0;
+        const char* message = lua_tolstring(L, -1, &size);
+        error e = message != nullptr ? error {std::string(message, size)}
+                                     : error {std::string("(error object is a ") + luaL_typename(L, -1) + " value)"};
+        lua_pop(L, 1);
+        throw e;
+    }
+
+private:
+    lua_State* _L = nullptr;
+    int _ref = LUA_NOREF;
+};
+
+template <typename R, typename... Args>
+struct value_mirror<function_ref<R(Args...)>> {
+    using type = function_ref<R(Args...)>;
+
+    static int to_lua(lua_State* L, const type& f) {
+        if (f) {
+            f.push(L);
+        } else {
+            lua_pushnil(L);
+        }
+        return 1;
+    }
+
+    static type from_lua(lua_State* L, const place& at) {
+        if (lua_type(L, at.idx) != LUA_TFUNCTION) [[unlikely]] {
+            reportError(L,
+                        at,
+                        "Argument",
+                        "has invalid type. Expecting 'function', but got '%s'.",
+                        lua_typename(L, lua_type(L, at.idx)));
+        }
+        return type {L, at.idx};
+    }
+
+    static bool matches(lua_State* L, int idx) {
+        return lua_type(L, idx) == LUA_TFUNCTION;
+    }
+};
+
+template <typename R, typename... Args>
+struct value_mirror<const function_ref<R(Args...)>> : value_mirror<function_ref<R(Args...)>> {};
+
+template <typename R, typename... Args>
+struct value_mirror<const function_ref<R(Args...)>&> : value_mirror<function_ref<R(Args...)>> {};
+
+} // namespace luabind
+
+#endif // LUABIND_FUNCTION_REF_HPP
@@ -0,0 +1,62 @@
+#ifndef LUABIND_IDLE_WAITER_HPP
+#define LUABIND_IDLE_WAITER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+namespace luabind {
+
+// Idle loop of threads taking work from lock-free queues: a thread spins a while over its queues,
+// then sleeps on an epoch counter until new work is signalled with wake() or the loop is stopped.
+class idle_waiter {
+public:
+    // Calls `poll` until it finds no work after stop(), `poll` returns whether it found work.
+    template <typename Poll>
+    void run(Poll&& poll) {
+        int idle = 0;
+        for (;;) {
+            // the epoch is read before the queues, so work queued after the check changes it and wakes the thread
+            const uint32_t epoch = _epoch.load(std::memory_order_acquire);
+            if (poll()) {
+                idle = 0;
+                continue;
+            }
+            if (_stopping.load(std::memory_order_acquire)) {
+                break;
+            }
+            if (++idle < spin_count) {
+                std::this_thread::yield();
+                continue;
+            }
+            _epoch.wait(epoch, std::memory_order_acquire);
+        }
+    }
+
+    // Wakes one sleeping thread, or all of them when only a specific one can take the work.
+    void wake(bool all) {
+        _epoch.fetch_add(1, std::memory_order_release);
+        if (all) {
+            _epoch.notify_all();
+        } else {
+            _epoch.notify_one();
+        }
+    }
+
+    // The threads finish the work already queued, then leave run().
+    void stop() {
+        _stopping.store(true, std::memory_order_release);
+        wake(true);
+    }
+
+private:
+    // a thread polls this many times before sleeping
+    static constexpr int spin_count = 64;
+
+    std::atomic<uint32_t> _epoch {0};
+    std::atomic<bool> _stopping {false};
+};
+
+} // namespace luabind
+
+#endif // LUABIND_IDLE_WAITER_HPP
@@ -0,0 +1,130 @@
+#ifndef LUABIND_LAZY_HPP
+#define LUABIND_LAZY_HPP
+
+#include "bind.hpp"
+#include "descriptor.hpp"
+
+#include <string>
+#include <typeindex>
+
+namespace luabind {
+
+using lazy_binder = void (*)(lua_State* L);
+
+// Tables with lazily bound classes: the global table and module tables.
+struct lazy_table {
+    // __index of a table with lazily bound classes. Upvalues are the pending classes of the table, name to type_id,
+    // and the __index the table had before, if any.
+    // The class is published again if the table lost it, e.g. when a state_pool restored the globals.
+    static int index(lua_State* L) {
+        lua_pushvalue(L, 2);
+        if (lua_rawget(L, lua_upvalueindex(1)) == LUA_TNUMBER) {
+            const auto id = static_cast<size_t>(lua_tointeger(L, -1));
+            type_info* info = type_storage::get_instance(L).materialize(L, id);
+            if (info == nullptr) [[unlikely]] {
+                raiseError(L, "Class '%s' has no binder.", lua_tostring(L, 2));
+            }
+            info->get_metatable(L);
+            lua_pushvalue(L, 2);
+            lua_pushvalue(L, -2);
+            lua_rawset(L, 1);
+            return 1;
+        }
+        lua_pop(L, 1);
+        switch (lua_type(L, lua_upvalueindex(2))) {
+        case LUA_TFUNCTION:
+            lua_pushvalue(L, lua_upvalueindex(2));
+            lua_pushvalue(L, 1);
+            lua_pushvalue(L, 2);
+            lua_call(L, 2, 1);
+            return 1;
+        case LUA_TNIL:
+            return 0;
+        default:
+            lua_pushvalue(L, 2);
+            lua_gettable(L, lua_upvalueindex(2));
+            return 1;
+        }
+    }
+
+    // Pushes the pending classes of the table at `idx`, installing index on first use.
+    static void push(lua_State* L, int idx) {
+        idx = lua_absindex(L, idx);
+        if (lua_rawgetp(L, LUA_REGISTRYINDEX, &tables_key) != LUA_TTABLE) {
+            lua_pop(L, 1);
+            lua_newtable(L);
+            lua_createtable(L, 0, 1);
+            lua_pushliteral(L, "k");
+            lua_setfield(L, -2, "__mode");
+            lua_setmetatable(L, -2);
+            lua_pushvalue(L, -1);
+            lua_rawsetp(L, LUA_REGISTRYINDEX, &tables_key);
+        }
+        lua_pushvalue(L, idx);
+        if (lua_rawget(L, -2) == LUA_TTABLE) {
+            lua_remove(L, -2);
+            return;
+        }
+        lua_pop(L, 1);
+        lua_newtable(L);
+        lua_pushvalue(L, idx);
+        lua_pushvalue(L, -2);
+        lua_rawset(L, -4);
+        lua_remove(L, -2); // tables by module
+
+        if (lua_getmetatable(L, idx) == 0) {
+            lua_newtable(L);
+            lua_pushvalue(L, -1);
+            lua_setmetatable(L, idx);
+        }
+        lua_pushvalue(L, -2);
+        lua_getfield(L, -2, "__index");
+        lua_pushcclosure(L, lua_function<index>::safe_invoke, 2);
+        lua_setfield(L, -2, "__index");
+        lua_pop(L, 1); // metatable
+    }
+
+private:
+    // table to its pending classes, with weak keys
+    static inline const char tables_key = 0;
+};
+
+// Records `bind`, which binds Type with class_ or a descriptor, without running it.
+// It runs the first time Lua reads `name` from the global table, or from the table at stack index `module`,
+// or when Type is needed from C++, e.g. as a base of a class being bound or to push an object.
+// A class published in a module is removed from the global table, where class_ puts it.
+// A type already bound or recorded is left as is.
+template <typename Type>
+void lazy_class(lua_State* L, const char* name, lazy_binder bind, int module = 0) {
+    type_storage& storage = type_storage::get_instance(L);
+    const size_t id = type_id<Type>();
+    if (storage.find_by_id(id) != nullptr || storage.is_lazy(id)) {
+        return;
+    }
+    if (module == 0) {
+        lua_pushglobaltable(L);
+    } else {
+        lua_pushvalue(L, module);
+    }
+    lazy_entry entry {bind, name, LUA_NOREF};
+    if (module != 0) {
+        lua_pushvalue(L, -1);
+        entry.module_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    }
+    lazy_table::push(L, -1);
+    lua_pushinteger(L, static_cast<lua_Integer>(id));
+    lua_setfield(L, -2, name);
+    lua_pop(L, 2);
+    storage.add_lazy(id, std::type_index(typeid(Type)), std::move(entry));
+}
+
+// lazy_class for a class described by descriptor::make, under its own name.
+template <const auto& descriptor>
+void lazy_bind(lua_State* L, int module = 0) {
+    using type = typename std::remove_cvref_t<decltype(descriptor)>::type;
+    lazy_class<type>(L, descriptor.name, [](lua_State* L) { bind<descriptor>(L); }, module);
+}
+
+} // namespace luabind
+
+#endif // LUABIND_LAZY_HPP
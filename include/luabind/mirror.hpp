@@ -6,11 +6,15 @@
 #include "type_storage.hpp"
 #include "user_data.hpp"
 
+#include <array>
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <typeindex>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace luabind {
 
@@ -24,11 +28,19 @@ struct value_mirror {
     template <typename... Args>
     static int to_lua(lua_State* L, Args&&... args) {
         static_assert(std::is_constructible_v<T, Args...>);
-        return lua_user_data<T>::to_lua(L, std::forward<Args>(args)...);
+        if constexpr (is_value_type_v<raw_type>) {
+            return value_user_data<raw_type>::to_lua(L, std::forward<Args>(args)...);
+        } else {
+            return lua_user_data<T>::to_lua(L, std::forward<Args>(args)...);
+        }
     }
 
-    static const T& from_lua(lua_State* L, int idx) {
-        return *(value_mirror<T*>::from_lua(L, idx));
+    static const T& from_lua(lua_State* L, const place& at) {
+        return *(value_mirror<T*>::from_lua(L, at));
+    }
+
+    static bool matches(lua_State* L, int idx) {
+        return value_mirror<T*>::matches(L, idx);
     }
 };
 
@@ -37,28 +49,69 @@ struct value_mirror<T*> {
     using type = T*;
     using raw_type = std::remove_cv_t<T>;
 
+    // value types have no reference semantics, Lua gets a copy of the value
     static int to_lua(lua_State* L, T* v) {
-        cpp_user_data<T>::to_lua(L, v);
-        return 1;
+        if constexpr (is_value_type_v<raw_type>) {
+            return value_user_data<raw_type>::to_lua(L, *v);
+        } else {
+            cpp_user_data<T>::to_lua(L, v);
+            return 1;
+        }
     }
 
-    static T* from_lua(lua_State* L, int idx) {
-        auto* ud = user_data::from_lua(L, idx);
+    static T* from_lua(lua_State* L, const place& at) {
+        if constexpr (is_value_type_v<raw_type>) {
+            return from_lua_value(L, at);
+        } else {
+            return from_lua_object(L, at);
+        }
+    }
+
+    // Cheap check whether from_lua would accept the value, used to pick an overload.
+    static bool matches(lua_State* L, int idx) {
+        if constexpr (is_value_type_v<raw_type>) {
+            return value_user_data<raw_type>::from_lua(L, idx) != nullptr;
+        } else {
+            auto* ud = user_data::from_lua(L, idx);
+            return ud != nullptr && ud->cast<T>() != nullptr;
+        }
+    }
+
+private:
+    static T* from_lua_object(lua_State* L, const place& at) {
+        auto* ud = user_data::from_lua(L, at.idx);
         if (ud == nullptr) [[unlikely]] {
-            reportError("Argument at %i has invalid type. Expecting user_data of type '%s', but got lua type '%s'",
-                        idx,
+            reportError(L,
+                        at,
+                        "Argument",
+                        "has invalid type. Expecting user_data of type '%s', but got lua type '%s'",
                         type_storage::type_name<T>(L).data(),
-                        lua_typename(L, lua_type(L, idx)));
+                        lua_typename(L, lua_type(L, at.idx)));
         }
-        auto p = dynamic_cast<T*>(ud->object);
+        auto p = ud->cast<T>();
         if (p == nullptr && ud->object != nullptr) [[unlikely]] {
-            reportError("Argument at %i has invalid type. Expecting '%s' but got '%s'.",
-                        idx,
+            reportError(L,
+                        at,
+                        "Argument",
+                        "has invalid type. Expecting '%s' but got '%s'.",
                         type_storage::type_name<T>(L).data(),
                         ud->info->name.c_str());
         }
         return p;
     }
+
+    static T* from_lua_value(lua_State* L, const place& at) {
+        raw_type* p = value_user_data<raw_type>::from_lua(L, at.idx);
+        if (p == nullptr) [[unlikely]] {
+            reportError(L,
+                        at,
+                        "Argument",
+                        "has invalid type. Expecting value of type '%s', but got lua type '%s'",
+                        type_storage::type_name<raw_type>(L).data(),
+                        lua_typename(L, lua_type(L, at.idx)));
+        }
+        return p;
+    }
 };
 
 template <typename T>
@@ -67,8 +120,12 @@ struct value_mirror<T&> {
         return value_mirror<T*>::to_lua(L, &v);
     }
 
-    static T& from_lua(lua_State* L, int idx) {
-        return *value_mirror<T*>::from_lua(L, idx);
+    static T& from_lua(lua_State* L, const place& at) {
+        return *value_mirror<T*>::from_lua(L, at);
+    }
+
+    static bool matches(lua_State* L, int idx) {
+        return value_mirror<T*>::matches(L, idx);
     }
 };
 
@@ -80,31 +137,87 @@ struct value_mirror<std::shared_ptr<T>> {
         return shared_user_data::to_lua(L, std::move(v));
     }
 
-    static type from_lua(lua_State* L, int idx) {
+    static type from_lua(lua_State* L, const place& at) {
+        const shared_user_data* sud = get_shared(L, at);
+        if (const type* exact = sud->get_if<T>()) [[likely]] {
+            return *exact;
+        }
+        return alias(L, at, sud);
+    }
+
+    static bool matches(lua_State* L, int idx) {
         auto* ud = user_data::from_lua(L, idx);
+        return ud != nullptr && ud->lifetime == memory_lifetime::shared && ud->cast<T>() != nullptr;
+    }
+
+    static const shared_user_data* get_shared(lua_State* L, const place& at) {
+        auto* ud = user_data::from_lua(L, at.idx);
         if (ud == nullptr) [[unlikely]] {
-            reportError("Argument at %i has invalid type. Expecting user_data of type '%s', but got lua type '%s'",
-                        idx,
+            reportError(L,
+                        at,
+                        "Argument",
+                        "has invalid type. Expecting user_data of type '%s', but got lua type '%s'",
                         type_storage::type_name<T>(L).data(),
-                        lua_typename(L, lua_type(L, idx)));
+                        lua_typename(L, lua_type(L, at.idx)));
         }
-        auto sud = dynamic_cast<shared_user_data*>(ud);
-        if (sud == nullptr) [[unlikely]] {
-            reportError("Argument at %i is not a shared_ptr.", idx);
+        if (ud->lifetime != memory_lifetime::shared) [[unlikely]] {
+            reportError(L, at, "Argument", "is not a shared_ptr.");
         }
-        auto r = std::dynamic_pointer_cast<T>(sud->data);
-        if (!r && sud->data) [[unlikely]] {
-            reportError("Argument at %i has invalid type. Expecing '%s' but got '%s'.",
-                        idx,
-                        type_storage::type_name<T>(L).data(),
-                        ud->info->name.c_str());
+        return static_cast<const shared_user_data*>(ud);
+    }
+
+    // shared_ptr<T> sharing ownership with the stored pointer of another element type
+    static type alias(lua_State* L, const place& at, const shared_user_data* sud) {
+        T* p = sud->cast<T>();
+        if (p == nullptr) {
+            if (sud->object != nullptr) [[unlikely]] {
+                reportError(L,
+                            at,
+                            "Argument",
+                            "has invalid type. Expecing '%s' but got '%s'.",
+                            type_storage::type_name<T>(L).data(),
+                            sud->info->name.c_str());
+            }
+            return nullptr;
         }
-        return r;
+        return type(sud->owner(), p);
     }
 };
 
+// Binds a `const std::shared_ptr<T>&` parameter for the duration of the call.
+// Refers to the shared_ptr stored in the userdata when its element type is exactly T,
+// so borrowing it does not touch the reference count.
 template <typename T>
-struct value_mirror<const std::shared_ptr<T>&> : value_mirror<std::shared_ptr<T>> {};
+class borrowed_shared_ptr {
+public:
+    explicit borrowed_shared_ptr(const std::shared_ptr<T>* stored)
+        : stored(stored) {}
+
+    explicit borrowed_shared_ptr(std::shared_ptr<T>&& alias)
+        : stored(nullptr)
+        , alias(std::move(alias)) {}
+
+    operator const std::shared_ptr<T>&() const {
+        return stored != nullptr ? *stored : alias;
+    }
+
+private:
+    const std::shared_ptr<T>* stored;
+    std::shared_ptr<T> alias;
+};
+
+template <typename T>
+struct value_mirror<const std::shared_ptr<T>&> : value_mirror<std::shared_ptr<T>> {
+    using base = value_mirror<std::shared_ptr<T>>;
+
+    static borrowed_shared_ptr<T> from_lua(lua_State* L, const place& at) {
+        const shared_user_data* sud = base::get_shared(L, at);
+        if (const std::shared_ptr<T>* exact = sud->get_if<T>()) [[likely]] {
+            return borrowed_shared_ptr<T>(exact);
+        }
+        return borrowed_shared_ptr<T>(base::alias(L, at, sud));
+    }
+};
 
 template <typename T>
 struct value_mirror<std::shared_ptr<T>&> {};
@@ -121,16 +234,22 @@ struct value_mirror<bool> {
         return 1;
     }
 
-    static bool from_lua(lua_State* L, int idx) {
-        int isb = lua_isboolean(L, idx);
+    static bool from_lua(lua_State* L, const place& at) {
+        int isb = lua_isboolean(L, at.idx);
         if (isb != 1) [[unlikely]] {
-            reportError("Argument at %i has invalid type. Expecting 'boolean', but got '%s'.",
-                        idx,
-                        lua_typename(L, lua_type(L, idx)));
+            reportError(L,
+                        at,
+                        "Argument",
+                        "has invalid type. Expecting 'boolean', but got '%s'.",
+                        lua_typename(L, lua_type(L, at.idx)));
         }
-        int r = lua_toboolean(L, idx);
+        int r = lua_toboolean(L, at.idx);
         return static_cast<bool>(r);
     }
+
+    static bool matches(lua_State* L, int idx) {
+        return lua_isboolean(L, idx);
+    }
 };
 
 template <typename T>
@@ -148,21 +267,33 @@ struct number_mirror {
         return 1;
     }
 
-    static raw_type from_lua(lua_State* L, int idx) {
+    static raw_type from_lua(lua_State* L, const place& at) {
         if constexpr (std::is_integral_v<raw_type>) {
-            if (0 == lua_isinteger(L, idx)) {
-                reportError("Argument at %i has invalid type. Expecting 'integer', but got '%s'.",
-                            idx,
-                            lua_typename(L, lua_type(L, idx)));
+            if (0 == lua_isinteger(L, at.idx)) {
+                reportError(L,
+                            at,
+                            "Argument",
+                            "has invalid type. Expecting 'integer', but got '%s'.",
+                            lua_typename(L, lua_type(L, at.idx)));
             }
-            return static_cast<raw_type>(lua_tointeger(L, idx));
+            return static_cast<raw_type>(lua_tointeger(L, at.idx));
         } else {
-            if (lua_type(L, idx) != LUA_TNUMBER) {
-                reportError("Argument at %i has invalid type. Expecting 'number', but got '%s'.",
-                            idx,
-                            lua_typename(L, lua_type(L, idx)));
+            if (lua_type(L, at.idx) != LUA_TNUMBER) {
+                reportError(L,
+                            at,
+                            "Argument",
+                            "has invalid type. Expecting 'number', but got '%s'.",
+                            lua_typename(L, lua_type(L, at.idx)));
             }
-            return static_cast<raw_type>(lua_tonumber(L, idx));
+            return static_cast<raw_type>(lua_tonumber(L, at.idx));
+        }
+    }
+
+    static bool matches(lua_State* L, int idx) {
+        if constexpr (std::is_integral_v<raw_type>) {
+            return lua_isinteger(L, idx);
+        } else {
+            return lua_type(L, idx) == LUA_TNUMBER;
         }
     }
 };
@@ -197,16 +328,22 @@ struct value_mirror<std::string_view> {
         return 1;
     }
 
-    static std::string_view from_lua(lua_State* L, int idx) {
-        if (lua_type(L, idx) != LUA_TSTRING) {
-            reportError("Argument at %i has invalid type. Expecting 'string', but got '%s'.",
-                        idx,
-                        lua_typename(L, lua_type(L, idx)));
+    static std::string_view from_lua(lua_State* L, const place& at) {
+        if (lua_type(L, at.idx) != LUA_TSTRING) {
+            reportError(L,
+                        at,
+                        "Argument",
+                        "has invalid type. Expecting 'string', but got '%s'.",
+                        lua_typename(L, lua_type(L, at.idx)));
         }
         size_t len;
-        const char* lv = lua_tolstring(L, idx, &len);
+        const char* lv = lua_tolstring(L, at.idx, &len);
         return std::string_view(lv, len);
     }
+
+    static bool matches(lua_State* L, int idx) {
+        return lua_type(L, idx) == LUA_TSTRING;
+    }
 };
 
 template <>
@@ -227,8 +364,12 @@ struct value_mirror<std::string> {
         return value_mirror<std::string_view>::to_lua(L, v);
     }
 
-    static std::string from_lua(lua_State* L, int idx) {
-        return std::string {value_mirror<std::string_view>::from_lua(L, idx)};
+    static std::string from_lua(lua_State* L, const place& at) {
+        return std::string {value_mirror<std::string_view>::from_lua(L, at)};
+    }
+
+    static bool matches(lua_State* L, int idx) {
+        return value_mirror<std::string_view>::matches(L, idx);
     }
 };
 
@@ -244,6 +385,27 @@ struct value_mirror<std::string*> {};
 template <>
 struct value_mirror<const std::string*> {};
 
+// Converts the value at `at` with value_mirror<T>. Mirrors which take a stack index instead of a place, e.g. ones
+// written for older versions, report their own errors, prefixed by the place of a value which is not an argument.
+template <typename T>
+decltype(auto) mirror_from_lua(lua_State* L, const place& at) {
+    if constexpr (requires { value_mirror<T>::from_lua(L, at); }) {
+        return value_mirror<T>::from_lua(L, at);
+    } else {
+        if (at.parent == nullptr && at.owner == nullptr) {
+            return value_mirror<T>::from_lua(L, at.idx);
+        }
+        try {
+            return value_mirror<T>::from_lua(L, at.idx);
+        } catch (const error& e) {
+            // no lua_error out of a handler, it would skip the destruction of the exception
+            place thrown = at;
+            thrown.raise = false;
+            reportError(L, thrown, "Argument", "is invalid: %s", e.what());
+        }
+    }
+}
+
 template <typename T, typename Y>
 struct value_mirror<std::pair<T, Y>> {
     using type = std::pair<T, Y>;
@@ -258,23 +420,224 @@ struct value_mirror<std::pair<T, Y>> {
         return 1;
     }
 
-    static type from_lua(lua_State* L, int idx) {
-        if (lua_istable(L, idx) == 0) {
-            reportError("Provided argument at %i for the pair is not a table.", idx);
+    static type from_lua(lua_State* L, const place& at) {
+        if (lua_istable(L, at.idx) == 0) {
+            reportError(L, at, "Provided argument", "for the pair is not a table.");
         }
-        if (lua_rawlen(L, idx) != 2) {
-            reportError("Provided table at %i for the pair value has invalid length.", idx);
+        if (lua_rawlen(L, at.idx) != 2) {
+            reportError(L, at, "Provided table", "for the pair value has invalid length.");
         }
-        lua_rawgeti(L, idx, 1);
-        T f = value_mirror<T>::from_lua(L, -1);
+        const int t = lua_absindex(L, at.idx);
+        // the first element is alive while the second one is converted
+        constexpr bool trivial = std::is_trivially_destructible_v<type>;
+        lua_rawgeti(L, t, 1);
+        T f = mirror_from_lua<T>(L, at.element(-1, 1, trivial));
         lua_pop(L, 1);
-        lua_rawgeti(L, idx, 2);
-        Y s = value_mirror<Y>::from_lua(L, -1);
+        lua_rawgeti(L, t, 2);
+        Y s = mirror_from_lua<Y>(L, at.element(-1, 2, trivial));
         lua_pop(L, 1);
         return {f, s};
     }
+
+    // elements are not inspected, a pair is told apart from other overloads by being a table
+    static bool matches(lua_State* L, int idx) {
+        return lua_istable(L, idx);
+    }
 };
 
+// Containers are converted to and from Lua tables, elements go through their own mirrors.
+// Tables are created presized and accessed raw, metamethods of passed tables are not invoked.
+
+template <typename T>
+struct value_mirror<std::vector<T>> {
+    using type = std::vector<T>;
+
+    static int to_lua(lua_State* L, const type& v) {
+        lua_createtable(L, static_cast<int>(v.size()), 0);
+        const int t = lua_gettop(L);
+        for (size_t i = 0; i < v.size(); ++i) {
+            value_mirror<T>::to_lua(L, v[i]);
+            lua_rawseti(L, t, static_cast<lua_Integer>(i + 1));
+        }
+        return 1;
+    }
+
+    static type from_lua(lua_State* L, const place& at) {
+        if (lua_istable(L, at.idx) == 0) {
+            reportError(L, at, "Provided argument", "for the vector is not a table.");
+        }
+        const int t = lua_absindex(L, at.idx);
+        const lua_Integer size = static_cast<lua_Integer>(lua_rawlen(L, t));
+        type r;
+        r.reserve(static_cast<size_t>(size));
+        for (lua_Integer i = 1; i <= size; ++i) {
+            lua_rawgeti(L, t, i);
+            r.push_back(mirror_from_lua<T>(L, at.element(-1, i, false)));
+            lua_pop(L, 1);
+        }
+        return r;
+    }
+
+    static bool matches(lua_State* L, int idx) {
+        return lua_istable(L, idx);
+    }
+};
+
+template <typename T, size_t N>
+struct value_mirror<std::array<T, N>> {
+    using type = std::array<T, N>;
+
+    static int to_lua(lua_State* L, const type& v) {
+        lua_createtable(L, static_cast<int>(N), 0);
+        const int t = lua_gettop(L);
+        for (size_t i = 0; i < N; ++i) {
+            value_mirror<T>::to_lua(L, v[i]);
+            lua_rawseti(L, t, static_cast<lua_Integer>(i + 1));
+        }
+        return 1;
+    }
+
+    static type from_lua(lua_State* L, const place& at) {
+        if (lua_istable(L, at.idx) == 0) {
+            reportError(L, at, "Provided argument", "for the array is not a table.");
+        }
+        const int t = lua_absindex(L, at.idx);
+        if (lua_rawlen(L, t) != N) {
+            reportError(L, at, "Provided table", "for the array has invalid length.");
+        }
+        type r;
+        for (size_t i = 0; i < N; ++i) {
+            const lua_Integer position = static_cast<lua_Integer>(i + 1);
+            lua_rawgeti(L, t, position);
+            r[i] = mirror_from_lua<T>(L, at.element(-1, position, std::is_trivially_destructible_v<type>));
+            lua_pop(L, 1);
+        }
+        return r;
+    }
+
+    static bool matches(lua_State* L, int idx) {
+        return lua_istable(L, idx);
+    }
+};
+
+// Maps are tables with the same keys and values.
+template <typename Map>
+struct map_mirror {
+    using type = Map;
+    using key_type = typename Map::key_type;
+    using mapped_type = typename Map::mapped_type;
+
+    static int to_lua(lua_State* L, const type& v) {
+        lua_createtable(L, 0, static_cast<int>(v.size()));
+        const int t = lua_gettop(L);
+        for (const auto& [key, value] : v) {
+            value_mirror<key_type>::to_lua(L, key);
+            value_mirror<mapped_type>::to_lua(L, value);
+            lua_rawset(L, t);
+        }
+        return 1;
+    }
+
+    static type from_lua(lua_State* L, const place& at) {
+        if (lua_istable(L, at.idx) == 0) {
+            reportError(L, at, "Provided argument", "for the map is not a table.");
+        }
+        const int t = lua_absindex(L, at.idx);
+        type r;
+        lua_pushnil(L);
+        while (lua_next(L, t) != 0) {
+            auto key = mirror_from_lua<key_type>(L, at.key_of(L, -2, false));
+            r.emplace(std::move(key), mirror_from_lua<mapped_type>(L, at.element_at_key(L, -1, -2, false)));
+            lua_pop(L, 1); // keep the key for lua_next
+        }
+        return r;
+    }
+
+    static bool matches(lua_State* L, int idx) {
+        return lua_istable(L, idx);
+    }
+};
+
+template <typename K, typename V>
+struct value_mirror<std::map<K, V>> : map_mirror<std::map<K, V>> {};
+
+template <typename K, typename V>
+struct value_mirror<std::unordered_map<K, V>> : map_mirror<std::unordered_map<K, V>> {};
+
+// Sets are tables with the elements as keys and `true` as values.
+template <typename Set>
+struct set_mirror {
+    using type = Set;
+    using key_type = typename Set::key_type;
+
+    static int to_lua(lua_State* L, const type& v) {
+        lua_createtable(L, 0, static_cast<int>(v.size()));
+        const int t = lua_gettop(L);
+        for (const auto& key : v) {
+            value_mirror<key_type>::to_lua(L, key);
+            lua_pushboolean(L, 1);
+            lua_rawset(L, t);
+        }
+        return 1;
+    }
+
+    // keys with false values are not members
+    static type from_lua(lua_State* L, const place& at) {
+        if (lua_istable(L, at.idx) == 0) {
+            reportError(L, at, "Provided argument", "for the set is not a table.");
+        }
+        const int t = lua_absindex(L, at.idx);
+        type r;
+        lua_pushnil(L);
+        while (lua_next(L, t) != 0) {
+            if (lua_toboolean(L, -1) != 0) {
+                r.insert(mirror_from_lua<key_type>(L, at.element_at_key(L, -2, -2, false)));
+            }
+            lua_pop(L, 1);
+        }
+        return r;
+    }
+
+    static bool matches(lua_State* L, int idx) {
+        return lua_istable(L, idx);
+    }
+};
+
+template <typename T>
+struct value_mirror<std::set<T>> : set_mirror<std::set<T>> {};
+
+template <typename T>
+struct value_mirror<std::unordered_set<T>> : set_mirror<std::unordered_set<T>> {};
+
+template <typename T>
+struct value_mirror<const std::vector<T>&> : value_mirror<std::vector<T>> {};
+
+template <typename T, size_t N>
+struct value_mirror<const std::array<T, N>&> : value_mirror<std::array<T, N>> {};
+
+template <typename K, typename V>
+struct value_mirror<const std::map<K, V>&> : value_mirror<std::map<K, V>> {};
+
+template <typename K, typename V>
+struct value_mirror<const std::unordered_map<K, V>&> : value_mirror<std::unordered_map<K, V>> {};
+
+template <typename T>
+struct value_mirror<const std::set<T>&> : value_mirror<std::set<T>> {};
+
+template <typename T>
+struct value_mirror<const std::unordered_set<T>&> : value_mirror<std::unordered_set<T>> {};
+
+// Whether the value at `idx` is accepted by value_mirror<T>, true for mirrors without a `matches` check,
+// leaving it to from_lua to report a mismatch.
+template <typename T>
+bool mirror_matches(lua_State* L, int idx) {
+    if constexpr (requires { value_mirror<T>::matches(L, idx); }) {
+        return value_mirror<T>::matches(L, idx);
+    } else {
+        return true;
+    }
+}
+
 } // namespace luabind
 
 #endif // LUABIND_MIRROR_HPP
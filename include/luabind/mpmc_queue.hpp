@@ -0,0 +1,98 @@
+#ifndef LUABIND_MPMC_QUEUE_HPP
+#define LUABIND_MPMC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace luabind {
+
+// Bounded lock-free queue for any number of producers and consumers (Dmitry Vyukov's design).
+// Every cell has a sequence number telling whether it is ready to be written or read in the current lap,
+// so producers and consumers only contend on their own position counter.
+template <typename T>
+class mpmc_queue {
+public:
+    // `capacity` is rounded up to a power of two
+    explicit mpmc_queue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size *= 2;
+        }
+        _mask = size - 1;
+        _cells = std::make_unique<cell[]>(size);
+        for (size_t i = 0; i < size; ++i) {
+            _cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    mpmc_queue(const mpmc_queue&) = delete;
+    mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+    // Returns false if the queue is full, `value` is left untouched then.
+    bool try_push(T& value) {
+        size_t pos = _enqueue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell& c = _cells[pos & _mask];
+            const size_t sequence = c.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    c.value = std::move(value);
+                    c.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = _enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Returns false if the queue is empty.
+    bool try_pop(T& value) {
+        size_t pos = _dequeue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell& c = _cells[pos & _mask];
+            const size_t sequence = c.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0) {
+                if (_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = std::move(c.value);
+                    c.value = T {};
+                    c.sequence.store(pos + _mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = _dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Approximate, the queue may change while it is read.
+    bool empty() const {
+        return _enqueue_pos.load(std::memory_order_relaxed) == _dequeue_pos.load(std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr size_t cache_line = 64;
+
+    struct cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<cell[]> _cells;
+    size_t _mask = 0;
+    alignas(cache_line) std::atomic<size_t> _enqueue_pos {0};
+    alignas(cache_line) std::atomic<size_t> _dequeue_pos {0};
+};
+
+} // namespace luabind
+
+#endif // LUABIND_MPMC_QUEUE_HPP
@@ -0,0 +1,448 @@
+#ifndef LUABIND_OFFLOAD_HPP
+#define LUABIND_OFFLOAD_HPP
+
+#include "lua.hpp"
+#include "exception.hpp"
+#include "idle_waiter.hpp"
+#include "mirror.hpp"
+#include "mpmc_queue.hpp"
+#include "traits.hpp"
+#include "wrapper.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace luabind {
+
+// Threads running offloaded calls. Implementations may run a job on any thread and at any time after submit(),
+// a test can e.g. keep the jobs and run them one by one on its own thread. Jobs don't throw.
+class offload_pool {
+public:
+    using job = std::function<void()>;
+
+    virtual ~offload_pool() = default;
+
+    virtual void submit(job j) = 0;
+};
+
+// Fixed set of worker threads taking jobs from one lock-free queue, shared by any number of states.
+class thread_pool final : public offload_pool {
+public:
+    // Submitting to a full queue of `queue_capacity` jobs waits.
+    explicit thread_pool(size_t threads, size_t queue_capacity = 1024)
+        : _queue(queue_capacity) {
+        if (threads == 0) {
+            throw std::invalid_argument("thread_pool needs at least one thread");
+        }
+        _threads.reserve(threads);
+        for (size_t i = 0; i < threads; ++i) {
+            _threads.emplace_back([this] { run(); });
+        }
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    // Runs the jobs already submitted, then joins the threads.
+    ~thread_pool() override {
+        _idle.stop();
+        for (std::thread& t : _threads) {
+            t.join();
+        }
+    }
+
+    void submit(job j) override {
+        while (!_queue.try_push(j)) {
+            std::this_thread::yield();
+        }
+        _idle.wake(false);
+    }
+
+    size_t size() const {
+        return _threads.size();
+    }
+
+private:
+    void run() {
+        job j;
+        _idle.run([&] {
+            if (!_queue.try_pop(j)) {
+                return false;
+            }
+            j();
+            j = nullptr;
+            return true;
+        });
+    }
+
+private:
+    mpmc_queue<job> _queue;
+    std::vector<std::thread> _threads;
+    idle_waiter _idle;
+};
+
+class offload_queue;
+
+// Call of an offloaded function, run by a pool thread while the calling coroutine waits.
+// The Lua arguments are kept in a registry table until the call is released, so objects and strings
+// the call refers to stay alive even if the coroutine is closed meanwhile.
+class offload_call : public pending_result {
+public:
+    // Set by the state's thread once it took the finished call from the queue, the call is never released before.
+    bool ready() const override {
+        return _polled;
+    }
+
+    // runs on a pool thread
+    void run();
+
+protected:
+    offload_call(lua_State* L, offload_queue* queue)
+        : _queue(queue) {
+        lua_rawgeti(L, LUA_REGISTRYINDEX, LUA_RIDX_MAINTHREAD);
+        _main = lua_tothread(L, -1);
+        lua_pop(L, 1);
+    }
+
+    ~offload_call() = default;
+
+    // calls the function and keeps its result
+    virtual void execute() = 0;
+
+    void rethrow_if_failed() const {
+        if (_error) [[unlikely]] {
+            std::rethrow_exception(_error);
+        }
+    }
+
+    // Keeps the `count` values at the bottom of the stack alive until the call is released.
+    void anchor(lua_State* L, int count) {
+        if (count == 0) {
+            return;
+        }
+        lua_createtable(L, count, 0);
+        for (int i = 1; i <= count; ++i) {
+            lua_pushvalue(L, i);
+            lua_rawseti(L, -2, i);
+        }
+        _anchor = luaL_ref(L, LUA_REGISTRYINDEX);
+    }
+
+    void unanchor() {
+        luaL_unref(_main, LUA_REGISTRYINDEX, _anchor);
+        _anchor = LUA_NOREF;
+    }
+
+private:
+    friend class offload_queue;
+
+    offload_queue* const _queue;
+    lua_State* _main = nullptr;
+    int _anchor = LUA_NOREF;
+    bool _polled = false;
+    std::exception_ptr _error;
+};
+
+// Connects a state to the pool running its offloaded calls, and brings their results back to the state's thread.
+// poll(), called by the state's thread, e.g. by its event loop, resumes the coroutines whose calls finished;
+// `notify` is called by the pool thread finishing a call, e.g. to wake the loop. The interpreter never blocks
+// on offloaded calls. The queue has to be destroyed before the state is closed, it waits for the calls still
+// running on the pool then, as they may use objects of the state.
+class offload_queue {
+public:
+    using notifier = std::function<void()>;
+
+    offload_queue(lua_State* L, offload_pool& pool, notifier notify = {})
+        : _L(L)
+        , _pool(pool)
+        , _notify(std::move(notify)) {
+        lua_pushlightuserdata(L, this);
+        lua_rawsetp(L, LUA_REGISTRYINDEX, &key);
+    }
+
+    offload_queue(const offload_queue&) = delete;
+    offload_queue& operator=(const offload_queue&) = delete;
+
+    // Finished calls which are not polled are released with the state.
+    ~offload_queue() {
+        lua_pushnil(_L);
+        lua_rawsetp(_L, LUA_REGISTRYINDEX, &key);
+        for (size_t running = _running.load(std::memory_order_acquire); running != 0;
+             running = _running.load(std::memory_order_acquire)) {
+            _running.wait(running, std::memory_order_acquire);
+        }
+        // the last finished call notifies holding the lock
+        std::lock_guard lock(_mutex);
+    }
+
+    // Queue attached to the state, or nullptr.
+    static offload_queue* find(lua_State* L) {
+        lua_rawgetp(L, LUA_REGISTRYINDEX, &key);
+        auto* queue = static_cast<offload_queue*>(lua_touserdata(L, -1));
+        lua_pop(L, 1);
+        return queue;
+    }
+
+    // Resumes the coroutines waiting for the calls finished so far, returns the number of the calls.
+    size_t poll() {
+        std::vector<offload_call*> finished;
+        {
+            std::lock_guard lock(_mutex);
+            finished.swap(_finished);
+        }
+        for (offload_call* call : finished) {
+            call->_polled = true;
+            if (!call->complete()) {
+                // the coroutine was closed
+                call->release();
+            }
+        }
+        return finished.size();
+    }
+
+    // calls submitted and not polled yet
+    size_t pending() const {
+        std::lock_guard lock(_mutex);
+        return _running.load(std::memory_order_relaxed) + _finished.size();
+    }
+
+    // Runs the call on the pool, releases it if the pool rejects it.
+    void submit(offload_call* call) {
+        {
+            std::lock_guard lock(_mutex);
+            _running.fetch_add(1, std::memory_order_relaxed);
+        }
+        try {
+            _pool.submit([call] { call->run(); });
+        } catch (...) {
+            finished(nullptr);
+            call->release();
+            throw;
+        }
+    }
+
+private:
+    friend class offload_call;
+
+    // called by the pool thread, `call` is null for a call which was not run
+    void finished(offload_call* call) {
+        if (call != nullptr) {
+            {
+                std::lock_guard lock(_mutex);
+                _finished.push_back(call);
+            }
+            if (_notify) {
+                _notify();
+            }
+        }
+        // the queue may be destroyed as soon as the lock is released
+        std::lock_guard lock(_mutex);
+        if (_running.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            _running.notify_all();
+        }
+    }
+
+    static inline const char key = 0;
+
+    lua_State* const _L;
+    offload_pool& _pool;
+    const notifier _notify;
+    mutable std::mutex _mutex;
+    std::vector<offload_call*> _finished;
+    // calls submitted and not finished, changed holding the lock
+    std::atomic<size_t> _running {0};
+};
+
+inline void offload_call::run() {
+    try {
+        execute();
+    } catch (...) {
+        _error = std::current_exception();
+    }
+    // the mutex of the queue publishes the result to the state's thread
+    _queue->finished(this);
+}
+
+// What an offloaded call keeps of an argument: objects passed by pointer or reference are shared with the pool
+// thread, everything else is a copy made on the Lua thread.
+template <typename Arg>
+using offload_arg_t =
+    std::conditional_t<std::is_lvalue_reference_v<Arg> &&
+                           std::is_reference_v<decltype(value_mirror<Arg>::from_lua(nullptr, 0))>,
+                       decltype(value_mirror<Arg>::from_lua(nullptr, 0)),
+                       std::remove_cvref_t<Arg>>;
+
+// Whether a kept argument owns its value, so the Lua value it was converted from doesn't need to stay alive.
+template <typename Kept>
+inline constexpr bool offload_arg_owned_v =
+    std::is_arithmetic_v<Kept> || std::is_enum_v<Kept> || std::is_same_v<Kept, std::string>;
+
+// Offloaded call of `f` with the arguments converted by the state's thread.
+// Lua arguments are anchored when `f` refers to one of them, e.g. the object of a method or a string_view.
+template <typename R, typename F, bool Anchored, typename... Args>
+class offload_call_of final : public offload_call {
+    static_assert(!std::is_reference_v<R>, "Offloaded functions return values, references would be shared.");
+
+public:
+    offload_call_of(lua_State* L, offload_queue* queue, F f, offload_arg_t<Args>... args)
+        : offload_call(L, queue)
+        , _f(std::move(f))
+        , _args(std::forward<offload_arg_t<Args>>(args)...) {
+        if constexpr (Anchored) {
+            anchor(L, lua_gettop(L));
+        }
+    }
+
+    int push_results(lua_State* L) override {
+        rethrow_if_failed();
+        if constexpr (std::is_void_v<R>) {
+            return 0;
+        } else {
+            return value_mirror<R>::to_lua(L, std::move(*_result));
+        }
+    }
+
+    void release() override {
+        unanchor();
+        delete this;
+    }
+
+private:
+    void execute() override {
+        std::apply(
+            [this](auto&... args) {
+                if constexpr (std::is_void_v<R>) {
+                    _f(static_cast<Args&&>(args)...);
+                } else {
+                    _result.emplace(_f(static_cast<Args&&>(args)...));
+                }
+            },
+            _args);
+    }
+
+    F _f;
+    std::tuple<offload_arg_t<Args>...> _args;
+    std::optional<std::conditional_t<std::is_void_v<R>, std::tuple<>, R>> _result;
+};
+
+// Checks that an offloaded call can wait for its result, returns the queue of the state.
+inline offload_queue* offload_queue_of(lua_State* L) {
+    if (lua_isyieldable(L) == 0) [[unlikely]] {
+        raiseError(L, "The function has to wait for its result, it can only be called from a coroutine.");
+    }
+    offload_queue* queue = offload_queue::find(L);
+    if (queue == nullptr) [[unlikely]] {
+        raiseError(L, "The function is offloaded, but no offload_queue is attached to the state.");
+    }
+    return queue;
+}
+
+// Submits the call and leaves it for lua_function to wait for, see pending_results.
+inline int offload_start(lua_State* L, offload_queue* queue, offload_call* call) {
+    queue->submit(call);
+    lua_pushlightuserdata(L, static_cast<pending_result*>(call));
+    return pending_results;
+}
+
+template <typename F, F f>
+struct offload_wrapper;
+
+template <typename R, typename T, typename... Args, R (T::*func)(Args...)>
+struct offload_wrapper<R (T::*)(Args...), func> {
+    static_assert(std::conjunction_v<valid_lua_arg<R>, valid_lua_arg<Args>...>);
+
+    static int invoke(lua_State* L) {
+        return indexed_call_helper(L, index_sequence<2, sizeof...(Args)> {});
+    }
+
+    template <size_t... Indices>
+    static int indexed_call_helper(lua_State* L, std::index_sequence<Indices...>) {
+        int num_args = lua_gettop(L);
+        if (num_args != sizeof...(Args) + 1) {
+            raiseError(L,
+                       "Invalid number of arguments, should be %d, but %d were given.",
+                       static_cast<int>(sizeof...(Args)),
+                       num_args - 1);
+        }
+        offload_queue* queue = offload_queue_of(L);
+        auto call = [self = value_mirror<T*>::from_lua(L, 1)](Args... args) -> R {
+            return (self->*func)(std::forward<Args>(args)...);
+        };
+        using call_type = offload_call_of<R, decltype(call), true, Args...>;
+        return offload_start(L, queue, new call_type(L, queue, call, value_mirror<Args>::from_lua(L, Indices)...));
+    }
+};
+
+template <typename R, typename T, typename... Args, R (T::*func)(Args...) const>
+struct offload_wrapper<R (T::*)(Args...) const, func> {
+    static_assert(std::conjunction_v<valid_lua_arg<R>, valid_lua_arg<Args>...>);
+
+    static int invoke(lua_State* L) {
+        return indexed_call_helper(L, index_sequence<2, sizeof...(Args)> {});
+    }
+
+    template <size_t... Indices>
+    static int indexed_call_helper(lua_State* L, std::index_sequence<Indices...>) {
+        int num_args = lua_gettop(L);
+        if (num_args != sizeof...(Args) + 1) {
+            raiseError(L,
+                       "Invalid number of arguments, should be %d, but %d were given.",
+                       static_cast<int>(sizeof...(Args)),
+                       num_args - 1);
+        }
+        offload_queue* queue = offload_queue_of(L);
+        auto call = [self = value_mirror<const T*>::from_lua(L, 1)](Args... args) -> R {
+            return (self->*func)(std::forward<Args>(args)...);
+        };
+        using call_type = offload_call_of<R, decltype(call), true, Args...>;
+        return offload_start(L, queue, new call_type(L, queue, call, value_mirror<Args>::from_lua(L, Indices)...));
+    }
+};
+
+template <typename R, typename... Args, R (*func)(Args...)>
+struct offload_wrapper<R (*)(Args...), func> {
+    static_assert(std::conjunction_v<valid_lua_arg<R>, valid_lua_arg<Args>...>);
+
+    static int invoke(lua_State* L) {
+        return indexed_call_helper(L, index_sequence<1, sizeof...(Args)> {});
+    }
+
+    template <size_t... Indices>
+    static int indexed_call_helper(lua_State* L, std::index_sequence<Indices...>) {
+        int num_args = lua_gettop(L);
+        if (num_args != sizeof...(Args)) {
+            raiseError(L,
+                       "Invalid number of arguments, should be %d, but %d were given.",
+                       static_cast<int>(sizeof...(Args)),
+                       num_args);
+        }
+        offload_queue* queue = offload_queue_of(L);
+        constexpr bool anchored = !(offload_arg_owned_v<offload_arg_t<Args>> && ...);
+        auto call = [](Args... args) -> R { return (*func)(std::forward<Args>(args)...); };
+        using call_type = offload_call_of<R, decltype(call), anchored, Args...>;
+        return offload_start(L, queue, new call_type(L, queue, call, value_mirror<Args>::from_lua(L, Indices)...));
+    }
+};
+
+// Binding policy running a function or method on the pool of the state's offload_queue, e.g.
+// luabind::function<luabind::offload<&hash>>(L, "hash") or .function<luabind::offload<&Image::blur>>("blur").
+// Lua arguments are converted on the state's thread, then the calling coroutine waits for the result
+// without blocking the interpreter.
+template <auto func>
+inline constexpr lua_CFunction offload = &offload_wrapper<decltype(func), func>::invoke;
+
+} // namespace luabind
+
+#endif // LUABIND_OFFLOAD_HPP
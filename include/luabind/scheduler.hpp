@@ -0,0 +1,731 @@
+#ifndef LUABIND_SCHEDULER_HPP
+#define LUABIND_SCHEDULER_HPP
+
+#include "lua.hpp"
+#include "exception.hpp"
+#include "offload.hpp"
+#include "wrapper.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#endif // __linux__
+
+namespace luabind {
+
+struct wheel_timer;
+
+struct wheel_slot {
+    wheel_timer* head = nullptr;
+    wheel_timer* tail = nullptr;
+};
+
+// Timer linked into a slot of a timer_wheel.
+struct wheel_timer {
+    uint64_t expires = 0;
+    wheel_timer* prev = nullptr;
+    wheel_timer* next = nullptr;
+    // slot holding the timer, null if not armed
+    wheel_slot* slot = nullptr;
+    uint8_t level = 0;
+};
+
+// Hierarchical timing wheel (Varghese and Lauck): 4 levels of 256 slots, where a slot of level l covers 256^l ticks.
+// Adding and removing a timer is O(1). Timers of a higher level are moved down when the lower levels wrap,
+// so every timer is moved at most 3 times. Timers due within the same tick fire in the order they were added.
+// Ticks are skipped up to the next wrap of the lowest level holding timers.
+class timer_wheel {
+public:
+    static constexpr int slot_bits = 8;
+    static constexpr int level_count = 4;
+    static constexpr uint64_t slot_count = uint64_t(1) << slot_bits;
+    // longer delays are clamped
+    static constexpr uint64_t max_delay = (uint64_t(1) << (slot_bits * level_count)) - 1;
+
+    // the last tick advanced to, timers due by then have fired
+    uint64_t tick() const {
+        return _tick;
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+    // Arms a timer which is not armed, due at tick `expires`, at the next tick at the earliest.
+    void add(wheel_timer* t, uint64_t expires) {
+        t->expires = std::clamp(expires, _tick + 1, _tick + max_delay);
+        place(t);
+        ++_size;
+    }
+
+    void remove(wheel_timer* t) {
+        if (t->slot == nullptr) {
+            return;
+        }
+        unlink(t);
+        --_size;
+    }
+
+    // Advances to tick `to` one tick at a time and calls `fire` with every timer due, in order of expiry.
+    template <typename F>
+    void advance(uint64_t to, F&& fire) {
+        while (_tick < to) {
+            if (_size == 0) {
+                _tick = to;
+                return;
+            }
+            const int lowest = lowest_level();
+            if (lowest > 0) {
+                // nothing fires or moves down before the next wrap of that level
+                const uint64_t skipped = std::min(_tick | level_mask(lowest), to);
+                if (skipped > _tick) {
+                    _tick = skipped;
+                    continue;
+                }
+            }
+            ++_tick;
+            int top = 0;
+            while (top + 1 < level_count && (_tick & level_mask(top + 1)) == 0) {
+                ++top;
+            }
+            for (int level = top; level > 0; --level) {
+                cascade(level);
+            }
+            wheel_slot& due = _slots[0][_tick & (slot_count - 1)];
+            wheel_timer* t = due.head;
+            due = {};
+            while (t != nullptr) {
+                wheel_timer* next = t->next;
+                t->prev = t->next = nullptr;
+                t->slot = nullptr;
+                --_size;
+                --_counts[0];
+                fire(t);
+                t = next;
+            }
+        }
+    }
+
+    // Tick by which advance() should be called: the next expiry, or the next time higher levels move down.
+    std::optional<uint64_t> next_check() const {
+        if (_size == 0) {
+            return std::nullopt;
+        }
+        if (const int lowest = lowest_level(); lowest > 0) {
+            return (_tick | level_mask(lowest)) + 1;
+        }
+        for (uint64_t t = _tick + 1;; ++t) {
+            if (_slots[0][t & (slot_count - 1)].head != nullptr || (t & (slot_count - 1)) == 0) {
+                return t;
+            }
+        }
+    }
+
+private:
+    static constexpr uint64_t level_mask(int level) {
+        return (uint64_t(1) << (slot_bits * level)) - 1;
+    }
+
+    // lowest level holding timers, the top one if none does
+    int lowest_level() const {
+        int level = 0;
+        while (level + 1 < level_count && _counts[level] == 0) {
+            ++level;
+        }
+        return level;
+    }
+
+    void place(wheel_timer* t) {
+        const uint64_t delay = t->expires - _tick;
+        int level = 0;
+        while (level + 1 < level_count && delay > level_mask(level + 1)) {
+            ++level;
+        }
+        wheel_slot& slot = _slots[level][(t->expires >> (slot_bits * level)) & (slot_count - 1)];
+        t->slot = &slot;
+        t->level = static_cast<uint8_t>(level);
+        ++_counts[level];
+        t->prev = slot.tail;
+        t->next = nullptr;
+        if (slot.tail != nullptr) {
+            slot.tail->next = t;
+        } else {
+            slot.head = t;
+        }
+        slot.tail = t;
+    }
+
+    void unlink(wheel_timer* t) {
+        wheel_slot& slot = *t->slot;
+        (t->prev != nullptr ? t->prev->next : slot.head) = t->next;
+        (t->next != nullptr ? t->next->prev : slot.tail) = t->prev;
+        --_counts[t->level];
+        t->prev = t->next = nullptr;
+        t->slot = nullptr;
+    }
+
+    // Moves the timers of the current slot of `level` to the lower levels.
+    void cascade(int level) {
+        wheel_slot& slot = _slots[level][(_tick >> (slot_bits * level)) & (slot_count - 1)];
+        wheel_timer* t = slot.head;
+        slot = {};
+        while (t != nullptr) {
+            wheel_timer* next = t->next;
+            --_counts[level];
+            place(t);
+            t = next;
+        }
+    }
+
+    std::array<std::array<wheel_slot, slot_count>, level_count> _slots {};
+    // timers per level
+    std::array<size_t, level_count> _counts {};
+    uint64_t _tick = 0;
+    size_t _size = 0;
+};
+
+struct scheduler_options {
+    // coroutines resumed by one tick at most, the others keep their place in the queue for the next ticks
+    size_t budget = 1024;
+    // length of a timer tick
+    std::chrono::steady_clock::duration resolution = std::chrono::milliseconds(1);
+    // global table of the Lua functions, none if null
+    const char* global = "scheduler";
+    // time source, e.g. a manual clock in tests
+    std::function<std::chrono::steady_clock::time_point()> now = &std::chrono::steady_clock::now;
+};
+
+// Runs the coroutines of one state from an event loop. Coroutines are spawned from C++ or with scheduler.spawn,
+// wait with scheduler.sleep(seconds), scheduler.yield() and, on Linux, scheduler.wait_readable(fd) and
+// scheduler.wait_writable(fd) through epoll. Ready coroutines are resumed in FIFO order, at most `budget` per tick,
+// and a coroutine made ready during a tick runs in a later one. Sleeps go through a timer_wheel.
+// A finished coroutine's thread is reset with lua_closethread and reused by the next spawn.
+// A plain coroutine.yield() gives way to the others like scheduler.yield(). A coroutine waiting for a task or
+// an offloaded call is left out of the ready queue until the result is ready. Every tick polls the offload_queue
+// attached to the state; passing notify() as its notifier wakes a sleeping run() when a call finishes.
+// Errors of coroutines are reported with lua_warning. One scheduler per state, it has to be destroyed before
+// the state is closed.
+class scheduler final : public coroutine_loop {
+public:
+    using clock = std::chrono::steady_clock;
+
+    struct stats {
+        size_t spawned = 0;
+        size_t resumed = 0;
+        // coroutines which ended with an error
+        size_t failed = 0;
+        // threads created, the others were reused
+        size_t threads = 0;
+    };
+
+    explicit scheduler(lua_State* L, scheduler_options options = {})
+        : _options(std::move(options))
+        , _start(_options.now()) {
+        lua_rawgeti(L, LUA_REGISTRYINDEX, LUA_RIDX_MAINTHREAD);
+        _L = lua_tothread(L, -1);
+        lua_pop(L, 1);
+#ifdef __linux__
+        _epoll = epoll_create1(EPOLL_CLOEXEC);
+        if (_epoll < 0) {
+            throw std::runtime_error(std::string("epoll_create1 failed: ") + std::strerror(errno));
+        }
+        _wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epoll_event event {};
+        event.events = EPOLLIN;
+        event.data.fd = _wakeup;
+        if (_wakeup < 0 || epoll_ctl(_epoll, EPOLL_CTL_ADD, _wakeup, &event) != 0) {
+            const int error = errno;
+            if (_wakeup >= 0) {
+                close(_wakeup);
+            }
+            close(_epoll);
+            throw std::runtime_error(std::string("eventfd failed: ") + std::strerror(error));
+        }
+#endif // __linux__
+        lua_pushlightuserdata(L, this);
+        lua_rawsetp(L, LUA_REGISTRYINDEX, &key);
+        attach(L);
+        if (_options.global != nullptr) {
+            push_library(L);
+            lua_setglobal(L, _options.global);
+        }
+    }
+
+    scheduler(const scheduler&) = delete;
+    scheduler& operator=(const scheduler&) = delete;
+
+    // Coroutines still waiting are dropped, without running their to-be-closed variables.
+    ~scheduler() {
+        lua_pushnil(_L);
+        lua_rawsetp(_L, LUA_REGISTRYINDEX, &key);
+        detach(_L);
+        for (const auto& f : _fibers) {
+            luaL_unref(_L, LUA_REGISTRYINDEX, f->ref);
+        }
+#ifdef __linux__
+        close(_wakeup);
+        close(_epoll);
+#endif // __linux__
+    }
+
+    // Pushes a table of the Lua functions, for another name than the global.
+    static void push_library(lua_State* L) {
+        lua_createtable(L, 0, 6);
+        lua_pushcfunction(L, lua_function<&spawn_>::safe_invoke);
+        lua_setfield(L, -2, "spawn");
+        lua_pushcfunction(L, lua_function<&sleep_>::safe_invoke);
+        lua_setfield(L, -2, "sleep");
+        lua_pushcfunction(L, lua_function<&yield_>::safe_invoke);
+        lua_setfield(L, -2, "yield");
+        lua_pushcfunction(L, lua_function<&now_>::safe_invoke);
+        lua_setfield(L, -2, "now");
+#ifdef __linux__
+        lua_pushcfunction(L, lua_function<&wait_readable_>::safe_invoke);
+        lua_setfield(L, -2, "wait_readable");
+        lua_pushcfunction(L, lua_function<&wait_writable_>::safe_invoke);
+        lua_setfield(L, -2, "wait_writable");
+#endif // __linux__
+    }
+
+    // Spawns a coroutine calling the function below the `nargs` arguments on top of the stack of L,
+    // a thread of the scheduler's state, and pops them. The coroutine starts with the next tick.
+    void spawn(lua_State* L, int nargs = 0) {
+        fiber* f = nullptr;
+        if (!_idle.empty()) {
+            f = _idle.back();
+            _idle.pop_back();
+        } else {
+            auto created = std::make_unique<fiber>();
+            created->thread = lua_newthread(L);
+            created->ref = luaL_ref(L, LUA_REGISTRYINDEX);
+            f = created.get();
+            _threads.emplace(f->thread, f);
+            _fibers.push_back(std::move(created));
+            ++_stats.threads;
+        }
+        lua_xmove(L, f->thread, nargs + 1);
+        f->started = false;
+        ++_live;
+        ++_stats.spawned;
+        make_ready(f);
+    }
+
+    // Runs one tick: fires the timers due, takes the fd events and the finished offloaded calls, then resumes
+    // the ready coroutines within the budget. With `wait`, sleeps until the next timer, fd event or notify() first
+    // if no coroutine is ready. Returns the number of coroutines resumed.
+    size_t run_once(bool wait = false) {
+        fire_timers();
+        int timeout = 0;
+        if (wait && _ready.empty()) {
+            timeout = wait_timeout();
+        }
+        poll(timeout);
+        if (timeout != 0) {
+            fire_timers();
+        }
+        if (offload_queue* queue = offload_queue::find(_L)) {
+            queue->poll();
+        }
+        return resume_ready();
+    }
+
+    // Wakes the loop sleeping in run_once(true), from any thread, e.g. as the notifier of the offload_queue.
+    void notify() {
+#ifdef __linux__
+        const uint64_t one = 1;
+        // a full counter wakes the loop as well
+        [[maybe_unused]] const ssize_t written = write(_wakeup, &one, sizeof(one));
+#else
+        _notified.store(true, std::memory_order_release);
+        _notified.notify_one();
+#endif // __linux__
+    }
+
+    // Runs ticks until every coroutine has finished or stop() is called.
+    void run() {
+        _stopping = false;
+        while (!_stopping && _live != 0) {
+            run_once(true);
+        }
+    }
+
+    // Makes run() return after the current tick, e.g. from a bound function.
+    void stop() {
+        _stopping = true;
+    }
+
+    // coroutines spawned and not finished
+    size_t size() const {
+        return _live;
+    }
+
+    // entries of the ready queue, including coroutines which went waiting after being queued
+    size_t ready() const {
+        return _ready.size();
+    }
+
+    stats get_stats() const {
+        return _stats;
+    }
+
+    // time since the scheduler was created, as seen by its clock
+    clock::duration elapsed() const {
+        return _options.now() - _start;
+    }
+
+    // Scheduler of the state, or nullptr.
+    static scheduler* find(lua_State* L) {
+        lua_rawgetp(L, LUA_REGISTRYINDEX, &key);
+        auto* s = static_cast<scheduler*>(lua_touserdata(L, -1));
+        lua_pop(L, 1);
+        return s;
+    }
+
+private:
+    // pending: waiting for a task or an offloaded call, see coroutine_loop
+    enum class fiber_state : uint8_t { idle, ready, running, sleeping, reading, writing, pending };
+
+    struct fiber : wheel_timer {
+        lua_State* thread = nullptr;
+        int ref = LUA_NOREF;
+        int fd = -1;
+        fiber_state state = fiber_state::idle;
+        // in the ready queue, maybe with another state if it went waiting after that
+        bool queued = false;
+        bool started = false;
+    };
+
+    void make_ready(fiber* f) {
+        f->state = fiber_state::ready;
+        if (!f->queued) {
+            f->queued = true;
+            _ready.push_back(f);
+        }
+    }
+
+    uint64_t current_tick() const {
+        return static_cast<uint64_t>(std::max<clock::rep>(0, elapsed() / _options.resolution));
+    }
+
+    void fire_timers() {
+        _timers.advance(current_tick(), [this](wheel_timer* t) { make_ready(static_cast<fiber*>(t)); });
+    }
+
+    // milliseconds until the next timer, -1 without timers
+    int wait_timeout() const {
+        const std::optional<uint64_t> next = _timers.next_check();
+        if (!next) {
+            return -1;
+        }
+        const clock::duration left = _start + static_cast<clock::rep>(*next) * _options.resolution - _options.now();
+        if (left <= clock::duration::zero()) {
+            return 0;
+        }
+        const auto ms = std::chrono::ceil<std::chrono::milliseconds>(left).count();
+        return static_cast<int>(std::min<decltype(ms)>(ms, 1000 * 60 * 60));
+    }
+
+    size_t resume_ready() {
+        size_t resumed = 0;
+        for (size_t count = std::min(_ready.size(), _options.budget); count != 0; --count) {
+            fiber* f = _ready.front();
+            _ready.pop_front();
+            f->queued = false;
+            if (f->state == fiber_state::ready) {
+                resume(f);
+                ++resumed;
+            }
+        }
+        return resumed;
+    }
+
+    void resume(fiber* f) {
+        lua_State* co = f->thread;
+        int nargs = 0;
+        if (f->started) {
+            if (lua_status(co) != LUA_YIELD) {
+                // finished while resumed by somebody else, e.g. a completed task
+                recycle(f);
+                return;
+            }
+        } else {
+            nargs = lua_gettop(co) - 1;
+            f->started = true;
+        }
+        f->state = fiber_state::running;
+        int results = 0;
+        const int status = lua_resume(co, _L, nargs, &results);
+        ++_stats.resumed;
+        if (status == LUA_YIELD) {
+            lua_pop(co, results);
+            if (f->state == fiber_state::running) {
+                // yielded by coroutine.yield
+                make_ready(f);
+            }
+            return;
+        }
+        if (status != LUA_OK) {
+            ++_stats.failed;
+            lua_warning(_L, "error in scheduled coroutine (", 1);
+            lua_warning(_L, lua_isstring(co, -1) ? lua_tostring(co, -1) : "no message", 1);
+            lua_warning(_L, ")", 0);
+        }
+        recycle(f);
+    }
+
+    // Resets the thread of a finished coroutine for the next spawn.
+    void recycle(fiber* f) {
+#if LUA_VERSION_RELEASE_NUM >= 50406
+        lua_closethread(f->thread, _L);
+#else
+        lua_resetthread(f->thread);
+#endif
+        // the reset keeps the error object of a failed coroutine
+        lua_settop(f->thread, 0);
+        f->state = fiber_state::idle;
+        f->started = false;
+        _idle.push_back(f);
+        --_live;
+    }
+
+    // Cancels what the running coroutine waited for when it was resumed by somebody else.
+    void cancel_wait(fiber* f) {
+        if (f->state == fiber_state::sleeping) {
+            _timers.remove(f);
+        }
+#ifdef __linux__
+        if (f->state == fiber_state::reading || f->state == fiber_state::writing) {
+            remove_io(f);
+        }
+#endif // __linux__
+        f->state = fiber_state::running;
+    }
+
+    void suspend(lua_State* thread) override {
+        const auto it = _threads.find(thread);
+        if (it != _threads.end() && it->second->state == fiber_state::running) {
+            it->second->state = fiber_state::pending;
+        }
+    }
+
+    bool wake(lua_State* thread) override {
+        const auto it = _threads.find(thread);
+        if (it == _threads.end() || it->second->state != fiber_state::pending) {
+            return false;
+        }
+        make_ready(it->second);
+        return true;
+    }
+
+    static scheduler& from(lua_State* L) {
+        scheduler* s = find(L);
+        if (s == nullptr) [[unlikely]] {
+            raiseError(L, "No scheduler is attached to the state.");
+        }
+        return *s;
+    }
+
+    // Coroutine of the scheduler calling a waiting function.
+    fiber* current(lua_State* L) {
+        const auto it = _threads.find(L);
+        if (it == _threads.end()) [[unlikely]] {
+            raiseError(L, "The function can only be called from a coroutine spawned by the scheduler.");
+        }
+        cancel_wait(it->second);
+        return it->second;
+    }
+
+    static int spawn_(lua_State* L) {
+        scheduler& s = from(L);
+        if (lua_type(L, 1) != LUA_TFUNCTION) [[unlikely]] {
+            raiseError(L, "Expecting a function to spawn, but got '%s'.", lua_typename(L, lua_type(L, 1)));
+        }
+        s.spawn(L, lua_gettop(L) - 1);
+        return 0;
+    }
+
+    static int sleep_(lua_State* L) {
+        scheduler& s = from(L);
+        const lua_Number seconds = luaL_checknumber(L, 1);
+        fiber* f = s.current(L);
+        if (!(seconds > 0)) {
+            s.make_ready(f);
+        } else {
+            using seconds_type = std::chrono::duration<lua_Number>;
+            const lua_Number due = seconds_type(s.elapsed()).count() + seconds;
+            // rounded up, a coroutine never wakes before its time, the wheel clamps long sleeps
+            const lua_Number ticks = std::ceil(due / seconds_type(s._options.resolution).count());
+            s._timers.add(f, static_cast<uint64_t>(std::min<lua_Number>(ticks, 1e18)));
+            f->state = fiber_state::sleeping;
+        }
+        return lua_yield(L, 0);
+    }
+
+    static int yield_(lua_State* L) {
+        scheduler& s = from(L);
+        s.make_ready(s.current(L));
+        return lua_yield(L, 0);
+    }
+
+    static int now_(lua_State* L) {
+        const scheduler& s = from(L);
+        lua_pushnumber(L, std::chrono::duration<lua_Number>(s.elapsed()).count());
+        return 1;
+    }
+
+#ifdef __linux__
+    struct io_waiters {
+        fiber* reader = nullptr;
+        fiber* writer = nullptr;
+    };
+
+    static int wait_readable_(lua_State* L) {
+        return from(L).wait_io(L, false);
+    }
+
+    static int wait_writable_(lua_State* L) {
+        return from(L).wait_io(L, true);
+    }
+
+    int wait_io(lua_State* L, bool write) {
+        const auto fd = static_cast<int>(luaL_checkinteger(L, 1));
+        fiber* f = current(L);
+        io_waiters& w = _io[fd];
+        fiber*& slot = write ? w.writer : w.reader;
+        if (slot != nullptr) [[unlikely]] {
+            raiseError(L, "Another coroutine already waits for fd %d.", fd);
+        }
+        const bool added = w.reader == nullptr && w.writer == nullptr;
+        slot = f;
+        if (!watch(fd, w, added)) [[unlikely]] {
+            slot = nullptr;
+            if (added) {
+                _io.erase(fd);
+            }
+            raiseError(L, "Cannot wait for fd %d: %s", fd, std::strerror(errno));
+        }
+        f->fd = fd;
+        f->state = write ? fiber_state::writing : fiber_state::reading;
+        return lua_yield(L, 0);
+    }
+
+    // Updates the epoll interest of `fd` to its waiters.
+    bool watch(int fd, const io_waiters& w, bool added) {
+        epoll_event event {};
+        event.events = (w.reader != nullptr ? EPOLLIN : 0u) | (w.writer != nullptr ? EPOLLOUT : 0u);
+        event.data.fd = fd;
+        if (event.events == 0) {
+            return epoll_ctl(_epoll, EPOLL_CTL_DEL, fd, nullptr) == 0;
+        }
+        return epoll_ctl(_epoll, added ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fd, &event) == 0;
+    }
+
+    void remove_io(fiber* f) {
+        const auto it = _io.find(f->fd);
+        if (it == _io.end()) {
+            return;
+        }
+        io_waiters& w = it->second;
+        (f->state == fiber_state::writing ? w.writer : w.reader) = nullptr;
+        watch(f->fd, w, false);
+        if (w.reader == nullptr && w.writer == nullptr) {
+            _io.erase(it);
+        }
+        f->fd = -1;
+    }
+
+    // Waits up to `timeout` milliseconds for fd events or notify(), forever with -1.
+    void poll(int timeout) {
+        if (_io.empty() && timeout == 0) {
+            // a pending notify() is taken by the next wait
+            return;
+        }
+        std::array<epoll_event, 256> events;
+        const int count = epoll_wait(_epoll, events.data(), static_cast<int>(events.size()), timeout);
+        for (int i = 0; i < count; ++i) {
+            const int fd = events[i].data.fd;
+            if (fd == _wakeup) {
+                uint64_t notified = 0;
+                [[maybe_unused]] const ssize_t taken = read(_wakeup, &notified, sizeof(notified));
+                continue;
+            }
+            const auto it = _io.find(fd);
+            if (it == _io.end()) {
+                continue;
+            }
+            io_waiters& w = it->second;
+            const bool failed = (events[i].events & (EPOLLERR | EPOLLHUP)) != 0;
+            if (w.reader != nullptr && (failed || (events[i].events & EPOLLIN) != 0)) {
+                w.reader->fd = -1;
+                make_ready(std::exchange(w.reader, nullptr));
+            }
+            if (w.writer != nullptr && (failed || (events[i].events & EPOLLOUT) != 0)) {
+                w.writer->fd = -1;
+                make_ready(std::exchange(w.writer, nullptr));
+            }
+            watch(fd, w, false);
+            if (w.reader == nullptr && w.writer == nullptr) {
+                _io.erase(it);
+            }
+        }
+    }
+#else
+    // Sleeps until the next timer, with no fd to watch only notify() without timers can wake the loop earlier.
+    void poll(int timeout) {
+        if (timeout < 0) {
+            _notified.wait(false, std::memory_order_acquire);
+        } else if (timeout > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
+        }
+        _notified.store(false, std::memory_order_relaxed);
+    }
+#endif // __linux__
+
+    static inline const char key = 0;
+
+    const scheduler_options _options;
+    const clock::time_point _start;
+    lua_State* _L = nullptr;
+    timer_wheel _timers;
+    std::deque<fiber*> _ready;
+    std::vector<std::unique_ptr<fiber>> _fibers;
+    std::vector<fiber*> _idle;
+    std::unordered_map<lua_State*, fiber*> _threads;
+    size_t _live = 0;
+    bool _stopping = false;
+    stats _stats;
+#ifdef __linux__
+    int _epoll = -1;
+    // eventfd in the epoll set, written by notify()
+    int _wakeup = -1;
+    std::unordered_map<int, io_waiters> _io;
+#else
+    std::atomic<bool> _notified {false};
+#endif // __linux__
+};
+
+} // namespace luabind
+
+#endif // LUABIND_SCHEDULER_HPP
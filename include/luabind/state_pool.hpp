@@ -0,0 +1,406 @@
+#ifndef LUABIND_STATE_POOL_HPP
+#define LUABIND_STATE_POOL_HPP
+
+#include "lua.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace luabind {
+
+// Pool of warmed states, each created and initialized once, e.g. with luaL_openlibs and bindings
+// or schema::attach, then reused for many short scripts.
+// When a state is given back, the tables reachable from the global table or from package.loaded
+// get back the fields and the metatables they had after initialization, the stack is cleared and a GC step runs.
+// Metatables shared by all values of a type, e.g. of strings, are set back too, and their fields restored.
+// Only those tables are restored, state kept elsewhere, e.g. in the registry or in upvalues, survives.
+// The pool is thread safe, a state is used by one thread at a time.
+class state_pool {
+public:
+    using initializer = std::function<void(lua_State* L)>;
+    using clock = std::chrono::steady_clock;
+
+    struct latency {
+        size_t count = 0;
+        clock::duration total {};
+        clock::duration max {};
+
+        clock::duration mean() const {
+            return count != 0 ? total / static_cast<clock::rep>(count) : clock::duration {};
+        }
+
+        void add(clock::duration d) {
+            ++count;
+            total += d;
+            max = std::max(max, d);
+        }
+    };
+
+    struct metrics {
+        // time spent in acquire, creating a state when none is idle included
+        latency acquire;
+        // time spent in release, resetting the state included
+        latency release;
+        size_t created = 0;
+        // states closed on release because max_idle states were idle already, or the reset failed
+        size_t discarded = 0;
+    };
+
+    // Gives the state back to the pool when destroyed.
+    class handle {
+    public:
+        handle(handle&& other) noexcept
+            : _pool(std::exchange(other._pool, nullptr))
+            , _L(std::exchange(other._L, nullptr)) {}
+
+        handle& operator=(handle&& other) noexcept {
+            if (this != &other) {
+                reset();
+                _pool = std::exchange(other._pool, nullptr);
+                _L = std::exchange(other._L, nullptr);
+            }
+            return *this;
+        }
+
+        ~handle() {
+            reset();
+        }
+
+        lua_State* get() const {
+            return _L;
+        }
+
+        operator lua_State*() const {
+            return _L;
+        }
+
+        // Releases the state before the handle is destroyed.
+        void reset() {
+            if (_L != nullptr) {
+                _pool->release(std::exchange(_L, nullptr));
+            }
+        }
+
+    private:
+        friend class state_pool;
+
+        handle(state_pool* pool, lua_State* L)
+            : _pool(pool)
+            , _L(L) {}
+
+        state_pool* _pool;
+        lua_State* _L;
+    };
+
+    // `init` runs once for every new state, `max_idle` states at most are kept for reuse.
+    // A GC step of `gc_step_kb` kilobytes runs on release, 0 is a basic step.
+    explicit state_pool(initializer init, size_t max_idle = 8, int gc_step_kb = 0)
+        : _init(std::move(init))
+        , _max_idle(max_idle)
+        , _gc_step_kb(gc_step_kb) {}
+
+    state_pool(const state_pool&) = delete;
+    state_pool& operator=(const state_pool&) = delete;
+
+    // All handles should be released before.
+    ~state_pool() {
+        for (lua_State* L : _idle) {
+            lua_close(L);
+        }
+    }
+
+    // Creates and initializes `count` states in advance, up to max_idle.
+    void warm_up(size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            lua_State* L = create();
+            std::lock_guard lock(_mutex);
+            if (_idle.size() >= _max_idle) {
+                lua_close(L);
+                break;
+            }
+            _idle.push_back(L);
+        }
+    }
+
+    handle acquire() {
+        const clock::time_point start = clock::now();
+        lua_State* L = nullptr;
+        {
+            std::lock_guard lock(_mutex);
+            if (!_idle.empty()) {
+                L = _idle.back();
+                _idle.pop_back();
+            }
+        }
+        if (L == nullptr) {
+            L = create();
+        }
+        const clock::duration elapsed = clock::now() - start;
+        std::lock_guard lock(_mutex);
+        _metrics.acquire.add(elapsed);
+        return handle(this, L);
+    }
+
+    size_t idle_size() const {
+        std::lock_guard lock(_mutex);
+        return _idle.size();
+    }
+
+    size_t max_idle() const {
+        return _max_idle;
+    }
+
+    metrics get_metrics() const {
+        std::lock_guard lock(_mutex);
+        return _metrics;
+    }
+
+private:
+    lua_State* create() {
+        lua_State* L = luaL_newstate();
+        try {
+            _init(L);
+            lua_settop(L, 0);
+            take_snapshot(L);
+        } catch (...) {
+            lua_close(L);
+            throw;
+        }
+        std::lock_guard lock(_mutex);
+        ++_metrics.created;
+        return L;
+    }
+
+    void release(lua_State* L) {
+        const clock::time_point start = clock::now();
+        const bool restored = restore(L);
+        std::unique_lock lock(_mutex);
+        const bool keep = restored && _idle.size() < _max_idle;
+        if (keep) {
+            _idle.push_back(L);
+        } else {
+            ++_metrics.discarded;
+        }
+        lock.unlock();
+        if (!keep) {
+            lua_close(L);
+        }
+        const clock::duration elapsed = clock::now() - start;
+        lock.lock();
+        _metrics.release.add(elapsed);
+    }
+
+    // The snapshot is an array of {table, copy of its fields, metatable or false} entries in the registry.
+    // The metatables of the types are kept in another array, in push_type_sample order.
+    static void take_snapshot(lua_State* L) {
+        lua_newtable(L);
+        const int snapshot = lua_gettop(L);
+        lua_newtable(L); // tables already taken, to take each one once
+        const int seen = lua_gettop(L);
+
+        lua_pushglobaltable(L);
+        const int globals = lua_gettop(L);
+        add_to_snapshot(L, snapshot, seen, globals);
+        add_fields_to_snapshot(L, snapshot, seen, globals);
+
+        lua_getfield(L, LUA_REGISTRYINDEX, LUA_LOADED_TABLE);
+        if (lua_istable(L, -1)) {
+            const int loaded = lua_gettop(L);
+            add_to_snapshot(L, snapshot, seen, loaded);
+            add_fields_to_snapshot(L, snapshot, seen, loaded);
+        }
+
+        lua_createtable(L, shared_type_count, 0);
+        const int types = lua_gettop(L);
+        for (int i = 0; i < shared_type_count; ++i) {
+            push_type_sample(L, i);
+            if (lua_getmetatable(L, -1) != 0) {
+                add_to_snapshot(L, snapshot, seen, lua_gettop(L));
+            } else {
+                lua_pushboolean(L, 0);
+            }
+            lua_rawseti(L, types, i + 1);
+            lua_pop(L, 1);
+        }
+        lua_rawsetp(L, LUA_REGISTRYINDEX, &types_key);
+        lua_settop(L, snapshot);
+        lua_rawsetp(L, LUA_REGISTRYINDEX, &snapshot_key);
+    }
+
+    // Takes the table fields of the table at `idx`, library and class tables among them.
+    static void add_fields_to_snapshot(lua_State* L, int snapshot, int seen, int idx) {
+        lua_pushnil(L);
+        while (lua_next(L, idx) != 0) {
+            if (lua_istable(L, -1)) {
+                add_to_snapshot(L, snapshot, seen, lua_gettop(L));
+            }
+            lua_pop(L, 1);
+        }
+    }
+
+    static void add_to_snapshot(lua_State* L, int snapshot, int seen, int idx) {
+        if (lua_rawgetp(L, seen, lua_topointer(L, idx)) != LUA_TNIL) {
+            lua_pop(L, 1);
+            return;
+        }
+        lua_pop(L, 1);
+        lua_pushboolean(L, 1);
+        lua_rawsetp(L, seen, lua_topointer(L, idx));
+
+        lua_createtable(L, 2, 0);
+        lua_pushvalue(L, idx);
+        lua_rawseti(L, -2, 1);
+        lua_newtable(L);
+        lua_pushnil(L);
+        while (lua_next(L, idx) != 0) {
+            lua_pushvalue(L, -2);
+            lua_insert(L, -2);
+            lua_rawset(L, -4);
+        }
+        lua_rawseti(L, -2, 2);
+        if (lua_getmetatable(L, idx) == 0) {
+            lua_pushboolean(L, 0);
+        }
+        lua_rawseti(L, -2, 3);
+        lua_rawseti(L, snapshot, static_cast<lua_Integer>(lua_rawlen(L, snapshot) + 1));
+        // fields of the metatable are restored too, e.g. of the one with the __index of lazy classes
+        if (lua_getmetatable(L, idx) != 0) {
+            add_to_snapshot(L, snapshot, seen, lua_gettop(L));
+            lua_pop(L, 1);
+        }
+    }
+
+    // Values of the types with one metatable for all their values, set with debug.setmetatable.
+    static constexpr int shared_type_count = 7;
+
+    static void push_type_sample(lua_State* L, int i) {
+        switch (i) {
+        case 0:
+            lua_pushnil(L);
+            break;
+        case 1:
+            lua_pushboolean(L, 0);
+            break;
+        case 2:
+            lua_pushinteger(L, 0);
+            break;
+        case 3:
+            lua_pushliteral(L, "");
+            break;
+        case 4:
+            lua_pushlightuserdata(L, nullptr);
+            break;
+        case 5:
+            lua_pushcfunction(L, &restore_snapshot);
+            break;
+        default:
+            lua_pushthread(L);
+            break;
+        }
+    }
+
+    // Sets the metatable of the value at `idx` back to the one on top of the stack, false for none, and pops it.
+    static void restore_metatable(lua_State* L, int idx) {
+        if (lua_getmetatable(L, idx) == 0) {
+            lua_pushboolean(L, 0);
+        }
+        const bool same = lua_rawequal(L, -1, -2);
+        lua_pop(L, 1);
+        if (same) {
+            lua_pop(L, 1);
+            return;
+        }
+        if (!lua_toboolean(L, -1)) {
+            lua_pop(L, 1);
+            lua_pushnil(L);
+        }
+        lua_setmetatable(L, idx);
+    }
+
+    // Runs protected, a memory error while restoring discards the state.
+    bool restore(lua_State* L) {
+        lua_settop(L, 0);
+        lua_pushcfunction(L, &restore_snapshot);
+        const bool ok = lua_pcall(L, 0, 0, 0) == LUA_OK;
+        lua_settop(L, 0);
+        if (ok) {
+            lua_gc(L, LUA_GCSTEP, _gc_step_kb);
+        }
+        return ok;
+    }
+
+    static int restore_snapshot(lua_State* L) {
+        lua_rawgetp(L, LUA_REGISTRYINDEX, &types_key);
+        const int types = lua_gettop(L);
+        for (int i = 0; i < shared_type_count; ++i) {
+            push_type_sample(L, i);
+            lua_rawgeti(L, types, i + 1);
+            restore_metatable(L, -2);
+            lua_pop(L, 1);
+        }
+        lua_pop(L, 1);
+
+        lua_rawgetp(L, LUA_REGISTRYINDEX, &snapshot_key);
+        const int snapshot = lua_gettop(L);
+        const lua_Integer count = static_cast<lua_Integer>(lua_rawlen(L, snapshot));
+        for (lua_Integer i = 1; i <= count; ++i) {
+            lua_rawgeti(L, snapshot, i);
+            lua_rawgeti(L, -1, 1);
+            const int table = lua_gettop(L);
+            lua_rawgeti(L, -2, 2);
+            const int copy = lua_gettop(L);
+            lua_rawgeti(L, -3, 3);
+            restore_metatable(L, table);
+
+            // clearing and assigning existing fields is allowed while traversing
+            lua_pushnil(L);
+            while (lua_next(L, table) != 0) {
+                lua_pushvalue(L, -2);
+                lua_rawget(L, copy);
+                if (!lua_rawequal(L, -1, -2)) {
+                    lua_pushvalue(L, -3);
+                    lua_insert(L, -2);
+                    lua_rawset(L, table);
+                } else {
+                    lua_pop(L, 1);
+                }
+                lua_pop(L, 1);
+            }
+            // fields removed by the script are added back
+            lua_pushnil(L);
+            while (lua_next(L, copy) != 0) {
+                lua_pushvalue(L, -2);
+                if (lua_rawget(L, table) == LUA_TNIL) {
+                    lua_pop(L, 1);
+                    lua_pushvalue(L, -2);
+                    lua_insert(L, -2);
+                    lua_rawset(L, table);
+                } else {
+                    lua_pop(L, 2);
+                }
+            }
+            lua_settop(L, snapshot);
+        }
+        return 0;
+    }
+
+private:
+    static inline const char snapshot_key = 0;
+    static inline const char types_key = 0;
+
+    const initializer _init;
+    const size_t _max_idle;
+    const int _gc_step_kb;
+    mutable std::mutex _mutex;
+    std::vector<lua_State*> _idle;
+    metrics _metrics;
+};
+
+} // namespace luabind
+
+#endif // LUABIND_STATE_POOL_HPP
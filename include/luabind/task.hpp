@@ -0,0 +1,208 @@
+#ifndef LUABIND_TASK_HPP
+#define LUABIND_TASK_HPP
+
+#include "lua.hpp"
+#include "mirror.hpp"
+#include "wrapper.hpp"
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace luabind {
+
+template <typename T = void>
+class task;
+
+// Completes a task: resumes the task awaiting it, or the Lua coroutine waiting for its result.
+// Either of them may destroy the finished task before await_suspend returns.
+struct task_final_awaiter {
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    template <typename Promise>
+    void await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+        auto& promise = handle.promise();
+        if (promise.continuation) {
+            promise.continuation.resume();
+        } else if (promise.awaited_by_lua && !promise.complete()) {
+            handle.destroy();
+        }
+    }
+
+    void await_resume() const noexcept {}
+};
+
+// A task is the pending result of the Lua coroutine waiting for it, see value_mirror<task<T>>.
+struct task_promise_base : pending_result {
+    // started right away, a task which doesn't suspend completes without yielding Lua
+    std::suspend_never initial_suspend() const noexcept {
+        return {};
+    }
+
+    task_final_awaiter final_suspend() const noexcept {
+        return {};
+    }
+
+    void unhandled_exception() {
+        error = std::current_exception();
+    }
+
+    void rethrow_if_failed() const {
+        if (error) [[unlikely]] {
+            std::rethrow_exception(error);
+        }
+    }
+
+    std::coroutine_handle<> continuation;
+    std::exception_ptr error;
+    // the task object gave the frame away to a waiting Lua coroutine
+    bool awaited_by_lua = false;
+};
+
+template <typename Promise>
+struct task_promise_common : task_promise_base {
+    bool ready() const override {
+        return const_cast<task_promise_common*>(this)->handle().done();
+    }
+
+    int push_results(lua_State* L) override {
+        return static_cast<Promise*>(this)->push_value(L);
+    }
+
+    void release() override {
+        handle().destroy();
+    }
+
+    std::coroutine_handle<Promise> handle() {
+        return std::coroutine_handle<Promise>::from_promise(static_cast<Promise&>(*this));
+    }
+};
+
+template <typename T>
+struct task_promise : task_promise_common<task_promise<T>> {
+    task<T> get_return_object() {
+        return task<T> {this->handle()};
+    }
+
+    template <typename U>
+        requires(std::is_convertible_v<U &&, T>)
+    void return_value(U&& v) {
+        value.emplace(std::forward<U>(v));
+    }
+
+    T result() {
+        this->rethrow_if_failed();
+        return std::move(*value);
+    }
+
+    int push_value(lua_State* L) {
+        return value_mirror<T>::to_lua(L, result());
+    }
+
+    std::optional<T> value;
+};
+
+template <>
+struct task_promise<void> : task_promise_common<task_promise<void>> {
+    task<void> get_return_object();
+
+    void return_void() const noexcept {}
+
+    void result() const {
+        rethrow_if_failed();
+    }
+
+    int push_value(lua_State*) const {
+        result();
+        return 0;
+    }
+};
+
+// Result of a C++20 coroutine. A bound function returning a task which suspends yields the calling Lua coroutine,
+// which is resumed with the converted result, or gets the thrown exception as a Lua error, once the task completes.
+// The task has to be completed on the thread running the state, e.g. by an event loop, while the state is open.
+// Tasks can also co_await each other.
+template <typename T>
+class [[nodiscard]] task {
+public:
+    using promise_type = task_promise<T>;
+    using value_type = T;
+
+    task() = default;
+
+    explicit task(std::coroutine_handle<promise_type> handle)
+        : _handle(handle) {}
+
+    task(task&& other) noexcept
+        : _handle(std::exchange(other._handle, nullptr)) {}
+
+    task& operator=(task&& other) noexcept {
+        if (this != &other) {
+            if (_handle) {
+                _handle.destroy();
+            }
+            _handle = std::exchange(other._handle, nullptr);
+        }
+        return *this;
+    }
+
+    ~task() {
+        if (_handle) {
+            _handle.destroy();
+        }
+    }
+
+    bool done() const {
+        return _handle && _handle.done();
+    }
+
+    // value of a completed task, or its exception rethrown
+    T result() {
+        return _handle.promise().result();
+    }
+
+    bool await_ready() const noexcept {
+        return _handle.done();
+    }
+
+    void await_suspend(std::coroutine_handle<> continuation) const noexcept {
+        _handle.promise().continuation = continuation;
+    }
+
+    T await_resume() {
+        return result();
+    }
+
+private:
+    friend struct value_mirror<task<T>>;
+
+    std::coroutine_handle<promise_type> _handle;
+};
+
+inline task<void> task_promise<void>::get_return_object() {
+    return task<void> {handle()};
+}
+
+template <typename T>
+struct value_mirror<task<T>> {
+    using type = task<T>;
+
+    static int to_lua(lua_State* L, type t) {
+        if (t.done()) {
+            return t._handle.promise().push_value(L);
+        }
+        // the frame is released by the coroutine once it gets the result
+        auto& promise = std::exchange(t._handle, nullptr).promise();
+        promise.awaited_by_lua = true;
+        lua_pushlightuserdata(L, static_cast<pending_result*>(&promise));
+        return pending_results;
+    }
+};
+
+} // namespace luabind
+
+#endif // LUABIND_TASK_HPP
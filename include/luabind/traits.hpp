@@ -44,6 +44,16 @@ struct function_result<R (*)(Args...), func> {
 template <typename F, F f>
 using function_result_t = typename function_result<F, f>::type;
 
+// Final, non-polymorphic and trivially copyable classes are bound by value, without deriving from Object.
+// Their instances are stored inline in the userdata, see value_user_data.
+template <typename T>
+struct is_value_type
+    : std::bool_constant<std::is_class_v<T> && std::is_final_v<T> && !std::is_polymorphic_v<T> &&
+                         std::is_trivially_copyable_v<T>> {};
+
+template <typename T>
+inline constexpr bool is_value_type_v = is_value_type<std::remove_cv_t<T>>::value;
+
 template <typename T>
 struct is_pointer_ref : public std::false_type {};
 
@@ -3,9 +3,17 @@
 
 #include "lua.hpp"
 #include "exception.hpp"
+#include "traits.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <map>
 #include <memory>
+#include <optional>
+#include <span>
 #include <string>
 #include <type_traits>
 #include <typeindex>
@@ -16,56 +24,518 @@
 
 namespace luabind {
 
+// Data member served by generic accessors instead of a getter and setter generated per member.
+// The accessors are generated once per class and member type, see field_accessor.
+struct field_data {
+    // push the value of the member of the object at stack index 1,
+    // or assign the value at stack index 3 to it
+    int (*get)(lua_State* L, std::ptrdiff_t offset);
+    void (*set)(lua_State* L, std::ptrdiff_t offset);
+    // of the member within the object
+    std::ptrdiff_t offset;
+};
+
 struct property_data {
     lua_CFunction getter;
     lua_CFunction setter;
+    field_data field {};
 
-    property_data(lua_CFunction g)
+    constexpr property_data(lua_CFunction g)
         : getter(g)
         , setter(nullptr) {}
 
-    property_data(lua_CFunction g, lua_CFunction s)
+    constexpr property_data(lua_CFunction g, lua_CFunction s)
         : getter(g)
         , setter(s) {}
+
+    constexpr property_data(field_data f)
+        : getter(nullptr)
+        , setter(nullptr)
+        , field(f) {}
+
+    bool has_getter() const {
+        return getter != nullptr || field.get != nullptr;
+    }
+
+    bool has_setter() const {
+        return setter != nullptr || field.set != nullptr;
+    }
+
+    // Expects the object and the key on the stack, as in __index.
+    int get(lua_State* L) const {
+        if (field.get != nullptr) {
+            return field.get(L, field.offset);
+        }
+        return getter(L);
+    }
+
+    // Expects the object, the key and the value on the stack, as in __newindex.
+    void set(lua_State* L) const {
+        if (field.set != nullptr) {
+            field.set(L, field.offset);
+        } else {
+            setter(L);
+        }
+    }
 };
 
+// Function or property of a class_descriptor, see descriptor.hpp. Lives in static storage.
+struct static_member {
+    const char* name = nullptr;
+    // nullptr for a property
+    lua_CFunction function = nullptr;
+    property_data property {nullptr, nullptr};
+};
+
+// Dense index of a C++ type, assigned once per process on first use.
+// Lets type_storage address type_info by a plain array index instead of hashing std::type_index.
+inline size_t next_type_id() {
+    static std::atomic<size_t> counter {0};
+    return counter.fetch_add(1, std::memory_order_relaxed);
+}
+
+template <typename T>
+size_t type_id() {
+    static const size_t id = next_type_id();
+    return id;
+}
+
+// Options of a bound class, combined with operator|.
+enum class class_options : unsigned {
+    none = 0,
+    // Methods, inherited ones included, are kept in a Lua table consulted by __index before calling C++,
+    // so Lua resolves method calls with a native table lookup. The C++ __index is left as a fallback
+    // for properties, integer keys and the per-object custom table.
+    method_table = 1u << 0,
+    // Objects get no per-object custom table: no user value is allocated for them,
+    // and reading or writing a key which is not a bound member is an error.
+    sealed = 1u << 1,
+};
+
+constexpr class_options operator|(class_options a, class_options b) {
+    return static_cast<class_options>(static_cast<unsigned>(a) | static_cast<unsigned>(b));
+}
+
+constexpr bool has_option(class_options options, class_options option) {
+    return (static_cast<unsigned>(options) & static_cast<unsigned>(option)) != 0;
+}
+
+// Conversion of a pointer to a bound type into a pointer to one of its bound ancestors.
+struct upcast_data {
+    // type_id of the ancestor
+    size_t id;
+    // added to the address of the object to get the address of the ancestor subobject
+    std::ptrdiff_t offset;
+    // the ancestor is reached through a virtual base or by several paths, offset is not constant
+    bool is_dynamic;
+};
+
+// Offset of the Base subobject within Derived. A non-virtual upcast is a constant adjustment,
+// so it is measured once on a dummy address which is never dereferenced.
+template <typename Derived, typename Base>
+std::ptrdiff_t base_offset() {
+    constexpr std::uintptr_t address = 0x10000;
+    auto* derived = reinterpret_cast<Derived*>(address);
+    auto* base = static_cast<Base*>(derived);
+    return static_cast<std::ptrdiff_t>(reinterpret_cast<std::uintptr_t>(base) - address);
+}
+
+// Resolved member of a type, either a property or a function.
+struct member_data {
+    const property_data* property;
+    lua_CFunction function;
+};
+
+// Bindings of a type, independent of any lua_State.
+// Once a type is part of a schema it is shared by several states, possibly on different threads,
+// and never changes again. Lookup structures depending on a state are kept by type_storage.
 struct type_info {
     const std::string name;
+    const size_t id;
     const std::vector<type_info*> bases;
-    lua_CFunction index;
-    lua_CFunction new_index;
+    // every bound ancestor, direct bases and their ancestors
+    const std::vector<upcast_data> upcasts;
+    const class_options options;
+    // objects are stored inline in a value_user_data, which has no user_data header
+    const bool value_type;
     lua_CFunction array_access_getter;
     lua_CFunction array_access_setter;
     std::map<std::string, lua_CFunction, std::less<>> functions;
     std::map<std::string, property_data, std::less<>> properties;
+    // stored in the metatable itself: constructors, class functions and metamethods
+    std::map<std::string, lua_CFunction, std::less<>> metatable_functions;
+    // types bound with this one as a base, their resolved members depend on ours
+    std::vector<type_info*> derived;
+    // bound by a class_descriptor: members sorted by name and a luaL_Reg array ending with {nullptr, nullptr}
+    std::span<const static_member> static_members;
+    const luaL_Reg* static_metatable_functions = nullptr;
+
+    // Key set in the metatables of userdata starting with a user_data header, Lua code cannot create it.
+    // Metatables of value types are not marked, the payload of a value_user_data is written by scripts.
+    static inline const char metatable_marker = 0;
+
+    static void mark_metatable(lua_State* L, int idx) {
+        idx = lua_absindex(L, idx);
+        lua_pushboolean(L, 1);
+        lua_rawsetp(L, idx, &metatable_marker);
+    }
 
     void get_metatable(lua_State* L) const {
-        luaL_getmetatable(L, name.c_str());
+        // metatable is also registered under the type_info address, which is cheaper than a lookup by name
+        lua_rawgetp(L, LUA_REGISTRYINDEX, this);
     }
 
-    type_info(lua_State* L,
-              std::string&& type_name,
+    type_info(std::string&& type_name,
+              size_t id,
               std::vector<type_info*>&& bases,
-              lua_CFunction index_functor,
-              lua_CFunction new_index_functor)
+              std::vector<upcast_data>&& upcasts,
+              class_options options,
+              bool value_type)
         : name(std::move(type_name))
+        , id(id)
         , bases(std::move(bases))
-        , index(index_functor)
-        , new_index(new_index_functor)
+        , upcasts(std::move(upcasts))
+        , options(options)
+        , value_type(value_type)
         , array_access_getter(nullptr)
-        , array_access_setter(nullptr) {
+        , array_access_setter(nullptr) {}
+
+    const upcast_data* find_upcast(size_t ancestor_id) const {
+        for (const upcast_data& upcast : upcasts) {
+            if (upcast.id == ancestor_id) {
+                return &upcast;
+            }
+        }
+        return nullptr;
+    }
+
+    // Creates the metatable of the type in L with every metatable function bound so far.
+    void create_metatable(lua_State* L) const {
         luaL_newmetatable(L, name.c_str());
+        if (!value_type) {
+            mark_metatable(L, -1);
+        }
+        lua_pushvalue(L, -1);
+        lua_rawsetp(L, LUA_REGISTRYINDEX, this);
+        set_metatable_functions(L);
         lua_setglobal(L, name.c_str());
         //  stack is clean
     }
+
+    void add_metatable_function(lua_State* L, const std::string_view key, lua_CFunction function) {
+        check_mutable();
+        auto it = metatable_functions.insert_or_assign(std::string {key}, function).first;
+        get_metatable(L);
+        push_metatable_function(L, it->first, function);
+        lua_setfield(L, -2, it->first.c_str());
+        lua_pop(L, 1); // pop metatable
+    }
+
+    // Binds the members of a class_descriptor, metatable functions are set with one luaL_setfuncs.
+    // Members bound by name, e.g. by class_, shadow them.
+    void add_static_members(lua_State* L,
+                            std::span<const static_member> members,
+                            const luaL_Reg* functions,
+                            lua_CFunction getter,
+                            lua_CFunction setter) {
+        check_mutable();
+        if (static_metatable_functions != nullptr) {
+            reportError("Type '%s' is already bound by a descriptor.", name.c_str());
+        }
+        static_members = members;
+        static_metatable_functions = functions;
+        if (getter != nullptr || setter != nullptr) {
+            array_access_getter = getter;
+            array_access_setter = setter;
+        }
+        get_metatable(L);
+        set_metatable_functions(L);
+        lua_pop(L, 1);
+        invalidate_members(L);
+    }
+
+    void add_function(lua_State* L, const std::string_view name, lua_CFunction function) {
+        check_mutable();
+        functions[std::string {name}] = function;
+        invalidate_members(L);
+    }
+
+    void add_property(lua_State* L, const std::string_view name, property_data property) {
+        check_mutable();
+        properties.emplace(name, property);
+        invalidate_members(L);
+    }
+
+    void set_array_access(lua_State* L, lua_CFunction getter, lua_CFunction setter) {
+        check_mutable();
+        array_access_getter = getter;
+        array_access_setter = setter;
+        invalidate_members(L);
+    }
+
+    // Whether the type belongs to a schema, see schema::capture.
+    bool is_shared() const {
+        return _shared;
+    }
+
+    // Own and inherited members, own ones shadow inherited ones.
+    const std::vector<std::pair<std::string_view, member_data>>& members() {
+        ensure_members();
+        return _members;
+    }
+
+    lua_CFunction find_array_access_getter() {
+        ensure_members();
+        return _array_access_getter;
+    }
+
+    lua_CFunction find_array_access_setter() {
+        ensure_members();
+        return _array_access_setter;
+    }
+
+    // Changes whenever members of the type or of its bases change, lookup structures are rebuilt then.
+    unsigned members_version() const {
+        return _members_version;
+    }
+
+    // Pushes the method table of the type, the first upvalue of its __index dispatcher.
+    // Returns false and pushes nothing if __index was replaced by someone else.
+    bool push_method_table(lua_State* L) const {
+        get_metatable(L);
+        lua_pushliteral(L, "__index");
+        lua_rawget(L, -2);
+        if (lua_getupvalue(L, -1, 1) == nullptr) {
+            lua_pop(L, 2);
+            return false;
+        }
+        lua_replace(L, -3);
+        lua_pop(L, 1); // __index
+        return true;
+    }
+
+private:
+    friend class schema;
+
+    void check_mutable() const {
+        if (_shared) [[unlikely]] {
+            reportError("Type '%s' is bound by a shared schema and cannot be changed.", name.c_str());
+        }
+    }
+
+    void ensure_members() {
+        if (_members_dirty) [[unlikely]] {
+            resolve_members();
+        }
+    }
+
+    // Own members shadow inherited ones, bases are searched in declaration order.
+    // Every source is already sorted by name, so they are merged into _members without a node per member.
+    void resolve_members() {
+        size_t count = properties.size() + functions.size() + static_members.size();
+        for (type_info* base : bases) {
+            base->ensure_members();
+            count += base->_members.size();
+        }
+        _members.clear();
+        _members.reserve(count);
+        // a stable merge keeps the entries merged first ahead of equal names merged later
+        const auto merge = [this](const auto& entries, const auto& to_member) {
+            const auto middle = static_cast<std::ptrdiff_t>(_members.size());
+            for (const auto& entry : entries) {
+                _members.push_back(to_member(entry));
+            }
+            std::inplace_merge(_members.begin(),
+                               _members.begin() + middle,
+                               _members.end(),
+                               [](const auto& a, const auto& b) { return a.first < b.first; });
+        };
+        merge(properties, [](const auto& p) {
+            return std::pair<std::string_view, member_data> {p.first, member_data {&p.second, nullptr}};
+        });
+        merge(functions, [](const auto& f) {
+            return std::pair<std::string_view, member_data> {f.first, member_data {nullptr, f.second}};
+        });
+        merge(static_members, [](const static_member& m) {
+            return std::pair<std::string_view, member_data> {
+                m.name, m.function != nullptr ? member_data {nullptr, m.function} : member_data {&m.property, nullptr}};
+        });
+        _array_access_getter = array_access_getter;
+        _array_access_setter = array_access_setter;
+        for (type_info* base : bases) {
+            merge(base->_members, [](const auto& m) { return m; });
+            if (_array_access_getter == nullptr) _array_access_getter = base->_array_access_getter;
+            if (_array_access_setter == nullptr) _array_access_setter = base->_array_access_setter;
+        }
+        const auto shadowed = std::unique(_members.begin(), _members.end(), [](const auto& a, const auto& b) {
+            return a.first == b.first;
+        });
+        _members.erase(shadowed, _members.end());
+        _members_dirty = false;
+    }
+
+    // Sets the functions of the descriptor, then the ones bound by name, into the metatable on top of the stack.
+    void set_metatable_functions(lua_State* L) const {
+        if (static_metatable_functions != nullptr) {
+            luaL_setfuncs(L, static_metatable_functions, 0);
+            if (has_option(options, class_options::method_table)) {
+                for (const luaL_Reg* r = static_metatable_functions; r->name != nullptr; ++r) {
+                    if (std::string_view {r->name} == "__index") {
+                        push_method_dispatcher(L, r->func);
+                        lua_setfield(L, -2, r->name);
+                    }
+                }
+            }
+        }
+        for (const auto& [key, function] : metatable_functions) {
+            push_metatable_function(L, key, function);
+            lua_setfield(L, -2, key.c_str());
+        }
+    }
+
+    void push_metatable_function(lua_State* L, const std::string_view key, lua_CFunction function) const {
+        if (key == "__index" && has_option(options, class_options::method_table)) {
+            push_method_dispatcher(L, function);
+        } else {
+            lua_pushcfunction(L, function);
+        }
+    }
+
+    // Lua function used as __index with class_options::method_table.
+    // Methods are found by the VM with a plain table lookup, anything else goes to the C++ __index.
+    static void push_method_dispatcher(lua_State* L, lua_CFunction fallback) {
+        static const char* factory_name = "LuaBindMethodDispatcher";
+        if (lua_getfield(L, LUA_REGISTRYINDEX, factory_name) != LUA_TFUNCTION) {
+            lua_pop(L, 1);
+            luaL_loadstring(L, R"--(
+                local methods, fallback = ...
+                return function(self, key)
+                    local method = methods[key]
+                    if method ~= nil then
+                        return method
+                    end
+                    return fallback(self, key)
+                end
+            )--");
+            lua_pushvalue(L, -1);
+            lua_setfield(L, LUA_REGISTRYINDEX, factory_name);
+        }
+        lua_newtable(L); // methods, filled by type_storage::update_method_tables
+        lua_pushcfunction(L, fallback);
+        lua_call(L, 2, 1);
+    }
+
+    // The method table is emptied as well, so a member bound under the name of a method is not shadowed by it.
+    // The next lookup misses and refills it, clearing does not allocate and cannot raise a Lua error.
+    void invalidate_members(lua_State* L) {
+        _members_dirty = true;
+        ++_members_version;
+        if (has_option(options, class_options::method_table) && push_method_table(L)) {
+            lua_pushnil(L);
+            while (lua_next(L, -2) != 0) {
+                lua_pop(L, 1); // value
+                lua_pushvalue(L, -1);
+                lua_pushnil(L);
+                lua_rawset(L, -4);
+            }
+            lua_pop(L, 1);
+        }
+        for (type_info* d : derived) {
+            d->invalidate_members(L);
+        }
+    }
+
+private:
+    // resolved members, keys are views of names owned by functions and properties of this type or its bases
+    std::vector<std::pair<std::string_view, member_data>> _members;
+    lua_CFunction _array_access_getter = nullptr;
+    lua_CFunction _array_access_setter = nullptr;
+    bool _members_dirty = true;
+    unsigned _members_version = 1;
+    bool _shared = false;
+};
+
+// Types bound once and shared by many states, which then only create their metatables.
+// A schema is captured from a state after running its class_ chains:
+//
+//     luabind::class_<Foo>(L, "Foo")...;
+//     std::shared_ptr<const luabind::schema> s = luabind::schema::capture(L);
+//     ...
+//     luabind::schema::attach(other, s); // on any thread
+//
+// The schema is immutable, it may be attached to states on several threads at once.
+class schema {
+public:
+    using types = std::unordered_map<std::type_index, type_info>;
+
+    // Moves the types bound in L into a new schema. L keeps working with them, through the schema.
+    static std::shared_ptr<const schema> capture(lua_State* L);
+
+    // Makes the types of the schema available in L, which should have no types bound yet.
+    // Types bound in L afterwards are owned by L and may derive from the schema's ones.
+    static void attach(lua_State* L, std::shared_ptr<const schema> s);
+
+    const types& get_types() const {
+        return _types;
+    }
+
+private:
+    types _types;
+    // the same type_info pointers as in _types, indexed by type_id
+    std::vector<type_info*> _types_by_id;
+};
+
+// Class bound on first use, see lazy.hpp.
+struct lazy_entry {
+    void (*bind)(lua_State* L) = nullptr;
+    // name of the class in its table
+    std::string name;
+    // registry reference of the module table the class is published in, LUA_NOREF for the global table
+    int module_ref = LUA_NOREF;
 };
 
 class type_storage {
 private:
     type_storage() = default;
 
+    // Lookup structures of one type in one state. Member names are keyed by the addresses of
+    // strings interned by the state, so they cannot be shared through the type_info.
+    struct member_cache {
+        struct slot {
+            // interned name, nullptr for an empty slot
+            const char* key;
+            member_data member;
+        };
+
+        // type_info::members_version the slots were built for
+        unsigned version = 0;
+        unsigned method_table_version = 0;
+        std::vector<slot> slots;
+        unsigned slot_shift = 64;
+        std::vector<std::pair<std::string_view, member_data>> uninterned_members;
+        size_t min_uninterned_length = std::numeric_limits<size_t>::max();
+    };
+
 public:
     static type_storage& get_instance(lua_State* L) {
+#ifdef LUABIND_USE_EXTRASPACE
+        // Lua copies the main thread's extra space into every new thread,
+        // so once the storage is created, it is reachable from any coroutine without a registry lookup.
+        // Requires the main thread's extra space to be zeroed on state creation (see README).
+        auto cached = static_cast<type_storage**>(lua_getextraspace(L));
+        if (*cached != nullptr) [[likely]] {
+            return **cached;
+        }
+        type_storage& instance = find_or_create_instance(L);
+        *cached = &instance;
+        return instance;
+#else
+        return find_or_create_instance(L);
+#endif // LUABIND_USE_EXTRASPACE
+    }
+
+private:
+    static type_storage& find_or_create_instance(lua_State* L) {
         static const char* storage_name = "LuaBindTypeStorage";
         int r = lua_getfield(L, LUA_REGISTRYINDEX, storage_name);
         if (r == LUA_TUSERDATA) {
@@ -93,24 +563,47 @@ public:
         lua_rawset(L, -3);
         lua_setmetatable(L, -2);
         lua_setfield(L, LUA_REGISTRYINDEX, storage_name);
+
+#ifdef LUABIND_USE_EXTRASPACE
+        // threads created from now on will inherit the pointer
+        lua_rawgeti(L, LUA_REGISTRYINDEX, LUA_RIDX_MAINTHREAD);
+        *static_cast<type_storage**>(lua_getextraspace(lua_tothread(L, -1))) = instance;
+        lua_pop(L, 1);
+#endif // LUABIND_USE_EXTRASPACE
         return *instance;
     }
 
+public:
     template <typename Type, typename... Bases>
-    static type_info*
-    add_type_info(lua_State* L, std::string name, lua_CFunction index_functor, lua_CFunction new_index_functor) {
+    static type_info* add_type_info(lua_State* L, std::string name, class_options options) {
         type_storage& instance = get_instance(L);
         const auto index = std::type_index(typeid(Type));
-        auto it = instance.m_types.find(index);
-        if (it != instance.m_types.end()) {
-            return &it->second;
+        if (type_info* existing = instance.find(index)) {
+            return existing;
         }
+        const size_t id = type_id<Type>();
+        // bound directly while its lazy binder did not run yet
+        instance.take_lazy(id);
         std::vector<type_info*> bases;
         bases.reserve(sizeof...(Bases));
-        (add_base_class<Bases>(instance, bases), ...);
+        std::vector<upcast_data> upcasts;
+        (add_base_class<Type, Bases>(L, instance, bases, upcasts), ...);
         auto r = instance.m_types.emplace(
-            index, type_info(L, std::move(name), std::move(bases), index_functor, new_index_functor));
-        return &(r.first->second);
+            index,
+            type_info(std::move(name), id, std::move(bases), std::move(upcasts), options, is_value_type_v<Type>));
+        type_info* info = &(r.first->second);
+        for (type_info* base : info->bases) {
+            // shared types never change, so they do not need to know their derived types
+            if (!base->is_shared()) {
+                base->derived.push_back(info);
+            }
+        }
+        if (id >= instance.m_types_by_id.size()) {
+            instance.m_types_by_id.resize(id + 1, nullptr);
+        }
+        instance.m_types_by_id[id] = info;
+        info->create_metatable(L);
+        return info;
     }
 
     template <typename T>
@@ -130,33 +623,339 @@ public:
 
     template <typename T>
     static type_info* find_type_info(lua_State* L) {
-        return find_type_info(L, std::type_index(typeid(T)));
+        type_storage& instance = get_instance(L);
+        const size_t id = type_id<std::remove_cv_t<T>>();
+        type_info* info = instance.find_by_id(id);
+        if (info == nullptr && !instance.m_lazy_ids.empty()) [[unlikely]] {
+            info = instance.materialize(L, id);
+        }
+        return info;
     }
 
     static type_info* find_type_info(lua_State* L, std::type_index idx) {
         type_storage& instance = get_instance(L);
-        auto it = instance.m_types.find(idx);
-        return it != instance.m_types.end() ? &it->second : nullptr;
+        type_info* info = instance.find(idx);
+        if (info == nullptr && !instance.m_lazy_ids.empty()) [[unlikely]] {
+            auto it = instance.m_lazy_ids.find(idx);
+            if (it != instance.m_lazy_ids.end()) {
+                info = instance.materialize(L, it->second);
+            }
+        }
+        return info;
+    }
+
+    // Records a binder, which runs when the type is first needed. See lazy.hpp.
+    void add_lazy(size_t id, std::type_index idx, lazy_entry&& entry) {
+        if (id >= m_lazy.size()) {
+            m_lazy.resize(id + 1);
+        }
+        m_lazy[id] = std::move(entry);
+        m_lazy_ids.emplace(idx, id);
+    }
+
+    bool is_lazy(size_t id) const {
+        return id < m_lazy.size() && m_lazy[id].bind != nullptr;
+    }
+
+    // The type with the given type_id, bound by its lazy binder if it has not been bound yet.
+    type_info* materialize(lua_State* L, size_t id) {
+        if (type_info* info = find_by_id(id)) {
+            return info;
+        }
+        auto taken = take_lazy(id);
+        if (!taken) {
+            return nullptr;
+        }
+        auto& [idx, entry] = *taken;
+        // a failed binder is put back, so the next access fails the same way instead of finding nothing
+        try {
+            entry.bind(L);
+        } catch (...) {
+            if (find_by_id(id) == nullptr) {
+                add_lazy(id, idx, std::move(entry));
+            }
+            throw;
+        }
+        type_info* info = find_by_id(id);
+        if (info == nullptr) {
+            const std::string name = entry.name;
+            add_lazy(id, idx, std::move(entry));
+            reportError("Lazy binder of '%s' did not bind it.", name.c_str());
+        }
+        if (entry.module_ref != LUA_NOREF) {
+            // class_ publishes the class as a global, it is moved to its module
+            lua_rawgeti(L, LUA_REGISTRYINDEX, entry.module_ref);
+            info->get_metatable(L);
+            lua_setfield(L, -2, entry.name.c_str());
+            lua_pop(L, 1);
+            luaL_unref(L, LUA_REGISTRYINDEX, entry.module_ref);
+            lua_pushglobaltable(L);
+            lua_pushstring(L, info->name.c_str());
+            lua_rawget(L, -2);
+            info->get_metatable(L);
+            if (lua_rawequal(L, -1, -2)) {
+                lua_pushstring(L, info->name.c_str());
+                lua_pushnil(L);
+                lua_rawset(L, -5);
+            }
+            lua_pop(L, 3);
+        }
+        return info;
+    }
+
+    type_info* find_by_id(size_t id) const {
+        return id < m_types_by_id.size() ? m_types_by_id[id] : nullptr;
+    }
+
+    // Looks up a member of the type or any of its bases by the name string at stack index `idx`.
+    // Members are resolved once into a flat table, so the lookup costs the same at any inheritance depth.
+    const member_data* find_member(lua_State* L, type_info* info, int idx) {
+        member_cache& cache = cache_of(info);
+        if (cache.version != info->members_version()) [[unlikely]] {
+            build_member_slots(L, info, cache);
+        }
+        size_t length;
+        const char* key = lua_tolstring(L, idx, &length);
+        // Lua interns short strings, so equal names share one address and slots can be compared by pointer
+        const size_t mask = cache.slots.size() - 1;
+        for (size_t i = slot_index(key, cache.slot_shift);; i = (i + 1) & mask) {
+            const member_cache::slot& slot = cache.slots[i];
+            if (slot.key == key) {
+                return &slot.member;
+            }
+            if (slot.key == nullptr) {
+                break;
+            }
+        }
+        // long strings are not interned, those names are compared by value
+        if (length >= cache.min_uninterned_length) [[unlikely]] {
+            const std::string_view name {key, length};
+            for (const auto& [n, member] : cache.uninterned_members) {
+                if (n == name) {
+                    return &member;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    // Refills method tables of the type and of its derived types, whose members changed since last fill.
+    void update_method_tables(lua_State* L, type_info* info) {
+        update_method_table(L, info);
+        for (type_info* d : info->derived) {
+            update_method_tables(L, d);
+        }
+    }
+
+    void update_method_table(lua_State* L, type_info* info) {
+        if (!has_option(info->options, class_options::method_table)) {
+            return;
+        }
+        member_cache& cache = cache_of(info);
+        if (cache.method_table_version != info->members_version()) [[unlikely]] {
+            fill_method_table(L, info);
+            cache.method_table_version = info->members_version();
+        }
     }
 
 private:
-    template <typename Base>
-    static void add_base_class(type_storage& instance, std::vector<type_info*>& bases) {
+    friend class schema;
+
+    // The pending binder of the type and its type_index.
+    std::optional<std::pair<std::type_index, lazy_entry>> take_lazy(size_t id) {
+        if (id >= m_lazy.size() || m_lazy[id].bind == nullptr) {
+            return std::nullopt;
+        }
+        // taken before binding, so the binder itself finds no pending entry
+        lazy_entry entry = std::move(m_lazy[id]);
+        m_lazy[id] = lazy_entry {};
+        for (auto it = m_lazy_ids.begin(); it != m_lazy_ids.end(); ++it) {
+            if (it->second == id) {
+                std::pair<std::type_index, lazy_entry> taken {it->first, std::move(entry)};
+                m_lazy_ids.erase(it);
+                return taken;
+            }
+        }
+        return std::nullopt;
+    }
+
+    type_info* find(std::type_index idx) {
+        auto it = m_types.find(idx);
+        if (it != m_types.end()) {
+            return &it->second;
+        }
+        if (m_schema != nullptr) {
+            auto shared = m_schema->get_types().find(idx);
+            if (shared != m_schema->get_types().end()) {
+                // lookups never modify shared types
+                return const_cast<type_info*>(&shared->second);
+            }
+        }
+        return nullptr;
+    }
+
+    member_cache& cache_of(const type_info* info) {
+        if (info->id >= m_caches.size()) [[unlikely]] {
+            m_caches.resize(info->id + 1);
+        }
+        return m_caches[info->id];
+    }
+
+    // Open addressing table keyed by the address of the interned name, at most half full.
+    static void build_member_slots(lua_State* L, type_info* info, member_cache& cache) {
+        const auto& members = info->members();
+        size_t capacity = 8;
+        while (capacity < members.size() * 2) {
+            capacity *= 2;
+        }
+        cache.slots.assign(capacity, member_cache::slot {nullptr, member_data {nullptr, nullptr}});
+        cache.slot_shift = 64;
+        for (size_t c = capacity; c > 1; c /= 2) {
+            --cache.slot_shift;
+        }
+        cache.uninterned_members.clear();
+        cache.min_uninterned_length = std::numeric_limits<size_t>::max();
+
+        // names are kept referenced from the registry, so their strings are never collected and their
+        // addresses are never reused by other strings
+        if (lua_getfield(L, LUA_REGISTRYINDEX, interned_names_key) != LUA_TTABLE) {
+            lua_pop(L, 1);
+            lua_newtable(L);
+            lua_pushvalue(L, -1);
+            lua_setfield(L, LUA_REGISTRYINDEX, interned_names_key);
+        }
+        for (const auto& [name, member] : members) {
+            const char* key = lua_pushlstring(L, name.data(), name.size());
+            const char* again = lua_pushlstring(L, name.data(), name.size());
+            lua_pop(L, 1);
+            if (key != again) {
+                // Lua did not intern a string of this length
+                cache.uninterned_members.emplace_back(name, member);
+                cache.min_uninterned_length = std::min(cache.min_uninterned_length, name.size());
+                lua_pop(L, 1);
+                continue;
+            }
+            lua_pushboolean(L, 1);
+            lua_rawset(L, -3);
+
+            const size_t mask = capacity - 1;
+            size_t i = slot_index(key, cache.slot_shift);
+            while (cache.slots[i].key != nullptr) {
+                i = (i + 1) & mask;
+            }
+            cache.slots[i] = member_cache::slot {key, member};
+        }
+        lua_pop(L, 1); // interned names
+        cache.version = info->members_version();
+    }
+
+    static size_t slot_index(const char* key, unsigned shift) {
+        // fibonacci hashing of the address
+        return static_cast<size_t>((reinterpret_cast<uintptr_t>(key) * 0x9E3779B97F4A7C15ull) >> shift);
+    }
+
+    // The method table is the first upvalue of the __index dispatcher, see class_options::method_table.
+    static void fill_method_table(lua_State* L, type_info* info) {
+        const auto& members = info->members();
+        if (!info->push_method_table(L)) {
+            return;
+        }
+        // emptied when the members changed, see type_info::invalidate_members
+        for (const auto& [name, member] : members) {
+            if (member.function != nullptr) {
+                lua_pushlstring(L, name.data(), name.size());
+                lua_pushcfunction(L, member.function);
+                lua_rawset(L, -3);
+            }
+        }
+        lua_pop(L, 1); // methods
+    }
+
+    template <typename Type, typename Base>
+    static void add_base_class(lua_State* L,
+                               type_storage& instance,
+                               std::vector<type_info*>& bases,
+                               std::vector<upcast_data>& upcasts) {
         static_assert(std::is_class_v<Base>);
-        auto base_it = instance.m_types.find(std::type_index(typeid(Base)));
-        if (base_it == instance.m_types.end()) {
+        static_assert(std::is_base_of_v<Base, Type>);
+        // a lazily bound base is bound now
+        type_info* base = instance.materialize(L, type_id<Base>());
+        if (base == nullptr) {
             reportError("Base class should be bound before child.");
         }
-        bases.push_back(&(base_it->second));
+        bases.push_back(base);
+
+        // virtual (or ambiguous) bases have no fixed offset, casts to them and to their ancestors are dynamic
+        constexpr bool is_dynamic = is_virtual_base_of<Base, Type>::value;
+        std::ptrdiff_t offset = 0;
+        if constexpr (!is_dynamic) {
+            offset = base_offset<Type, Base>();
+        }
+        add_upcast(upcasts, {base->id, offset, is_dynamic});
+        for (const upcast_data& upcast : base->upcasts) {
+            add_upcast(upcasts, {upcast.id, offset + upcast.offset, is_dynamic || upcast.is_dynamic});
+        }
+    }
+
+    static void add_upcast(std::vector<upcast_data>& upcasts, upcast_data upcast) {
+        auto it = std::find_if(upcasts.begin(), upcasts.end(), [&](const upcast_data& u) { return u.id == upcast.id; });
+        if (it == upcasts.end()) {
+            upcasts.push_back(upcast);
+        } else if (it->offset != upcast.offset || it->is_dynamic != upcast.is_dynamic) {
+            // reachable by several paths, leave it to dynamic_cast to resolve or reject
+            it->is_dynamic = true;
+        }
     }
 
 public:
-    using types = std::unordered_map<std::type_index, type_info>;
+    using types = schema::types;
 
 private:
+    static constexpr const char* interned_names_key = "LuaBindInternedNames";
+
+    // types bound in this state, the ones of the schema are not copied
     types m_types;
+    std::shared_ptr<const schema> m_schema;
+    // type_info pointers of both, indexed by type_id
+    std::vector<type_info*> m_types_by_id;
+    // indexed by type_id
+    std::vector<member_cache> m_caches;
+    // binders of types not bound yet, indexed by type_id, and the type_id of each of them
+    std::vector<lazy_entry> m_lazy;
+    std::unordered_map<std::type_index, size_t> m_lazy_ids;
 };
 
+inline std::shared_ptr<const schema> schema::capture(lua_State* L) {
+    type_storage& storage = type_storage::get_instance(L);
+    if (storage.m_schema != nullptr) {
+        reportError("Types of a state using a schema cannot be captured again.");
+    }
+    auto s = std::make_shared<schema>();
+    // nodes of the map keep their addresses, so type_info pointers held by L stay valid
+    s->_types = std::move(storage.m_types);
+    storage.m_types.clear();
+    s->_types_by_id = storage.m_types_by_id;
+    for (auto& [index, info] : s->_types) {
+        // nothing is resolved lazily once the types are shared between threads
+        info.ensure_members();
+        info._shared = true;
+    }
+    storage.m_schema = s;
+    return s;
+}
+
+inline void schema::attach(lua_State* L, std::shared_ptr<const schema> s) {
+    type_storage& storage = type_storage::get_instance(L);
+    if (storage.m_schema != nullptr || !storage.m_types.empty()) {
+        reportError("A schema can only be attached to a state with no bound types.");
+    }
+    storage.m_types_by_id = s->_types_by_id;
+    for (const auto& [index, info] : s->_types) {
+        info.create_metatable(L);
+    }
+    storage.m_schema = std::move(s);
+}
+
 } // namespace luabind
 
 #endif // LUABIND_TYPE_STORAGE_HPP
@@ -4,53 +4,143 @@
 #include "object.hpp"
 #include "type_storage.hpp"
 
+#include <cstdint>
 #include <memory>
+#include <new>
+#include <type_traits>
 #include <utility>
 
 namespace luabind {
 
 enum class memory_lifetime { lua, cpp, shared };
 
+// Optional per-state cache of the userdata pushed for objects, with a weak table per type from address to userdata.
+// While the cache is enabled, pushing an object which is still alive in Lua returns the same userdata,
+// so no allocation happens and two pushes of one object compare equal.
+// Objects are identified by type and address, so objects of different types sharing an address, e.g. after
+// memory is reused, don't replace each other. A raw pointer to memory freed by C++ and reused for a new object
+// of the same type resolves to the old userdata though. Objects of types which are not bound are not cached.
+class identity_cache {
+public:
+    static void enable(lua_State* L) {
+        if (lua_rawgetp(L, LUA_REGISTRYINDEX, &key) != LUA_TTABLE) {
+            lua_newtable(L);
+            lua_rawsetp(L, LUA_REGISTRYINDEX, &key);
+        }
+        lua_pop(L, 1);
+    }
+
+    // Pushes the table of the objects of type `info` and returns true, or pushes nil and returns false
+    // if the cache is not enabled, or if the type has no table yet and `create` is false.
+    static bool push(lua_State* L, const type_info* info, bool create) {
+        if (lua_rawgetp(L, LUA_REGISTRYINDEX, &key) != LUA_TTABLE) [[likely]] {
+            return false;
+        }
+        const bool found = lua_rawgetp(L, -1, info) == LUA_TTABLE;
+        if (found || !create) {
+            lua_remove(L, -2);
+            return found;
+        }
+        lua_pop(L, 1);
+        lua_newtable(L);
+        lua_createtable(L, 0, 1);
+        lua_pushliteral(L, "v");
+        lua_setfield(L, -2, "__mode");
+        lua_setmetatable(L, -2);
+        lua_pushvalue(L, -1);
+        lua_rawsetp(L, -3, info);
+        lua_remove(L, -2);
+        return true;
+    }
+
+private:
+    static inline const char key = 0;
+};
+
 class user_data {
 public:
+    // marks userdata created by luabind, Lua code can pass any other full userdata as an argument
+    static constexpr std::uint32_t luabind_tag = 0x4C42554Du;
+
     Object* const object;
     type_info* const info;
+    // the object as the type described by info, used for casts without RTTI
+    void* const instance;
     const memory_lifetime lifetime;
+    const std::uint32_t tag;
 
 protected:
-    user_data(Object* object, type_info* info, memory_lifetime lifetime)
+    user_data(Object* object, type_info* info, void* instance, memory_lifetime lifetime)
         : object(object)
         , info(info)
-        , lifetime(lifetime) {}
+        , instance(instance)
+        , lifetime(lifetime)
+        , tag(luabind_tag) {}
 
+    // info of a pointer is looked up by its dynamic type, instance has to point to the most derived object then
     template <typename T>
-    user_data(lua_State* L, T* object, memory_lifetime lifetime)
-        : user_data(object, type_storage::find_type_info(L, object), lifetime) {}
+    static void* instance_pointer(T* v, const type_info* info) {
+        using raw_type = std::remove_cv_t<T>;
+        if constexpr (std::is_polymorphic_v<raw_type>) {
+            if (info != nullptr && info->id != type_id<raw_type>()) {
+                return const_cast<void*>(dynamic_cast<const void*>(v));
+            }
+        }
+        return const_cast<raw_type*>(v);
+    }
 
 public:
     virtual ~user_data() {
         const_cast<Object*&>(object) = nullptr;
     };
 
+    // Only a marked metatable guarantees the header, value types are never marked.
     static user_data* from_lua(lua_State* L, int idx) {
-        if (lua_islightuserdata(L, idx) == 1) {
+        if (lua_type(L, idx) != LUA_TUSERDATA || lua_rawlen(L, idx) < sizeof(user_data) || !lua_getmetatable(L, idx)) {
             return nullptr;
         }
-        return static_cast<user_data*>(lua_touserdata(L, idx));
+        const bool marked = lua_rawgetp(L, -1, &type_info::metatable_marker) != LUA_TNIL;
+        lua_pop(L, 2);
+        if (!marked) [[unlikely]] {
+            return nullptr;
+        }
+        auto* ud = static_cast<user_data*>(lua_touserdata(L, idx));
+        return ud->tag == luabind_tag ? ud : nullptr;
+    }
+
+    // Casts the object to T with the upcast table of its type, returns nullptr if it is not a T.
+    // dynamic_cast is left for virtual bases and for types not known to the binding.
+    template <typename T>
+    T* cast() const {
+        if (object == nullptr) [[unlikely]] {
+            return nullptr;
+        }
+        if (info != nullptr) [[likely]] {
+            const size_t id = type_id<std::remove_cv_t<T>>();
+            if (info->id == id) {
+                return static_cast<T*>(instance);
+            }
+            const upcast_data* upcast = info->find_upcast(id);
+            if (upcast != nullptr && !upcast->is_dynamic) {
+                return reinterpret_cast<T*>(static_cast<char*>(instance) + upcast->offset);
+            }
+        }
+        return dynamic_cast<T*>(object);
     }
 
 public:
-    static void* new_userdata(lua_State* L, size_t size) {
-        void* ud = lua_newuserdatauv(L, size, 1);
-        lua_newtable(L);
-        lua_setiuservalue(L, -2, 1);
-        return ud;
+    // The custom table is created only when a value is first stored in it,
+    // objects of sealed types do not have a slot for it at all.
+    static void* new_userdata(lua_State* L, size_t size, const type_info* info) {
+        const bool sealed = info != nullptr && has_option(info->options, class_options::sealed);
+        return lua_newuserdatauv(L, size, sealed ? 0 : 1);
     }
 
     static void get_destructing_metatable(lua_State* L) {
         lua_newtable(L);
         int table_idx = lua_gettop(L);
         add_destructing_functions(L, table_idx);
+        type_info::mark_metatable(L, table_idx);
     }
 
     static void add_destructing_functions(lua_State* L, int table_idx) {
@@ -59,21 +149,86 @@ public:
         lua_rawset(L, table_idx);
     }
 
+    // Pushes the custom table of the object, or nil if it was not created yet.
     static void get_custom_table(lua_State* L, int idx) {
         lua_getiuservalue(L, idx, 1);
     }
 
+    static void get_or_create_custom_table(lua_State* L, int idx) {
+        if (lua_getiuservalue(L, idx, 1) != LUA_TTABLE) {
+            lua_pop(L, 1);
+            idx = lua_absindex(L, idx);
+            lua_newtable(L);
+            lua_pushvalue(L, -1);
+            lua_setiuservalue(L, idx, 1);
+        }
+    }
+
     static void set_custom_table(lua_State* L, int idx) {
         lua_setiuservalue(L, idx, 1);
     }
 
+    // Reachable from Lua as `delete` and through the metatable, so self is checked.
     static int destruct(lua_State* L) {
-        user_data* ud = from_lua(L, -1);
+        user_data* ud = from_lua(L, 1);
+        if (ud == nullptr) [[unlikely]] {
+            raiseError(L, "Expecting user_data to delete, but got lua type '%s'.", luaL_typename(L, 1));
+        }
         if (ud->object != nullptr) {
+            remove_cached(L, ud);
             ud->~user_data();
         }
         return 0;
     }
+
+protected:
+    // Pushes the userdata cached for `address` if it is alive and compatible with the requested lifetime.
+    // Raw pointers may resolve to an object owned by Lua or by a shared_ptr, shared_ptrs only to a shared one.
+    static bool push_cached(lua_State* L, const void* address, const type_info* info, memory_lifetime lifetime) {
+        if (info == nullptr) {
+            return false;
+        }
+        if (!identity_cache::push(L, info, false)) [[likely]] {
+            lua_pop(L, 1);
+            return false;
+        }
+        if (lua_rawgetp(L, -1, address) == LUA_TUSERDATA) {
+            auto* ud = static_cast<user_data*>(lua_touserdata(L, -1));
+            if (ud->object != nullptr && (lifetime == memory_lifetime::cpp || ud->lifetime == lifetime)) {
+                lua_remove(L, -2);
+                return true;
+            }
+        }
+        lua_pop(L, 2);
+        return false;
+    }
+
+    // Caches the userdata on top of the stack under `address` in the table of its type.
+    static void add_cached(lua_State* L, const void* address, const type_info* info) {
+        if (info == nullptr) {
+            return;
+        }
+        if (identity_cache::push(L, info, true)) {
+            lua_pushvalue(L, -2);
+            lua_rawsetp(L, -2, address);
+        }
+        lua_pop(L, 1);
+    }
+
+    static void remove_cached(lua_State* L, const user_data* ud) {
+        if (ud->info == nullptr) {
+            return;
+        }
+        // collected userdata are already cleared from the weak table, only explicit delete finds itself there
+        if (identity_cache::push(L, ud->info, false)) {
+            if (lua_rawgetp(L, -1, ud->instance) == LUA_TUSERDATA && lua_touserdata(L, -1) == ud) {
+                lua_pushnil(L);
+                lua_rawsetp(L, -3, ud->instance);
+            }
+            lua_pop(L, 1);
+        }
+        lua_pop(L, 1);
+    }
 };
 
 template <typename T>
@@ -82,25 +237,28 @@ public:
     T data;
 
     template <typename... Args>
-    lua_user_data(lua_State* L, Args&&... args)
-        : user_data(nullptr, type_storage::find_type_info<T>(L), memory_lifetime::lua)
+    lua_user_data(type_info* info, Args&&... args)
+        : user_data(nullptr, info, nullptr, memory_lifetime::lua)
         , data(std::forward<Args>(args)...) {
         // do not pass &data in user_data ctor, because in case of virtual inheritance
         // cast to Object* is implicitly dynamic_cast and needs fully initialized data
         const_cast<Object*&>(object) = &data;
+        const_cast<void*&>(instance) = const_cast<std::remove_cv_t<T>*>(&data);
     }
 
     template <typename... Args>
     static int to_lua(lua_State* L, Args&&... args) {
         static_assert(std::is_constructible_v<T, Args...>);
-        void* p = new_userdata(L, sizeof(lua_user_data));
-        lua_user_data* ud = new (p) lua_user_data(L, std::forward<Args>(args)...);
+        type_info* info = type_storage::find_type_info<T>(L);
+        void* p = new_userdata(L, sizeof(lua_user_data), info);
+        lua_user_data* ud = new (p) lua_user_data(info, std::forward<Args>(args)...);
         if (ud->info != nullptr) {
             ud->info->get_metatable(L);
         } else {
             get_destructing_metatable(L);
         }
         lua_setmetatable(L, -2);
+        add_cached(L, ud->instance, ud->info);
         return 1;
     }
 };
@@ -109,45 +267,124 @@ template <typename T>
 struct cpp_user_data : user_data {
     T* data;
 
-    cpp_user_data(lua_State* L, T* v)
-        : user_data(L, v, memory_lifetime::cpp)
+    cpp_user_data(T* v, type_info* info)
+        : user_data(v, info, instance_pointer(v, info), memory_lifetime::cpp)
         , data(v) {}
 
     static int to_lua(lua_State* L, T* v) {
-        void* p = new_userdata(L, sizeof(cpp_user_data));
-        cpp_user_data* ud = new (p) cpp_user_data(L, v);
+        type_info* info = type_storage::find_type_info(L, v);
+        const void* instance = instance_pointer(v, info);
+        if (push_cached(L, instance, info, memory_lifetime::cpp)) {
+            return 1;
+        }
+        void* p = new_userdata(L, sizeof(cpp_user_data), info);
+        cpp_user_data* ud = new (p) cpp_user_data(v, info);
         if (ud->info != nullptr) {
             ud->info->get_metatable(L);
         } else {
             get_destructing_metatable(L);
         }
         lua_setmetatable(L, -2);
+        add_cached(L, instance, info);
         return 1;
     }
 };
 
+// Userdata of a value type (see is_value_type), with no user_data header, vtable, __gc or custom table.
+// The value follows a tag and the type_id of T, which identify it instead of RTTI.
+template <typename T>
+struct value_user_data {
+    static_assert(is_value_type_v<T>);
+
+    // differs from user_data::luabind_tag, so neither is taken for the other
+    static constexpr std::uint32_t value_tag = 0x4C425654u;
+
+    std::uint32_t tag;
+    std::uint32_t id;
+    T data;
+
+    template <typename... Args>
+    static int to_lua(lua_State* L, Args&&... args) {
+        static_assert(std::is_constructible_v<T, Args...>);
+        void* p = lua_newuserdatauv(L, sizeof(value_user_data), 0);
+        auto* ud = static_cast<value_user_data*>(p);
+        ud->tag = value_tag;
+        ud->id = static_cast<std::uint32_t>(type_id<T>());
+        new (&ud->data) T(std::forward<Args>(args)...);
+        if (type_info* info = type_storage::find_type_info<T>(L)) [[likely]] {
+            info->get_metatable(L);
+            lua_setmetatable(L, -2);
+        }
+        return 1;
+    }
+
+    // The value stored in the userdata at `idx`, or nullptr if it is not a T.
+    static T* from_lua(lua_State* L, int idx) {
+        if (lua_type(L, idx) != LUA_TUSERDATA || lua_rawlen(L, idx) != sizeof(value_user_data)) {
+            return nullptr;
+        }
+        auto* ud = static_cast<value_user_data*>(lua_touserdata(L, idx));
+        return ud->tag == value_tag && ud->id == type_id<T>() ? &ud->data : nullptr;
+    }
+};
+
+template <typename T>
+struct typed_shared_user_data;
+
 struct shared_user_data : user_data {
-    std::shared_ptr<Object> data;
+    // type_id of the element type of the stored shared_ptr
+    const size_t element_id;
 
     template <typename T>
-    shared_user_data(lua_State* L, std::shared_ptr<T> v)
-        : user_data(L, v.get(), memory_lifetime::shared)
-        , data(std::move(v)) {}
+    shared_user_data(T* v, type_info* info)
+        : user_data(v, info, instance_pointer(v, info), memory_lifetime::shared)
+        , element_id(type_id<T>()) {}
+
+    // The stored shared_ptr if its element type is exactly T, nullptr otherwise.
+    template <typename T>
+    const std::shared_ptr<T>* get_if() const {
+        if (element_id != type_id<T>() || object == nullptr) {
+            return nullptr;
+        }
+        return &static_cast<const typed_shared_user_data<T>*>(this)->data;
+    }
+
+    // Copy of the stored shared_ptr, to construct aliasing pointers from.
+    virtual std::shared_ptr<void> owner() const = 0;
 
     template <typename T>
     static int to_lua(lua_State* L, std::shared_ptr<T> v) {
-        void* p = new_userdata(L, sizeof(shared_user_data));
-        shared_user_data* ud = new (p) shared_user_data(L, std::move(v));
+        type_info* info = type_storage::find_type_info(L, v.get());
+        const void* instance = instance_pointer(v.get(), info);
+        if (push_cached(L, instance, info, memory_lifetime::shared)) {
+            return 1;
+        }
+        void* p = new_userdata(L, sizeof(typed_shared_user_data<T>), info);
+        auto* ud = new (p) typed_shared_user_data<T>(std::move(v), info);
         if (ud->info != nullptr) {
             ud->info->get_metatable(L);
         } else {
             get_destructing_metatable(L);
         }
         lua_setmetatable(L, -2);
+        add_cached(L, instance, info);
         return 1;
     }
 };
 
+template <typename T>
+struct typed_shared_user_data : shared_user_data {
+    std::shared_ptr<T> data;
+
+    typed_shared_user_data(std::shared_ptr<T> v, type_info* info)
+        : shared_user_data(v.get(), info)
+        , data(std::move(v)) {}
+
+    std::shared_ptr<void> owner() const override {
+        return data;
+    }
+};
+
 } // namespace luabind
 
 #endif // LUABIND_USER_DATA
@@ -5,16 +5,31 @@
 #include "lua.hpp"
 #include "mirror.hpp"
 
+#include <cstddef>
+#include <cstdint>
 #include <exception>
+#include <tuple>
 #include <type_traits>
+#include <utility>
 
 namespace luabind {
 
 template <typename CRTP>
 struct exception_safe_wrapper {
     static int safe_invoke(lua_State* L) {
+        return safe_call(L, [L] { return CRTP::invoke(L); });
+    }
+
+    // lua_KFunction continuing a call which yielded, Lua calls it directly and not through safe_invoke
+    static int safe_continue(lua_State* L, int status, lua_KContext ctx) {
+        return safe_call(L, [=] { return CRTP::resume(L, status, ctx); });
+    }
+
+private:
+    template <typename F>
+    static int safe_call(lua_State* L, const F& f) {
         try {
-            return CRTP::invoke(L);
+            return f();
         } catch (void*) {
             // lua throws lua_longjmp* if compiled with C++ exceptions when yielding or reporting error
             // rethrow to not interrupt lua logic flow in that case.
@@ -32,10 +47,243 @@ struct exception_safe_wrapper {
     }
 };
 
+// Returned by a bound function instead of the number of its results when they are not ready yet,
+// e.g. by a suspended task. The function leaves a light userdata pointing to a pending_result on top of the stack,
+// and lua_function yields the calling coroutine until the result is complete.
+inline constexpr int pending_results = -1;
+
+// Event loop running the coroutines of a state, e.g. scheduler. A coroutine of the loop waiting for a pending result
+// is not resumed by the loop until the result is ready, complete() then hands it back to the loop.
+class coroutine_loop {
+public:
+    // Loop attached to the state, or nullptr.
+    static coroutine_loop* find(lua_State* L) {
+        lua_rawgetp(L, LUA_REGISTRYINDEX, &key);
+        auto* loop = static_cast<coroutine_loop*>(lua_touserdata(L, -1));
+        lua_pop(L, 1);
+        return loop;
+    }
+
+    // The coroutine `thread` starts waiting for a pending result.
+    virtual void suspend(lua_State* thread) = 0;
+
+    // The result `thread` waits for is ready. Returns false if the loop does not run the coroutine.
+    virtual bool wake(lua_State* thread) = 0;
+
+protected:
+    ~coroutine_loop() = default;
+
+    void attach(lua_State* L) {
+        lua_pushlightuserdata(L, this);
+        lua_rawsetp(L, LUA_REGISTRYINDEX, &key);
+    }
+
+    static void detach(lua_State* L) {
+        lua_pushnil(L);
+        lua_rawsetp(L, LUA_REGISTRYINDEX, &key);
+    }
+
+private:
+    static inline const char key = 0;
+};
+
+// Call which waits for its results. complete() resumes the waiting coroutine, which pushes the results
+// and releases the call. Calls still pending when the state is closed are released with it.
+class pending_result : public exception_safe_wrapper<pending_result> {
+public:
+    virtual bool ready() const = 0;
+
+    // pushes the results of a ready call, or throws its error
+    virtual int push_results(lua_State* L) = 0;
+
+    // frees the call, e.g. destroys the coroutine frame holding it
+    virtual void release() = 0;
+
+    // Yields the coroutine which called the function leaving the result on top of the stack.
+    static int await(lua_State* L) {
+        auto* pending = static_cast<pending_result*>(lua_touserdata(L, -1));
+        pending->link(L);
+        if (lua_isyieldable(L) == 0) [[unlikely]] {
+            // released once it completes, as nobody waits for it
+            raiseError(L, "The function has to wait for its result, it can only be called from a coroutine.");
+        }
+        lua_rawgeti(L, LUA_REGISTRYINDEX, LUA_RIDX_MAINTHREAD);
+        pending->_main = lua_tothread(L, -1);
+        // the coroutine may be referenced by nobody else while it waits
+        lua_pushthread(L);
+        pending->_thread_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+        lua_pop(L, 1);
+        pending->_thread = L;
+        // the light userdata stays on the stack, telling which call the coroutine waits for
+        pending->_slot = lua_gettop(L);
+        if (coroutine_loop* loop = coroutine_loop::find(L)) {
+            loop->suspend(L);
+        }
+        return lua_yieldk(L, 0, reinterpret_cast<lua_KContext>(pending), &safe_continue);
+    }
+
+    static int resume(lua_State* L, int /*status*/, lua_KContext ctx) {
+        auto* pending = reinterpret_cast<pending_result*>(ctx);
+        // values passed by whoever resumed the coroutine are ignored
+        lua_settop(L, pending->_slot - 1);
+        if (!pending->ready()) {
+            // resumed before the result is complete, keep waiting
+            lua_pushlightuserdata(L, pending);
+            return lua_yieldk(L, 0, ctx, &safe_continue);
+        }
+        struct releaser {
+            pending_result* pending;
+
+            ~releaser() {
+                pending->unlink();
+                pending->release();
+            }
+        } guard {pending};
+        return pending->push_results(L);
+    }
+
+    // Resumes the coroutine waiting for the ready result, which releases it, and returns true.
+    // A coroutine run by a coroutine_loop is resumed by the loop later instead.
+    // Returns false if nobody waits for the result anymore, the caller releases it then.
+    // A coroutine failing after the resume has no caller to get the error, it's reported by lua_warning.
+    bool complete() {
+        lua_State* thread = _thread;
+        if (thread == nullptr) {
+            // the call failed to yield
+            unlink();
+            return false;
+        }
+        lua_State* L = _main;
+        const int ref = _thread_ref;
+        const bool waiting =
+            lua_status(thread) == LUA_YIELD && lua_gettop(thread) >= _slot && lua_touserdata(thread, _slot) == this;
+        if (!waiting) {
+            // the coroutine was closed
+            unlink();
+            luaL_unref(L, LUA_REGISTRYINDEX, ref);
+            return false;
+        }
+        if (coroutine_loop* loop = coroutine_loop::find(L); loop != nullptr && loop->wake(thread)) {
+            // the loop keeps the coroutine alive and resumes it, which releases this
+            _thread_ref = LUA_NOREF;
+            luaL_unref(L, LUA_REGISTRYINDEX, ref);
+            return true;
+        }
+        // the coroutine releases this, only locals are used from now on
+        int results = 0;
+        const int status = lua_resume(thread, L, 0, &results);
+        if (status == LUA_OK || status == LUA_YIELD) {
+            lua_pop(thread, results);
+        } else {
+            lua_warning(L, "error in resumed coroutine (", 1);
+            lua_warning(L, lua_isstring(thread, -1) ? lua_tostring(thread, -1) : "no message", 1);
+            lua_warning(L, ")", 0);
+            lua_pop(thread, 1);
+        }
+        luaL_unref(L, LUA_REGISTRYINDEX, ref);
+        return true;
+    }
+
+protected:
+    ~pending_result() = default;
+
+private:
+    // Calls pending in a state, in a list released when the state is closed.
+    static pending_result** list(lua_State* L) {
+        if (lua_rawgetp(L, LUA_REGISTRYINDEX, &list_key) == LUA_TUSERDATA) [[likely]] {
+            auto** head = static_cast<pending_result**>(lua_touserdata(L, -1));
+            lua_pop(L, 1);
+            return head;
+        }
+        lua_pop(L, 1);
+        auto** head = static_cast<pending_result**>(lua_newuserdatauv(L, sizeof(pending_result*), 0));
+        *head = nullptr;
+        lua_createtable(L, 0, 1);
+        lua_pushcfunction(L, [](lua_State* L) -> int {
+            auto** head = static_cast<pending_result**>(lua_touserdata(L, 1));
+            while (pending_result* pending = *head) {
+                pending->unlink();
+                pending->release();
+            }
+            return 0;
+        });
+        lua_setfield(L, -2, "__gc");
+        lua_setmetatable(L, -2);
+        lua_rawsetp(L, LUA_REGISTRYINDEX, &list_key);
+        return head;
+    }
+
+    void link(lua_State* L) {
+        _list = list(L);
+        _next = *_list;
+        if (_next != nullptr) {
+            _next->_prev = this;
+        }
+        *_list = this;
+    }
+
+    void unlink() {
+        if (_list == nullptr) {
+            return;
+        }
+        if (_prev != nullptr) {
+            _prev->_next = _next;
+        } else {
+            *_list = _next;
+        }
+        if (_next != nullptr) {
+            _next->_prev = _prev;
+        }
+        _list = nullptr;
+        _prev = nullptr;
+        _next = nullptr;
+    }
+
+    static inline const char list_key = 0;
+
+    pending_result** _list = nullptr;
+    pending_result* _prev = nullptr;
+    pending_result* _next = nullptr;
+    lua_State* _main = nullptr;
+    // the waiting coroutine, its registry reference and the stack index of the light userdata
+    lua_State* _thread = nullptr;
+    int _thread_ref = LUA_NOREF;
+    int _slot = 0;
+};
+
+// Whether the Lua arguments starting at `First` match Args, see mirror_matches.
+template <int First, typename... Args>
+bool arguments_match(lua_State* L) {
+    return [L]<size_t... Indices>(std::index_sequence<Indices...>) {
+        return (mirror_matches<Args>(L, static_cast<int>(Indices)) && ...);
+    }(index_sequence<First, sizeof...(Args)> {});
+}
+
+// Whether conversion errors of arguments are raised as Lua errors right away, with no C++ exception in between.
+// A longjmp out of a conversion skips destructors, so none of the converted values may have one:
+// arguments are evaluated in no particular order. Otherwise exception_safe_wrapper raises the thrown error.
+template <typename... Args>
+inline constexpr bool raises_argument_errors =
+    (std::is_trivially_destructible_v<decltype(value_mirror<Args>::from_lua(nullptr, 0))> && ...);
+
+// Converts the argument at `idx` of a lua_CFunction, Args are the other arguments converted for the same call.
+template <typename T, typename... Args>
+decltype(auto) argument_from_lua(lua_State* L, int idx) {
+    return mirror_from_lua<T>(L, place(idx, raises_argument_errors<T, Args...>));
+}
+
 template <typename Type, typename... Args>
 struct ctor_wrapper {
     static_assert(std::conjunction_v<valid_lua_arg<Args>...>);
 
+    // index of the first argument on the Lua stack and the expected number of Lua arguments
+    static constexpr int first_arg = 2;
+    static constexpr int arity = first_arg - 1 + static_cast<int>(sizeof...(Args));
+
+    static bool matches(lua_State* L) {
+        return arguments_match<first_arg, Args...>(L);
+    }
+
     static int invoke(lua_State* L) {
         // 1st argument is the metatable
         return indexed_call_helper(L, index_sequence<2, sizeof...(Args)> {});
@@ -46,16 +294,31 @@ struct ctor_wrapper {
         int num_args = lua_gettop(L);
         // +1 first argument is the Type metatable
         if (num_args != sizeof...(Args) + 1) {
-            reportError(
-                "Invalid number of arguments, should be %zu, but %i were given.", sizeof...(Args), num_args - 1);
+            raiseError(L,
+                       "Invalid number of arguments, should be %d, but %d were given.",
+                       static_cast<int>(sizeof...(Args)),
+                       num_args - 1);
+        }
+        if constexpr (is_value_type_v<Type>) {
+            return value_user_data<Type>::to_lua(L, argument_from_lua<Args, Args...>(L, Indices)...);
+        } else {
+            return lua_user_data<Type>::to_lua(L, argument_from_lua<Args, Args...>(L, Indices)...);
         }
-        return lua_user_data<Type>::to_lua(L, value_mirror<Args>::from_lua(L, Indices)...);
     }
 };
 
 template <typename Type, typename... Args>
 struct shared_ctor_wrapper {
     static_assert(std::conjunction_v<valid_lua_arg<Args>...>);
+    static_assert(!is_value_type_v<Type>, "Value types are stored in the userdata, they cannot be shared.");
+
+    // index of the first argument on the Lua stack and the expected number of Lua arguments
+    static constexpr int first_arg = 2;
+    static constexpr int arity = first_arg - 1 + static_cast<int>(sizeof...(Args));
+
+    static bool matches(lua_State* L) {
+        return arguments_match<first_arg, Args...>(L);
+    }
 
     static int invoke(lua_State* L) {
         // 1st argument is the metatable
@@ -67,10 +330,12 @@ struct shared_ctor_wrapper {
         int num_args = lua_gettop(L);
         // +1 first argument is the Type metatable
         if (num_args != sizeof...(Args) + 1) {
-            reportError(
-                "Invalid number of arguments, should be %zu, but %i were given.", sizeof...(Args), num_args - 1);
+            raiseError(L,
+                       "Invalid number of arguments, should be %d, but %d were given.",
+                       static_cast<int>(sizeof...(Args)),
+                       num_args - 1);
         }
-        return shared_user_data::to_lua(L, std::make_shared<Type>(value_mirror<Args>::from_lua(L, Indices)...));
+        return shared_user_data::to_lua(L, std::make_shared<Type>(argument_from_lua<Args, Args...>(L, Indices)...));
     }
 };
 
@@ -81,6 +346,14 @@ template <typename R, typename T, typename... Args, R (T::*func)(Args...)>
 struct function_wrapper<R (T::*)(Args...), func> {
     static_assert(std::conjunction_v<valid_lua_arg<R>, valid_lua_arg<Args>...>);
 
+    // index of the first argument on the Lua stack and the expected number of Lua arguments
+    static constexpr int first_arg = 2;
+    static constexpr int arity = first_arg - 1 + static_cast<int>(sizeof...(Args));
+
+    static bool matches(lua_State* L) {
+        return arguments_match<first_arg, Args...>(L);
+    }
+
     static int invoke(lua_State* L) {
         return indexed_call_helper(L, index_sequence<2, sizeof...(Args)> {});
     }
@@ -89,21 +362,31 @@ struct function_wrapper<R (T::*)(Args...), func> {
     static int indexed_call_helper(lua_State* L, std::index_sequence<Indices...>) {
         int num_args = lua_gettop(L);
         if (num_args != sizeof...(Args) + 1) {
-            reportError(
-                "Invalid number of arguments, should be %zu, but %i were given.", sizeof...(Args), num_args - 1);
+            raiseError(L,
+                       "Invalid number of arguments, should be %d, but %d were given.",
+                       static_cast<int>(sizeof...(Args)),
+                       num_args - 1);
         }
-        T* self = value_mirror<T*>::from_lua(L, 1);
+        T* self = argument_from_lua<T*>(L, 1);
         if constexpr (std::is_same_v<R, void>) {
-            (self->*func)(value_mirror<Args>::from_lua(L, Indices)...);
+            (self->*func)(argument_from_lua<Args, Args...>(L, Indices)...);
             return 0;
         } else {
-            return value_mirror<R>::to_lua(L, (self->*func)(value_mirror<Args>::from_lua(L, Indices)...));
+            return value_mirror<R>::to_lua(L, (self->*func)(argument_from_lua<Args, Args...>(L, Indices)...));
         }
     }
 };
 
 template <typename R, typename T, typename... Args, R (T::*func)(Args...) const>
 struct function_wrapper<R (T::*)(Args...) const, func> {
+    // index of the first argument on the Lua stack and the expected number of Lua arguments
+    static constexpr int first_arg = 2;
+    static constexpr int arity = first_arg - 1 + static_cast<int>(sizeof...(Args));
+
+    static bool matches(lua_State* L) {
+        return arguments_match<first_arg, Args...>(L);
+    }
+
     static int invoke(lua_State* L) {
         return indexed_call_helper(L, index_sequence<2, sizeof...(Args)> {});
     }
@@ -112,21 +395,31 @@ struct function_wrapper<R (T::*)(Args...) const, func> {
     static int indexed_call_helper(lua_State* L, std::index_sequence<Indices...>) {
         int num_args = lua_gettop(L);
         if (num_args != sizeof...(Args) + 1) {
-            reportError(
-                "Invalid number of arguments, should be %zu, but %i were given.", sizeof...(Args), num_args - 1);
+            raiseError(L,
+                       "Invalid number of arguments, should be %d, but %d were given.",
+                       static_cast<int>(sizeof...(Args)),
+                       num_args - 1);
         }
-        const T* self = value_mirror<const T*>::from_lua(L, 1);
+        const T* self = argument_from_lua<const T*>(L, 1);
         if constexpr (std::is_same_v<R, void>) {
-            (self->*func)(value_mirror<Args>::from_lua(L, Indices)...);
+            (self->*func)(argument_from_lua<Args, Args...>(L, Indices)...);
             return 0;
         } else {
-            return value_mirror<R>::to_lua(L, (self->*func)(value_mirror<Args>::from_lua(L, Indices)...));
+            return value_mirror<R>::to_lua(L, (self->*func)(argument_from_lua<Args, Args...>(L, Indices)...));
         }
     }
 };
 
 template <typename R, typename... Args, R (*func)(Args...)>
 struct function_wrapper<R (*)(Args...), func> {
+    // index of the first argument on the Lua stack and the expected number of Lua arguments
+    static constexpr int first_arg = 1;
+    static constexpr int arity = first_arg - 1 + static_cast<int>(sizeof...(Args));
+
+    static bool matches(lua_State* L) {
+        return arguments_match<first_arg, Args...>(L);
+    }
+
     static int invoke(lua_State* L) {
         return indexed_call_helper(L, index_sequence<1, sizeof...(Args)> {});
     }
@@ -135,13 +428,16 @@ struct function_wrapper<R (*)(Args...), func> {
     static int indexed_call_helper(lua_State* L, std::index_sequence<Indices...>) {
         int num_args = lua_gettop(L);
         if (num_args != sizeof...(Args)) {
-            reportError("Invalid number of arguments, should be %zu, but %i were given.", sizeof...(Args), num_args);
+            raiseError(L,
+                       "Invalid number of arguments, should be %d, but %d were given.",
+                       static_cast<int>(sizeof...(Args)),
+                       num_args);
         }
         if constexpr (std::is_same_v<R, void>) {
-            (*func)(value_mirror<Args>::from_lua(L, Indices)...);
+            (*func)(argument_from_lua<Args, Args...>(L, Indices)...);
             return 0;
         } else {
-            return value_mirror<R>::to_lua(L, (*func)(value_mirror<Args>::from_lua(L, Indices)...));
+            return value_mirror<R>::to_lua(L, (*func)(argument_from_lua<Args, Args...>(L, Indices)...));
         }
     }
 };
@@ -153,6 +449,14 @@ template <typename R, typename... Args, R (*func)(Args...)>
 struct class_function_wrapper<R (*)(Args...), func> {
     static_assert(std::conjunction_v<valid_lua_arg<R>, valid_lua_arg<Args>...>);
 
+    // index of the first argument on the Lua stack and the expected number of Lua arguments
+    static constexpr int first_arg = 2;
+    static constexpr int arity = first_arg - 1 + static_cast<int>(sizeof...(Args));
+
+    static bool matches(lua_State* L) {
+        return arguments_match<first_arg, Args...>(L);
+    }
+
     static int invoke(lua_State* L) {
         return indexed_call_helper(L, index_sequence<2, sizeof...(Args)> {});
     }
@@ -161,22 +465,86 @@ struct class_function_wrapper<R (*)(Args...), func> {
     static int indexed_call_helper(lua_State* L, std::index_sequence<Indices...>) {
         int num_args = lua_gettop(L);
         if (num_args != sizeof...(Args) + 1) {
-            reportError(
-                "Invalid number of arguments, should be %zu, but %i were given.", sizeof...(Args), num_args - 1);
+            raiseError(L,
+                       "Invalid number of arguments, should be %d, but %d were given.",
+                       static_cast<int>(sizeof...(Args)),
+                       num_args - 1);
         }
         if constexpr (std::is_same_v<R, void>) {
-            (*func)(value_mirror<Args>::from_lua(L, Indices)...);
+            (*func)(argument_from_lua<Args, Args...>(L, Indices)...);
             return 0;
         } else {
-            return value_mirror<R>::to_lua(L, (*func)(value_mirror<Args>::from_lua(L, Indices)...));
+            return value_mirror<R>::to_lua(L, (*func)(argument_from_lua<Args, Args...>(L, Indices)...));
         }
     }
 };
 
+// Argument types of one constructor overload, e.g. constructor<signature<int>, signature<int, int>>("new").
+template <typename... Args>
+struct signature {};
+
+template <typename T>
+struct is_signature : std::false_type {};
+
+template <typename... Args>
+struct is_signature<signature<Args...>> : std::true_type {};
+
+template <template <typename, typename...> class Wrapper, typename Type, typename Signature>
+struct signature_wrapper;
+
+template <template <typename, typename...> class Wrapper, typename Type, typename... Args>
+struct signature_wrapper<Wrapper, Type, signature<Args...>> {
+    using type = Wrapper<Type, Args...>;
+};
+
+// Calls the first of Wrappers accepting the Lua arguments.
+// The number of arguments is compared with arities known at compile time; only the candidates
+// sharing an arity check argument types, with the cheap mirror_matches, in the order they were listed.
+// A candidate alone with its arity is called without checks and reports conversion errors itself.
+template <typename... Wrappers>
+struct overload_wrapper {
+    static_assert(sizeof...(Wrappers) > 1);
+
+    static int invoke(lua_State* L) {
+        const int num_args = lua_gettop(L);
+        int result = 0;
+        if (!(try_invoke<Wrappers>(L, num_args, result) || ...)) {
+            // all overloads of one name are either methods or free functions, skip self the same way
+            constexpr int implicit_args = std::get<0>(std::make_tuple(Wrappers::first_arg...)) - 1;
+            raiseError(L, "No overload accepts the given %d arguments.", num_args - implicit_args);
+        }
+        return result;
+    }
+
+private:
+    static constexpr int count_arity(int arity) {
+        return ((Wrappers::arity == arity ? 1 : 0) + ...);
+    }
+
+    template <typename Wrapper>
+    static bool try_invoke(lua_State* L, int num_args, int& result) {
+        if (num_args != Wrapper::arity) {
+            return false;
+        }
+        if constexpr (count_arity(Wrapper::arity) > 1) {
+            if (!Wrapper::matches(L)) {
+                return false;
+            }
+        }
+        result = Wrapper::invoke(L);
+        return true;
+    }
+};
+
 template <lua_CFunction func>
 struct lua_function : exception_safe_wrapper<lua_function<func>> {
     static int invoke(lua_State* L) {
-        return (*func)(L);
+        const int results = (*func)(L);
+        if (results == pending_results) [[unlikely]] {
+            // C++ frames of the call are gone, the coroutine can yield
+            return pending_result::await(L);
+        }
+        return results;
     }
 };
 
@@ -190,7 +558,7 @@ struct set {};
 template <typename R, typename T, R(T::*prop)>
 struct property_wrapper<get, R(T::*), prop> {
     static int invoke(lua_State* L) {
-        T* self = value_mirror<T*>::from_lua(L, 1);
+        T* self = argument_from_lua<T*>(L, 1);
         return value_mirror<R>::to_lua(L, self->*prop);
     }
 };
@@ -198,7 +566,7 @@ struct property_wrapper<get, R(T::*), prop> {
 template <typename R, typename T, R (T::*func)()>
 struct property_wrapper<get, R (T::*)(), func> {
     static int invoke(lua_State* L) {
-        T* self = value_mirror<T*>::from_lua(L, 1);
+        T* self = argument_from_lua<T*>(L, 1);
         return value_mirror<R>::to_lua(L, (self->*func)());
     }
 };
@@ -206,7 +574,7 @@ struct property_wrapper<get, R (T::*)(), func> {
 template <typename R, typename T, R (T::*func)() const>
 struct property_wrapper<get, R (T::*)() const, func> {
     static int invoke(lua_State* L) {
-        const T* self = value_mirror<T*>::from_lua(L, 1);
+        const T* self = argument_from_lua<T*>(L, 1);
         return value_mirror<R>::to_lua(L, (self->*func)());
     }
 };
@@ -214,8 +582,8 @@ struct property_wrapper<get, R (T::*)() const, func> {
 template <typename R, typename T, R(T::*prop)>
 struct property_wrapper<set, R(T::*), prop> {
     static int invoke(lua_State* L) {
-        T* self = value_mirror<T*>::from_lua(L, 1);
-        self->*prop = value_mirror<R>::from_lua(L, 3);
+        T* self = argument_from_lua<T*>(L, 1);
+        self->*prop = argument_from_lua<R>(L, 3);
         return 0;
     }
 };
@@ -223,12 +591,50 @@ struct property_wrapper<set, R(T::*), prop> {
 template <typename R, typename T, void (T::*func)(R)>
 struct property_wrapper<set, void (T::*)(R), func> {
     static int invoke(lua_State* L) {
-        T* self = value_mirror<T*>::from_lua(L, 1);
-        (self->*func)(value_mirror<R>::from_lua(L, 3));
+        T* self = argument_from_lua<T*>(L, 1);
+        (self->*func)(argument_from_lua<R>(L, 3));
         return 0;
     }
 };
 
+// Offset of a data member within its class, measured once on a dummy address which is never dereferenced,
+// as base_offset does for base classes.
+template <typename R, typename T>
+std::ptrdiff_t member_offset(R T::*prop) {
+    constexpr std::uintptr_t address = 0x10000;
+    auto* object = reinterpret_cast<T*>(address);
+    return static_cast<std::ptrdiff_t>(reinterpret_cast<std::uintptr_t>(&(object->*prop)) - address);
+}
+
+// Accessors of data member properties, one instantiation per class and member type.
+// The member itself is only known by its offset, stored in the member table.
+template <typename P>
+struct field_accessor;
+
+template <typename R, typename T>
+struct field_accessor<R(T::*)> {
+    static property_data field(R(T::*prop), bool writable) {
+        field_data f {&get, nullptr, member_offset(prop)};
+        if constexpr (!std::is_const_v<R>) {
+            if (writable) {
+                f.set = &set;
+            }
+        }
+        return property_data(f);
+    }
+
+    static int get(lua_State* L, std::ptrdiff_t offset) {
+        T* self = argument_from_lua<T*>(L, 1);
+        const auto* field = reinterpret_cast<const R*>(reinterpret_cast<const char*>(self) + offset);
+        return value_mirror<std::remove_const_t<R>>::to_lua(L, *field);
+    }
+
+    static void set(lua_State* L, std::ptrdiff_t offset) {
+        T* self = argument_from_lua<T*>(L, 1);
+        *reinterpret_cast<R*>(reinterpret_cast<char*>(self) + offset) = argument_from_lua<R>(L, 3);
+    }
+};
+
 } // namespace luabind
 
 #endif // LUABIND_WRAPPER_HPP
@@ -0,0 +1,127 @@
+#include "lua_test.hpp"
+
+#include <luabind/allocator.hpp>
+
+#include <cstring>
+#include <new>
+
+class Particle : public luabind::Object {
+public:
+    double x = 0;
+    double y = 0;
+};
+
+class PoolAllocatorTest : public LuaTest {
+protected:
+    PoolAllocatorTest() {
+        // LuaTest state is replaced by one using the pool
+        lua_close(L);
+        L = lua_newstate(&luabind::pool_allocator::alloc, &pool);
+        luaL_openlibs(L);
+    }
+
+    ~PoolAllocatorTest() override {
+        lua_close(L);
+        L = nullptr;
+        EXPECT_EQ(pool.get_stats().bytes_in_use, 0u);
+    }
+
+    luabind::pool_allocator pool;
+};
+
+TEST(PoolAllocator, Blocks) {
+    luabind::pool_allocator pool;
+    auto alloc = &luabind::pool_allocator::alloc;
+
+    void* a = alloc(&pool, nullptr, LUA_TTABLE, 24);
+    ASSERT_NE(a, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % 16, 0u);
+    std::memset(a, 7, 24);
+    // the same size class
+    EXPECT_EQ(alloc(&pool, a, 24, 30), a);
+
+    // grows into another class and keeps the content
+    void* b = alloc(&pool, a, 30, 100);
+    ASSERT_NE(b, nullptr);
+    EXPECT_EQ(static_cast<unsigned char*>(b)[23], 7);
+
+    // `a` was freed and is reused
+    const size_t hits = pool.get_stats().hits;
+    EXPECT_EQ(alloc(&pool, nullptr, 0, 32), a);
+    EXPECT_EQ(pool.get_stats().hits, hits + 1);
+
+    // large blocks
+    void* c = alloc(&pool, nullptr, 0, 4096);
+    ASSERT_NE(c, nullptr);
+    EXPECT_EQ(pool.get_stats().bytes_in_use, 32u + 112u + 4096u);
+    c = alloc(&pool, c, 4096, 16);
+    ASSERT_NE(c, nullptr);
+    EXPECT_EQ(pool.get_stats().bytes_in_use, 32u + 112u + 16u);
+
+    alloc(&pool, a, 32, 0);
+    alloc(&pool, b, 100, 0);
+    alloc(&pool, c, 16, 0);
+    EXPECT_EQ(pool.get_stats().bytes_in_use, 0u);
+    EXPECT_EQ(pool.get_stats().bytes_held, luabind::pool_allocator::slab_size);
+}
+
+// Makes the pool's slab allocations fail.
+static bool fail_nothrow_new = false;
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    if (fail_nothrow_new) {
+        return nullptr;
+    }
+    try {
+        return ::operator new(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+TEST(PoolAllocator, ShrinkWithoutSlab) {
+    luabind::pool_allocator pool;
+    auto alloc = &luabind::pool_allocator::alloc;
+
+    void* a = alloc(&pool, nullptr, 0, 4096);
+    ASSERT_NE(a, nullptr);
+    std::memset(a, 5, 4096);
+    fail_nothrow_new = true;
+    void* b = alloc(&pool, a, 4096, 100);
+    fail_nothrow_new = false;
+    ASSERT_NE(b, nullptr);
+    EXPECT_EQ(static_cast<unsigned char*>(b)[99], 5);
+    EXPECT_EQ(pool.get_stats().bytes_in_use, 112u);
+    EXPECT_EQ(pool.get_stats().bytes_held, 128u);
+
+    // the block is recycled in its new size class and freed with the pool
+    alloc(&pool, b, 100, 0);
+    EXPECT_EQ(alloc(&pool, nullptr, 0, 112), b);
+    alloc(&pool, b, 112, 0);
+    EXPECT_EQ(pool.get_stats().bytes_in_use, 0u);
+    EXPECT_EQ(pool.get_stats().bytes_held, 128u);
+}
+
+TEST_F(PoolAllocatorTest, ObjectChurn) {
+    luabind::class_<Particle>(L, "Particle").property<&Particle::x>("x").property<&Particle::y>("y");
+    // with the collector stopped every run has the same peak
+    constexpr const char* churn = R"(
+        collectgarbage('stop')
+        for i = 1, 10000 do
+            local p = Particle:new()
+            p.x = i
+            p.tag = 'custom'
+        end
+        collectgarbage()
+        collectgarbage('restart')
+    )";
+    ASSERT_EQ(run(churn), LUA_OK);
+    const luabind::pool_allocator::stats warm = pool.get_stats();
+    EXPECT_GT(warm.hits, 0u);
+
+    // freed blocks are reused, so a warm pool takes no new memory
+    ASSERT_EQ(run(churn), LUA_OK);
+    const luabind::pool_allocator::stats& again = pool.get_stats();
+    EXPECT_EQ(again.bytes_held, warm.bytes_held);
+    EXPECT_GT(again.hits, warm.hits + 10000);
+}
@@ -0,0 +1,72 @@
+#include "lua_test.hpp"
+
+#include <memory>
+#include <vector>
+
+class ArrayViewTest : public LuaTest {};
+
+std::vector<float> samples = {0.5f, 1.5f, 2.5f};
+const std::vector<int> constants = {1, 2, 3, 4};
+
+luabind::array_view<float> samplesView() {
+    return {samples.data(), samples.size()};
+}
+
+luabind::array_view<const int> constantsView() {
+    return {constants.data(), constants.size()};
+}
+
+luabind::array_view<double> ownedView(int n) {
+    auto buffer = std::make_shared<std::vector<double>>(static_cast<size_t>(n), 1.0);
+    return luabind::array_view<double>(buffer);
+}
+
+float total(luabind::array_view<const float> v) {
+    float r = 0;
+    for (size_t i = 0; i < v.size(); ++i) {
+        r += v[i];
+    }
+    return r;
+}
+
+TEST_F(ArrayViewTest, Indexing) {
+    luabind::function<&samplesView>(L, "samplesView");
+    EXPECT_EQ(runWithResult<int>("return #samplesView()"), 3);
+    EXPECT_EQ(runWithResult<float>("return samplesView()[2]"), 1.5f);
+    EXPECT_EQ(runWithResult<float>("local s = 0 for i = 1, #samplesView() do s = s + samplesView()[i] end return s"),
+              4.5f);
+}
+
+TEST_F(ArrayViewTest, WritesGoToTheBuffer) {
+    luabind::function<&samplesView>(L, "samplesView");
+    ASSERT_EQ(run("samplesView()[3] = 10"), LUA_OK);
+    EXPECT_EQ(samples[2], 10.0f);
+    samples[2] = 2.5f;
+    samples[0] = 7.0f;
+    EXPECT_EQ(runWithResult<float>("return samplesView()[1]"), 7.0f);
+    samples[0] = 0.5f;
+}
+
+TEST_F(ArrayViewTest, Arguments) {
+    luabind::function<&samplesView>(L, "samplesView");
+    luabind::function<&total>(L, "total");
+    EXPECT_EQ(runWithResult<float>("return total(samplesView())"), 4.5f);
+    runExpectingError("total({1, 2})", "Argument at 1 has invalid type. Expecting 'array_view', but got 'table'.");
+}
+
+TEST_F(ArrayViewTest, Owner) {
+    luabind::function<&ownedView>(L, "ownedView");
+    // the buffer is only referenced by the view
+    EXPECT_EQ(runWithResult<double>("local v = ownedView(5) collectgarbage() v[5] = 3 return v[1] + v[5]"), 4.0);
+}
+
+TEST_F(ArrayViewTest, Errors) {
+    luabind::function<&samplesView>(L, "samplesView");
+    luabind::function<&constantsView>(L, "constantsView");
+    EXPECT_EQ(runWithResult<int>("return constantsView()[4]"), 4);
+    runExpectingError("return samplesView()[0]", "Index 0 is out of bounds of array_view of size 3.");
+    runExpectingError("return samplesView()[4]", "Index 4 is out of bounds of array_view of size 3.");
+    runExpectingError("return samplesView().x", "Key type of array_view should be integer, 'string' is provided.");
+    runExpectingError("samplesView()[1] = 'a'", "Argument at 3 has invalid type. Expecting 'number', but got 'string'.");
+    runExpectingError("constantsView()[1] = 5", "array_view of const elements is read only.");
+}
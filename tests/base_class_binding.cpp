@@ -37,6 +37,10 @@ std::string_view usage(std::shared_ptr<Base> ptr) {
     return ptr->type();
 }
 
+long borrowedUseCount(const std::shared_ptr<Base>& ptr) {
+    return ptr.use_count();
+}
+
 std::shared_ptr<Base> create(std::string_view name) {
     if (name == "Derived1") {
         return std::make_shared<Derived1>();
@@ -58,6 +62,7 @@ protected:
             .function<&Derived3::childFunction>("childFunction");
         luabind::function<&create>(L, "create");
         luabind::function<&usage>(L, "usage");
+        luabind::function<&borrowedUseCount>(L, "borrowedUseCount");
 
         EXPECT_EQ(lua_gettop(L), 0);
     }
@@ -86,3 +91,94 @@ TEST_F(BaseClassBindingTest, BaseClassBindingTest) {
 
     EXPECT_EQ(r, LUA_OK);
 }
+
+TEST_F(BaseClassBindingTest, BorrowedSharedPtr) {
+    int r = run(R"--(
+        -- stored as shared_ptr<Base>, bound without a copy
+        d1 = create("Derived1")
+        assert(borrowedUseCount(d1) == 1)
+
+        -- stored as shared_ptr<Derived3>, bound to an aliasing copy
+        d3 = Derived3:makeShared()
+        assert(borrowedUseCount(d3) == 2)
+    )--");
+
+    EXPECT_EQ(r, LUA_OK);
+}
+
+class Level0 : public luabind::Object {
+public:
+    int value0 = 0;
+
+    int get0() const {
+        return value0;
+    }
+
+    int later0() const {
+        return -value0;
+    }
+};
+
+class Level1 : public Level0 {
+public:
+    int get1() const {
+        return 1;
+    }
+};
+
+class Level2 : public Level1 {};
+
+class Level3 : public Level2 {};
+
+class Level4 : public Level3 {
+public:
+    int get0() const {
+        return 4;
+    }
+};
+
+class DeepHierarchyTest : public LuaTest {
+protected:
+    void SetUp() override {
+        luabind::class_<Level0>(L, "Level0").function<&Level0::get0>("get0").property<&Level0::value0>("value0");
+        luabind::class_<Level1, Level0>(L, "Level1").function<&Level1::get1>("get1");
+        luabind::class_<Level2, Level1>(L, "Level2");
+        luabind::class_<Level3, Level2>(L, "Level3");
+        luabind::class_<Level4, Level3>(L, "Level4").function<&Level4::get0>("get0");
+
+        EXPECT_EQ(lua_gettop(L), 0);
+    }
+};
+
+TEST_F(DeepHierarchyTest, InheritedMembers) {
+    int r = run(R"--(
+        o = Level3:new()
+        o.value0 = 5
+        assert(o.value0 == 5)
+        assert(o:get0() == 5)
+        assert(o:get1() == 1)
+
+        shadowing = Level4:new()
+        assert(shadowing:get0() == 4)
+        assert(shadowing:get1() == 1)
+    )--");
+    EXPECT_EQ(r, LUA_OK);
+}
+
+TEST_F(DeepHierarchyTest, BaseMembersAddedAfterUse) {
+    int r = run(R"--(
+        o = Level3:new()
+        o.value0 = 7
+        assert(o:get0() == 7)
+        assert(o.later0 == nil)
+    )--");
+    ASSERT_EQ(r, LUA_OK);
+
+    luabind::class_<Level0>(L, "Level0").function<&Level0::later0>("later0");
+
+    r = run(R"--(
+        assert(o:later0() == -7)
+        assert(Level4:new():later0() == 0)
+    )--");
+    EXPECT_EQ(r, LUA_OK);
+}
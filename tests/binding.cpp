@@ -1,5 +1,6 @@
 #include "lua_test.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <string>
@@ -288,6 +289,86 @@ TEST_F(MultipleInheritance, PointerCorrection) {
     EXPECT_EQ(d.d, 4);
 }
 
+struct Named : luabind::Object {
+    std::string name = "named";
+};
+
+struct Counted {
+    virtual ~Counted() = default;
+    int count = 0;
+};
+
+struct Item
+    : Counted
+    , Named {
+    int weight = 0;
+};
+
+Item globalItem;
+
+Named* itemAsNamed() {
+    return &globalItem;
+}
+
+void validateItem(Item* item, Named* named, Counted* counted) {
+    EXPECT_EQ(named, static_cast<Named*>(item));
+    EXPECT_EQ(counted, static_cast<Counted*>(item));
+}
+
+std::string nameOf(const Named& named) {
+    return named.name;
+}
+
+class NonVirtualMultipleInheritance : public LuaTest {
+protected:
+    void SetUp() override {
+        luabind::class_<Named>(L, "Named").property<&Named::name>("name");
+        luabind::class_<Item, Named>(L, "Item").property<&Item::weight>("weight");
+
+        luabind::function<&itemAsNamed>(L, "itemAsNamed");
+        luabind::function<&validateItem>(L, "validateItem");
+        luabind::function<&nameOf>(L, "nameOf");
+    }
+};
+
+TEST_F(NonVirtualMultipleInheritance, OffsetBase) {
+    int r = run(R"--(
+        o = Item:new()
+        o.name = 'item'
+        o.weight = 2
+        assert(o.name == 'item')
+        assert(nameOf(o) == 'item')
+        validateItem(o, o, o)
+
+        g = itemAsNamed()
+        g.weight = 3
+        validateItem(g, g, g)
+    )--");
+    EXPECT_EQ(r, LUA_OK);
+    EXPECT_EQ(globalItem.weight, 3);
+}
+
+TEST_F(NonVirtualMultipleInheritance, ForeignUserData) {
+    auto* foreign = static_cast<char*>(lua_newuserdatauv(L, 64, 0));
+    std::fill(foreign, foreign + 64, 0);
+    lua_setglobal(L, "foreign");
+
+    runExpectingError("nameOf(foreign)",
+                      "Argument at 1 has invalid type. Expecting user_data of type 'Named', but got lua type 'userdata'");
+
+    // a copy of a luabind header, with the tag, in userdata of another library
+    ASSERT_EQ(run("named = Named:new()"), LUA_OK);
+    lua_getglobal(L, "named");
+    const size_t size = lua_rawlen(L, -1);
+    auto* copy = static_cast<char*>(lua_newuserdatauv(L, size, 0));
+    std::copy_n(static_cast<const char*>(lua_touserdata(L, -2)), size, copy);
+    lua_setglobal(L, "foreign");
+    lua_pop(L, 1);
+
+    runExpectingError("nameOf(foreign)",
+                      "Argument at 1 has invalid type. Expecting user_data of type 'Named', but got lua type 'userdata'");
+}
+
 struct Unbound : luabind::Object {
     int i = 0;
 };
@@ -456,3 +537,157 @@ TEST_F(ArrayTest, ArrayAccess) {
     )--");
     EXPECT_EQ(r, LUA_OK);
 }
+
+TEST_F(AccountLuaTest, LongMemberNames) {
+    luabind::class_<Account>(L, "Account")
+        .function<&Account::getBalance>("getBalanceThroughAVeryLongNameWhichLuaDoesNotIntern")
+        .property<&Account::balance>("balanceThroughAVeryLongNameWhichLuaDoesNotIntern");
+
+    int r = run(R"--(
+        a = Account:newWithInt(3)
+        assert(a:getBalanceThroughAVeryLongNameWhichLuaDoesNotIntern() == 3)
+        a.balanceThroughAVeryLongNameWhichLuaDoesNotIntern = 4
+        assert(a.balanceThroughAVeryLongNameWhichLuaDoesNotIntern == 4)
+        assert(a.balanceThroughAVeryLongNameWhichLuaDoesNotInternNeither == nil)
+        assert(a:getBalance() == 4)
+    )--");
+    EXPECT_EQ(r, LUA_OK);
+}
+
+class MethodTableTest : public LuaTest {
+protected:
+    void SetUp() override {
+        luabind::class_<Account>(L, "Account", luabind::class_options::method_table)
+            .constructor<int>("newWithInt")
+            .function<&Account::getBalance>("getBalance")
+            .function<&Account::setBalance>("setBalance")
+            .property<&Account::balance>("balance");
+
+        luabind::class_<SpecialAccount, Account>(L, "SpecialAccount", luabind::class_options::method_table)
+            .construct_shared<>("makeShared")
+            .property_readonly<&SpecialAccount::limit>("limit");
+
+        EXPECT_EQ(lua_gettop(L), 0);
+    }
+};
+
+TEST_F(MethodTableTest, MethodsPropertiesAndCustomFields) {
+    int r = run(R"--(
+        a = Account:newWithInt(5)
+        assert(a:getBalance() == 5)
+        a:setBalance(6)
+        assert(a.balance == 6)
+        a.balance = 7
+        assert(a:getBalance() == 7)
+        a.custom = 'custom'
+        assert(a.custom == 'custom')
+        assert(a.missing == nil)
+
+        sa = SpecialAccount:makeShared()
+        sa:setBalance(3)
+        assert(sa:getBalance() == 3)
+        assert(sa.limit == 10)
+    )--");
+    EXPECT_EQ(r, LUA_OK);
+}
+
+TEST_F(MethodTableTest, FilledByFirstLookup) {
+    int r = run(R"--(
+        local _, methods = debug.getupvalue(Account.__index, 1)
+        assert(next(methods) == nil)
+        a = Account:newWithInt(5)
+        assert(a.balance == 5)
+        assert(methods.getBalance ~= nil)
+        assert(methods.balance == nil)
+    )--");
+    EXPECT_EQ(r, LUA_OK);
+}
+
+TEST_F(MethodTableTest, MembersAddedLater) {
+    int r = run(R"--(
+        sa = SpecialAccount:makeShared()
+        assert(sa.setLimit == nil)
+        assert(sa.getBalanceAlias == nil)
+    )--");
+    ASSERT_EQ(r, LUA_OK);
+
+    luabind::class_<SpecialAccount, Account>(L, "SpecialAccount").function<&SpecialAccount::setLimit>("setLimit");
+    luabind::class_<Account>(L, "Account").function<&Account::getBalance>("getBalanceAlias");
+
+    r = run(R"--(
+        sa:setLimit(4)
+        assert(sa.limit == 4)
+        sa:setBalance(2)
+        assert(sa:getBalanceAlias() == 2)
+    )--");
+    EXPECT_EQ(r, LUA_OK);
+}
+
+TEST_F(MethodTableTest, MembersRebound) {
+    luabind::class_<Account>(L, "Account").function<&Account::getBalance>("f");
+    ASSERT_EQ(run("a = Account:newWithInt(5) sa = SpecialAccount:makeShared() assert(a:f() == 5)"), LUA_OK);
+
+    // the methods filled by the first lookup do not shadow members bound later under the same name
+    luabind::class_<Account>(L, "Account").function<&Account::bankName>("f");
+    luabind::class_<SpecialAccount, Account>(L, "SpecialAccount")
+        .property_readonly<&SpecialAccount::limit>("getBalance");
+    int r = run(R"--(
+        assert(a:f() == 'BelovedBank')
+        assert(sa.getBalance == 10)
+        assert(a:getBalance() == 5)
+    )--");
+    EXPECT_EQ(r, LUA_OK);
+}
+
+class SealedTest : public LuaTest {
+protected:
+    void SetUp() override {
+        luabind::class_<Account>(L, "Account", luabind::class_options::sealed)
+            .constructor<int>("newWithInt")
+            .function<&Account::getBalance>("getBalance")
+            .property<&Account::balance>("balance");
+
+        EXPECT_EQ(lua_gettop(L), 0);
+    }
+};
+
+TEST_F(SealedTest, NoCustomTable) {
+    int r = run(R"--(
+        a = Account:newWithInt(5)
+        a.balance = 6
+        assert(a:getBalance() == 6)
+        return a
+    )--");
+    ASSERT_EQ(r, LUA_OK);
+    EXPECT_EQ(lua_getiuservalue(L, -1, 1), LUA_TNONE);
+    lua_pop(L, 2);
+
+    runExpectingError(R"--(
+        a.custom = 1
+    )--",
+                      "Type 'Account' has no member named 'custom'.");
+    runExpectingError(R"--(
+        local c = a.custom
+    )--",
+                      "Type 'Account' has no member named 'custom'.");
+}
+
+TEST_F(AccountLuaTest, CustomTableCreatedOnFirstStore) {
+    int r = run(R"--(
+        a = Account:new()
+        assert(a.custom == nil)
+        return a
+    )--");
+    ASSERT_EQ(r, LUA_OK);
+    EXPECT_EQ(lua_getiuservalue(L, -1, 1), LUA_TNIL);
+    lua_pop(L, 2);
+
+    r = run(R"--(
+        a.custom = 1
+        assert(a.custom == 1)
+        return a
+    )--");
+    ASSERT_EQ(r, LUA_OK);
+    EXPECT_EQ(lua_getiuservalue(L, -1, 1), LUA_TTABLE);
+    lua_pop(L, 2);
+}
@@ -0,0 +1,201 @@
+#include "lua_test.hpp"
+
+#include <array>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Item : public luabind::Object {
+public:
+    explicit Item(int v)
+        : value(v) {}
+
+public:
+    int value = 0;
+};
+
+class ContainerTest : public LuaTest {
+protected:
+    ContainerTest() {
+        luabind::class_<Item>(L, "Item").construct_shared<int>("create").property<&Item::value>("value");
+    }
+};
+
+int sum(const std::vector<int>& v) {
+    return std::accumulate(v.begin(), v.end(), 0);
+}
+
+std::vector<std::string> words() {
+    return {"a", "b", "c"};
+}
+
+std::vector<std::vector<int>> grid() {
+    return {{1, 2}, {3, 4, 5}};
+}
+
+int gridSum(std::vector<std::vector<int>> g) {
+    int r = 0;
+    for (const auto& row : g) {
+        r += sum(row);
+    }
+    return r;
+}
+
+std::array<double, 3> scale(std::array<double, 3> v, double f) {
+    for (double& d : v) {
+        d *= f;
+    }
+    return v;
+}
+
+std::map<std::string, int> counts(const std::vector<std::string>& v) {
+    std::map<std::string, int> r;
+    for (const auto& s : v) {
+        ++r[s];
+    }
+    return r;
+}
+
+int countOf(const std::unordered_map<std::string, int>& m, const std::string& key) {
+    auto it = m.find(key);
+    return it == m.end() ? -1 : it->second;
+}
+
+std::set<int> unique(const std::vector<int>& v) {
+    return {v.begin(), v.end()};
+}
+
+size_t setSize(const std::set<std::string>& s) {
+    return s.size();
+}
+
+std::vector<std::shared_ptr<Item>> items(int n) {
+    std::vector<std::shared_ptr<Item>> r;
+    for (int i = 0; i < n; ++i) {
+        r.push_back(std::make_shared<Item>(i));
+    }
+    return r;
+}
+
+// converted by a mirror taking a stack index, which reports its own errors
+struct Percent {
+    int value = 0;
+};
+
+template <>
+struct luabind::value_mirror<Percent> {
+    static int to_lua(lua_State* L, Percent p) {
+        lua_pushinteger(L, p.value);
+        return 1;
+    }
+
+    static Percent from_lua(lua_State* L, int idx) {
+        if (!lua_isinteger(L, idx) || lua_tointeger(L, idx) < 0 || lua_tointeger(L, idx) > 100) {
+            throw luabind::error("Percent out of range.");
+        }
+        return {static_cast<int>(lua_tointeger(L, idx))};
+    }
+};
+
+int percentSum(const std::vector<Percent>& v) {
+    int r = 0;
+    for (const Percent& p : v) {
+        r += p.value;
+    }
+    return r;
+}
+
+int itemsSum(const std::vector<std::shared_ptr<Item>>& v) {
+    int r = 0;
+    for (const auto& i : v) {
+        r += i->value;
+    }
+    return r;
+}
+
+TEST_F(ContainerTest, Vector) {
+    luabind::function<&sum>(L, "sum");
+    luabind::function<&words>(L, "words");
+    EXPECT_EQ(runWithResult<int>("return sum({1, 2, 3, 4})"), 10);
+    EXPECT_EQ(runWithResult<int>("return sum({})"), 0);
+    EXPECT_EQ(runWithResult<std::string>("return table.concat(words(), ',')"), "a,b,c");
+    EXPECT_EQ(runWithResult<int>("return #words()"), 3);
+
+    // raw accesses, __index of the passed table is not consulted
+    EXPECT_EQ(runWithResult<int>("return sum(setmetatable({1}, {__index = function() return 5 end}))"), 1);
+
+    const std::vector<int> v = runWithResult<std::vector<int>>("return {5, 6, 7}");
+    EXPECT_EQ(v, (std::vector<int> {5, 6, 7}));
+}
+
+TEST_F(ContainerTest, Nested) {
+    luabind::function<&grid>(L, "grid");
+    luabind::function<&gridSum>(L, "gridSum");
+    EXPECT_EQ(runWithResult<int>("return grid()[2][3]"), 5);
+    EXPECT_EQ(runWithResult<int>("return gridSum(grid())"), 15);
+    EXPECT_EQ(runWithResult<int>("return gridSum({{1}, {}, {2, 3}})"), 6);
+}
+
+TEST_F(ContainerTest, Array) {
+    luabind::function<&scale>(L, "scale");
+    EXPECT_EQ(runWithResult<double>("local r = scale({1, 2, 3}, 2) return r[1] + r[2] + r[3]"), 12.0);
+    runExpectingError("scale({1, 2}, 2)", "Provided table at 1 for the array has invalid length.");
+}
+
+TEST_F(ContainerTest, Maps) {
+    luabind::function<&counts>(L, "counts");
+    luabind::function<&countOf>(L, "countOf");
+    EXPECT_EQ(runWithResult<int>("local c = counts({'x', 'y', 'x'}) return c.x * 10 + c.y"), 21);
+    EXPECT_EQ(runWithResult<int>("return countOf({a = 1, b = 2}, 'b')"), 2);
+    EXPECT_EQ(runWithResult<int>("return countOf({}, 'b')"), -1);
+
+    const auto m = runWithResult<std::map<int, std::string>>("return {[3] = 'c', [1] = 'a'}");
+    EXPECT_EQ(m, (std::map<int, std::string> {{1, "a"}, {3, "c"}}));
+}
+
+TEST_F(ContainerTest, Sets) {
+    luabind::function<&unique>(L, "unique");
+    luabind::function<&setSize>(L, "setSize");
+    EXPECT_EQ(runWithResult<bool>("local s = unique({1, 2, 2, 3}) return s[1] and s[2] and s[3] and not s[4]"), true);
+    EXPECT_EQ(runWithResult<size_t>("return setSize({a = true, b = true, c = false})"), 2u);
+}
+
+TEST_F(ContainerTest, Objects) {
+    luabind::function<&items>(L, "items");
+    luabind::function<&itemsSum>(L, "itemsSum");
+    EXPECT_EQ(runWithResult<int>("local v = items(4) return v[4].value"), 3);
+    EXPECT_EQ(runWithResult<int>("return itemsSum(items(5))"), 10);
+    EXPECT_EQ(runWithResult<int>("return itemsSum({Item:create(7), Item:create(8)})"), 15);
+}
+
+TEST_F(ContainerTest, Errors) {
+    luabind::function<&percentSum>(L, "percentSum");
+    EXPECT_EQ(runWithResult<int>("return percentSum({20, 30})"), 50);
+    luabind::function<&sum>(L, "sum");
+    luabind::function<&countOf>(L, "countOf");
+    runExpectingError("sum(1)", "Provided argument at 1 for the vector is not a table.");
+    runExpectingError("sum({1, 'x'})",
+                      "Element 2 of argument 1 has invalid type. Expecting 'integer', but got 'string'.");
+    runExpectingError("countOf(nil, 'a')", "Provided argument at 1 for the map is not a table.");
+    runExpectingError("countOf({a = 1, b = true}, 'a')",
+                      "Element 'b' of argument 1 has invalid type. Expecting 'integer', but got 'boolean'.");
+    runExpectingError("countOf({[1] = 1}, 'a')",
+                      "Key 1 of argument 1 has invalid type. Expecting 'string', but got 'number'.");
+    luabind::function<&gridSum>(L, "gridSum");
+    runExpectingError("gridSum({{1}, {2, 2.5}})",
+                      "Element 2 of element 2 of argument 1 has invalid type. Expecting 'integer', but got 'number'.");
+    runExpectingError("gridSum({{1}, 2})", "Element 2 of argument 1 for the vector is not a table.");
+    runExpectingError("countOf({[2.5] = 1}, 'a')",
+                      "Key 2.5 of argument 1 has invalid type. Expecting 'string', but got 'number'.");
+    // arrays of numbers hold nothing to destroy, their element errors are raised without a C++ exception
+    luabind::function<&scale>(L, "scale");
+    runExpectingError("scale({1, 'x', 3}, 2)",
+                      "Element 2 of argument 1 has invalid type. Expecting 'number', but got 'string'.");
+    runExpectingError("scale({1, 2, 3}, 'x')",
+                      "Argument at 2 has invalid type. Expecting 'number', but got 'string'.");
+    runExpectingError("percentSum({20, 300})", "Element 2 of argument 1 is invalid: Percent out of range.");
+}
@@ -0,0 +1,164 @@
+#include "lua_test.hpp"
+
+#include <luabind/descriptor.hpp>
+
+#include <string_view>
+
+class Account : public luabind::Object {
+public:
+    Account() = default;
+
+    explicit Account(int b)
+        : balance(b) {}
+
+    void credit(int amount) {
+        balance += amount;
+    }
+
+    void debit(int amount) {
+        balance -= amount;
+    }
+
+    int getLimit() const {
+        return limit;
+    }
+
+    void setLimit(int l) {
+        limit = l;
+    }
+
+    int at(int idx) const {
+        return idx * balance;
+    }
+
+    static int bankCode() {
+        return 7;
+    }
+
+public:
+    int balance = 0;
+    int limit = 100;
+};
+
+class SavingsAccount : public Account {
+public:
+    explicit SavingsAccount(int b)
+        : Account(b) {}
+
+    int interest() const {
+        return balance / 10;
+    }
+};
+
+struct Point final {
+    int x;
+    int y;
+};
+
+using AccountDescriptor = luabind::descriptor<Account>;
+static constexpr auto account_class =
+    AccountDescriptor::make("Account",
+                            {
+                                AccountDescriptor::constructor<int>("create"),
+                                AccountDescriptor::function<&Account::debit>("debit"),
+                                AccountDescriptor::function<&Account::credit>("credit"),
+                                AccountDescriptor::property<&Account::balance>("balance"),
+                                AccountDescriptor::property<&Account::getLimit, &Account::setLimit>("limit"),
+                                AccountDescriptor::class_function<&Account::bankCode>("bankCode"),
+                                AccountDescriptor::array_access<&Account::at>(),
+                            });
+
+using SavingsDescriptor = luabind::descriptor<SavingsAccount, Account>;
+static constexpr auto savings_class =
+    SavingsDescriptor::make("SavingsAccount",
+                            luabind::class_options::method_table,
+                            {
+                                SavingsDescriptor::constructor<int>("new"),
+                                SavingsDescriptor::function<&SavingsAccount::interest>("interest"),
+                            });
+
+using PointDescriptor = luabind::descriptor<Point>;
+static constexpr auto point_class = PointDescriptor::make("Point",
+                                                          {
+                                                              PointDescriptor::property<&Point::x>("x"),
+                                                              PointDescriptor::property<&Point::y>("y"),
+                                                          });
+
+// members and metatable functions are sorted by name at compile time
+constexpr bool isSorted(std::string_view a, std::string_view b) {
+    return a < b;
+}
+
+static_assert(account_class.member_count == 5);
+static_assert(isSorted(account_class.members[0].name, account_class.members[1].name));
+static_assert(std::string_view {account_class.members[0].name} == "balance");
+static_assert(std::string_view {account_class.members[4].name} == "limit");
+static_assert(std::string_view {account_class.metatable_functions[0].name} == "__gc");
+static_assert(account_class.metatable_functions[6].name == nullptr);
+// the default "new" is replaced by the described constructor
+static_assert(savings_class.metatable_functions[4].name == nullptr);
+static_assert(point_class.member_count == 2);
+static_assert(luabind::has_option(point_class.options, luabind::class_options::sealed));
+
+class DescriptorTest : public LuaTest {
+protected:
+    DescriptorTest() {
+        luabind::bind<account_class>(L);
+        luabind::bind<savings_class>(L);
+        luabind::bind<point_class>(L);
+    }
+};
+
+TEST_F(DescriptorTest, MethodsAndProperties) {
+    EXPECT_EQ(runWithResult<int>(R"--(
+        local a = Account:create(10)
+        a:credit(5)
+        a:debit(3)
+        return a.balance
+    )--"),
+              12);
+    EXPECT_EQ(runWithResult<int>("local a = Account:new() a.limit = 7 return a.limit"), 7);
+    EXPECT_EQ(runWithResult<int>("local a = Account:create(3) return a[2]"), 6);
+    EXPECT_EQ(runWithResult<int>("return Account:bankCode()"), 7);
+}
+
+TEST_F(DescriptorTest, CustomTableAndDelete) {
+    EXPECT_EQ(runWithResult<int>("local a = Account:new() a.note = 4 return a.note"), 4);
+    EXPECT_EQ(run("local a = Account:new() a:delete()"), LUA_OK);
+}
+
+TEST_F(DescriptorTest, Inheritance) {
+    EXPECT_EQ(runWithResult<int>(R"--(
+        local s = SavingsAccount:new(50)
+        s:credit(50)
+        return s:interest() + s.balance
+    )--"),
+              110);
+    EXPECT_EQ(runWithResult<int>("local s = SavingsAccount:new(1) return s.limit"), 100);
+}
+
+TEST_F(DescriptorTest, ValueType) {
+    EXPECT_EQ(runWithResult<int>("local p = Point:new() p.x = 3 p.y = 4 return p.x * p.y"), 12);
+    runExpectingError("local p = Point:new() p.z = 1", "Type 'Point' has no member named 'z'.");
+}
+
+TEST_F(DescriptorTest, MembersBoundByNameShadowDescribedOnes) {
+    luabind::class_<Account>(L, "Account").function<&Account::credit>("debit");
+    EXPECT_EQ(runWithResult<int>("local a = Account:create(10) a:debit(5) return a.balance"), 15);
+    EXPECT_EQ(runWithResult<int>("local a = Account:create(10) a:credit(5) return a.balance"), 15);
+}
+
+TEST_F(DescriptorTest, BoundOnce) {
+    EXPECT_THROW(luabind::bind<account_class>(L), luabind::error);
+}
+
+TEST_F(DescriptorTest, Schema) {
+    std::shared_ptr<const luabind::schema> schema = luabind::schema::capture(L);
+    lua_State* other = luaL_newstate();
+    luabind::schema::attach(other, schema);
+    const char* script = "local s = SavingsAccount:new(20) s:credit(1) return s:interest(), Account:bankCode()";
+    EXPECT_EQ(luaL_dostring(other, script), LUA_OK);
+    EXPECT_EQ(lua_tointeger(other, -2), 2);
+    EXPECT_EQ(lua_tointeger(other, -1), 7);
+    lua_close(other);
+}
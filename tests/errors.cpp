@@ -48,6 +48,8 @@ public:
     void floating(float) {}
 };
 
+class LongNamed : public luabind::Object {};
+
 Numeric toNumeric(const String&) {
     return Numeric {};
 }
@@ -236,3 +238,31 @@ TEST_F(StrLuaTest, WrapperErrors) {
     )--",
         "Invalid number of arguments, should be 1, but 2 were given.");
 }
+
+TEST_F(StrLuaTest, LongMessages) {
+    const std::string name(300, 'L');
+    luabind::class_<LongNamed>(L, name).constructor<>("new");
+    lua_getglobal(L, name.c_str());
+    lua_setglobal(L, "LongNamed");
+
+    runExpectingError(
+        R"--(
+        s = String:new('abc')
+        s:copy(LongNamed:new())
+    )--",
+        "Argument at 2 has invalid type. Expecting 'String' but got '" + name + "'.");
+}
+
+TEST_F(StrLuaTest, HostConversionErrors) {
+    lua_pushliteral(L, "abc");
+    try {
+        luabind::value_mirror<int>::from_lua(L, 1);
+        FAIL() << "expected luabind::error";
+    } catch (const luabind::error& e) {
+        EXPECT_STREQ(e.what(), "Argument at 1 has invalid type. Expecting 'integer', but got 'string'.");
+    }
+    // only the converted value is left on the stack
+    EXPECT_EQ(lua_gettop(L), 1);
+    EXPECT_STREQ(lua_tostring(L, 1), "abc");
+    lua_pop(L, 1);
+}
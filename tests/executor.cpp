@@ -0,0 +1,139 @@
+#include "lua_test.hpp"
+
+#include <luabind/executor.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+class Counter : public luabind::Object {
+public:
+    int next() {
+        return ++value;
+    }
+
+public:
+    int value = 0;
+};
+
+void initState(lua_State* L) {
+    luaL_openlibs(L);
+    luabind::class_<Counter>(L, "Counter").function<&Counter::next>("next");
+    luaL_dostring(L, "counter = Counter:new()");
+}
+
+// the state owned by the fixture is not used, every worker creates its own
+class ExecutorTest : public LuaTest {};
+
+TEST_F(ExecutorTest, RunsEveryJob) {
+    std::atomic<lua_Integer> sum {0};
+    {
+        luabind::executor executor(4, &initState);
+        for (int i = 0; i < 1000; ++i) {
+            executor.submit([&sum](lua_State* L) { sum += runWithResult<lua_Integer>(L, "return 1 + 1"); });
+        }
+        executor.wait_idle();
+        EXPECT_EQ(sum, 2000);
+        EXPECT_EQ(executor.get_stats().executed, 1000u);
+        EXPECT_EQ(executor.get_stats().failed, 0u);
+    }
+}
+
+TEST_F(ExecutorTest, InitializesEveryStateOnItsThread) {
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    luabind::executor executor(3, [&](lua_State* L) {
+        initState(L);
+        std::lock_guard lock(mutex);
+        threads.insert(std::this_thread::get_id());
+    });
+    EXPECT_EQ(threads.size(), 3u);
+    EXPECT_EQ(threads.count(std::this_thread::get_id()), 0u);
+
+    std::atomic<int> bound {0};
+    for (size_t i = 0; i < executor.size(); ++i) {
+        executor.submit_to(i, [&](lua_State* L) {
+            bound += lua_getglobal(L, "Counter") == LUA_TTABLE ? 1 : 0;
+        });
+    }
+    executor.wait_idle();
+    EXPECT_EQ(bound, 3);
+}
+
+TEST_F(ExecutorTest, PinnedJobsShareTheirState) {
+    luabind::executor executor(4, &initState);
+    lua_Integer last = 0;
+    std::thread::id first_thread;
+    std::atomic<bool> same_thread {true};
+    for (int i = 0; i < 100; ++i) {
+        executor.submit_to(2, [&, i](lua_State* L) {
+            if (i == 0) {
+                first_thread = std::this_thread::get_id();
+            } else if (first_thread != std::this_thread::get_id()) {
+                same_thread = false;
+            }
+            last = runWithResult<lua_Integer>(L, "return counter:next()");
+        });
+    }
+    executor.wait_idle();
+    EXPECT_EQ(last, 100);
+    EXPECT_TRUE(same_thread);
+    EXPECT_EQ(executor.get_stats().stolen, 0u);
+}
+
+TEST_F(ExecutorTest, IdleWorkersSteal) {
+    luabind::executor executor(4, &initState);
+    // every job is queued to the first worker, which is kept busy by a pinned job meanwhile
+    std::atomic<bool> release {false};
+    executor.submit_to(0, [&](lua_State*) {
+        while (!release) {
+            std::this_thread::yield();
+        }
+    });
+    std::atomic<int> done {0};
+    for (int i = 0; i < 4 * 64; ++i) {
+        executor.submit([&](lua_State*) { ++done; });
+    }
+    while (done < 4 * 64) {
+        std::this_thread::yield();
+    }
+    release = true;
+    executor.wait_idle();
+    EXPECT_GT(executor.get_stats().stolen, 0u);
+}
+
+TEST_F(ExecutorTest, FailedJobs) {
+    luabind::executor executor(2, &initState);
+    executor.submit([](lua_State*) { throw std::runtime_error("job failed"); });
+    executor.submit([](lua_State* L) {
+        if (luaL_dostring(L, "error('script failed')") != LUA_OK) {
+            throw luabind::error(lua_tostring(L, -1));
+        }
+    });
+    executor.submit([](lua_State* L) { runWithResult<lua_Integer>(L, "return 1"); });
+    executor.wait_idle();
+    const luabind::executor::stats stats = executor.get_stats();
+    EXPECT_EQ(stats.executed, 3u);
+    EXPECT_EQ(stats.failed, 2u);
+}
+
+TEST_F(ExecutorTest, InitializerError) {
+    EXPECT_THROW(luabind::executor(2, [](lua_State*) { throw std::runtime_error("init failed"); }),
+                 std::runtime_error);
+    EXPECT_THROW(luabind::executor(0, &initState), std::invalid_argument);
+}
+
+TEST_F(ExecutorTest, SubmitToFullQueue) {
+    std::atomic<int> done {0};
+    {
+        luabind::executor executor(2, &initState, 4);
+        for (int i = 0; i < 200; ++i) {
+            executor.submit_to(1, [&](lua_State*) { ++done; });
+            executor.submit([&](lua_State*) { ++done; });
+        }
+        // the destructor runs the remaining jobs
+    }
+    EXPECT_EQ(done, 400);
+}
@@ -43,3 +43,12 @@ TEST_F(ExplicitDeleteTest, ExplicitDelete) {
 
     EXPECT_EQ(Deletable::deletedCount, 2);
 }
+
+TEST_F(ExplicitDeleteTest, InvalidSelf) {
+    const int deleted = Deletable::deletedCount;
+    run("obj = Deletable:new()");
+    runExpectingError("getmetatable(obj).__gc({})", "Expecting user_data to delete, but got lua type 'table'.");
+    runExpectingError("obj.delete(1)", "Expecting user_data to delete, but got lua type 'number'.");
+    run("obj:delete({}) obj = nil collectgarbage()");
+    EXPECT_EQ(Deletable::deletedCount, deleted + 1);
+}
@@ -0,0 +1,84 @@
+#include "lua_test.hpp"
+
+#include <string>
+
+struct Color final {
+    float r;
+    float g;
+};
+
+class Base : public luabind::Object {
+public:
+    int id = 1;
+};
+
+struct Padding {
+    double weight = 0.5;
+};
+
+// Base is not at the start of Item
+class Item
+    : public Padding
+    , public Base {
+public:
+    Item() = default;
+
+    explicit Item(int c)
+        : count(c) {}
+
+public:
+    int count = 0;
+    const int limit = 10;
+    std::string name = "item";
+    bool enabled = true;
+    Color color {1, 0};
+};
+
+class FieldTest : public LuaTest {
+protected:
+    FieldTest() {
+        luabind::class_<Color>(L, "Color").property<&Color::r>("r").property<&Color::g>("g");
+        luabind::class_<Base>(L, "Base").property<&Base::id>("id");
+        luabind::class_<Item, Base>(L, "Item")
+            .constructor<int>("create")
+            .property<&Item::count>("count")
+            .property<&Item::limit>("limit")
+            .property_readonly<&Item::name>("name")
+            .property<&Item::enabled>("enabled")
+            .property<&Item::color>("color")
+            .property<&Item::weight>("weight");
+    }
+};
+
+TEST_F(FieldTest, GetAndSet) {
+    EXPECT_EQ(runWithResult<int>("local i = Item:create(3) i.count = i.count + 1 return i.count"), 4);
+    EXPECT_EQ(runWithResult<std::string>("return Item:new().name"), "item");
+    EXPECT_EQ(runWithResult<bool>("local i = Item:new() i.enabled = false return i.enabled"), false);
+    EXPECT_EQ(runWithResult<float>("local i = Item:new() return i.color.r"), 1.0f);
+}
+
+TEST_F(FieldTest, MembersOfBasesAtAnOffset) {
+    EXPECT_EQ(runWithResult<int>("local i = Item:new() i.id = 5 return i.id"), 5);
+    EXPECT_EQ(runWithResult<double>("local i = Item:new() i.weight = 2.5 return i.weight + i.id"), 3.5);
+}
+
+TEST_F(FieldTest, ObjectsFromCpp) {
+    Item item(7);
+    luabind::value_mirror<Item*>::to_lua(L, &item);
+    lua_setglobal(L, "item");
+    EXPECT_EQ(run("item.count = item.count * 2 item.weight = 4"), LUA_OK);
+    EXPECT_EQ(item.count, 14);
+    EXPECT_EQ(item.weight, 4);
+}
+
+TEST_F(FieldTest, ReadOnly) {
+    EXPECT_EQ(runWithResult<int>("return Item:new().limit"), 10);
+    runExpectingError("Item:new().limit = 1", "Property 'limit' is read only.");
+    runExpectingError("Item:new().name = 'x'", "Property 'name' is read only.");
+}
+
+TEST_F(FieldTest, InvalidValues) {
+    runExpectingError("Item:new().count = 'x'", "Argument at 3 has invalid type. Expecting 'integer', but got 'string'.");
+    runExpectingError("Item:new().color = 1",
+                      "Argument at 3 has invalid type. Expecting value of type 'Color', but got lua type 'number'");
+}
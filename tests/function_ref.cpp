@@ -0,0 +1,169 @@
+#include "lua_test.hpp"
+
+#include <luabind/function_ref.hpp>
+
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+class Counter : public luabind::Object {
+public:
+    void onChange(luabind::function_ref<void(int)> callback) {
+        _callback = std::move(callback);
+    }
+
+    void add(int v) {
+        _value += v;
+        if (_callback) {
+            _callback(_value);
+        }
+    }
+
+private:
+    int _value = 0;
+    luabind::function_ref<void(int)> _callback;
+};
+
+class FunctionRefTest : public LuaTest {
+protected:
+    FunctionRefTest() {
+        luabind::class_<Counter>(L, "Counter")
+            .function<&Counter::onChange>("onChange")
+            .function<&Counter::add>("add");
+    }
+};
+
+TEST_F(FunctionRefTest, CallGlobal) {
+    ASSERT_EQ(run("function add(a, b) return a + b end"), LUA_OK);
+    luabind::function_ref<int(int, int)> add(L, "add");
+    EXPECT_EQ(add(2, 3), 5);
+    EXPECT_EQ(add(4, 5), 9);
+    EXPECT_EQ(lua_gettop(L), 0);
+}
+
+TEST_F(FunctionRefTest, KeepsFunctionWhenGlobalChanges) {
+    ASSERT_EQ(run("function greet(name) return 'hi ' .. name end"), LUA_OK);
+    luabind::function_ref<std::string(const std::string&)> greet(L, "greet");
+    ASSERT_EQ(run("greet = nil collectgarbage()"), LUA_OK);
+    EXPECT_EQ(greet("lua"), "hi lua");
+}
+
+TEST_F(FunctionRefTest, SeveralResults) {
+    ASSERT_EQ(run("function divmod(a, b) return a // b, a % b end"), LUA_OK);
+    luabind::function_ref<std::tuple<int, int>(int, int)> divmod(L, "divmod");
+    EXPECT_EQ(divmod(7, 2), std::make_tuple(3, 1));
+    EXPECT_EQ(lua_gettop(L), 0);
+}
+
+TEST_F(FunctionRefTest, Errors) {
+    ASSERT_EQ(run("function fail(msg) error(msg, 0) end function fail_table() error({}) end"), LUA_OK);
+    luabind::function_ref<void(std::string_view)> fail(L, "fail");
+    EXPECT_THROW(
+        {
+            try {
+                fail("broken");
+            } catch (const luabind::error& e) {
+                EXPECT_STREQ(e.what(), "broken");
+                throw;
+            }
+        },
+        luabind::error);
+    luabind::function_ref<void()> failTable(L, "fail_table");
+    try {
+        failTable();
+        FAIL();
+    } catch (const luabind::error& e) {
+        EXPECT_STREQ(e.what(), "(error object is a table value)");
+    }
+    EXPECT_EQ(lua_gettop(L), 0);
+}
+
+TEST_F(FunctionRefTest, InvalidResult) {
+    ASSERT_EQ(run("function name() return 1, {} end"), LUA_OK);
+    luabind::function_ref<std::tuple<int, std::string>()> name(L, "name");
+    try {
+        name();
+        FAIL();
+    } catch (const luabind::error& e) {
+        EXPECT_STREQ(e.what(), "Result 2 of the Lua function has invalid type 'table'.");
+    }
+    EXPECT_EQ(lua_gettop(L), 0);
+}
+
+TEST_F(FunctionRefTest, InvalidResultElement) {
+    ASSERT_EQ(run("function values() return {1, 'x'} end function grid() return 0, {{1}, {2, {}}} end"), LUA_OK);
+    luabind::function_ref<std::vector<int>()> values(L, "values");
+    try {
+        values();
+        FAIL();
+    } catch (const luabind::error& e) {
+        EXPECT_STREQ(e.what(),
+                     "Element 2 of result 1 of the Lua function has invalid type. "
+                     "Expecting 'integer', but got 'string'.");
+    }
+    EXPECT_EQ(lua_gettop(L), 0);
+
+    luabind::function_ref<std::tuple<int, std::vector<std::vector<int>>>()> grid(L, "grid");
+    try {
+        grid();
+        FAIL();
+    } catch (const luabind::error& e) {
+        EXPECT_STREQ(e.what(),
+                     "Element 2 of element 2 of result 2 of the Lua function has invalid type. "
+                     "Expecting 'integer', but got 'table'.");
+    }
+    EXPECT_EQ(lua_gettop(L), 0);
+}
+
+TEST_F(FunctionRefTest, NotAFunction) {
+    ASSERT_EQ(run("value = 1"), LUA_OK);
+    try {
+        luabind::function_ref<void()> f(L, "value");
+        FAIL();
+    } catch (const luabind::error& e) {
+        EXPECT_STREQ(e.what(), "Global 'value' is not a function, but 'number'.");
+    }
+    luabind::function_ref<void()> empty;
+    EXPECT_FALSE(empty);
+    EXPECT_THROW(empty(), luabind::error);
+}
+
+TEST_F(FunctionRefTest, CallbackArgument) {
+    EXPECT_EQ(runWithResult<int>(R"--(
+        local c = Counter:new()
+        local seen = 0
+        c:onChange(function(v) seen = v end)
+        c:add(2)
+        c:add(3)
+        return seen
+    )--"),
+              5);
+    runExpectingError("Counter:new():onChange(1)",
+                      "Argument at 2 has invalid type. Expecting 'function', but got 'number'.");
+}
+
+TEST_F(FunctionRefTest, CopyAndPush) {
+    ASSERT_EQ(run("function twice(x) return x * 2 end"), LUA_OK);
+    luabind::function_ref<int(int)> twice(L, "twice");
+    auto copy = twice;
+    twice.reset();
+    EXPECT_EQ(copy(4), 8);
+    luabind::value_mirror<luabind::function_ref<int(int)>>::to_lua(L, copy);
+    lua_setglobal(L, "again");
+    EXPECT_EQ(runWithResult<int>("return again(5)"), 10);
+}
+
+TEST_F(FunctionRefTest, CallFromCoroutine) {
+    ASSERT_EQ(run("function inc(x) return x + 1 end"), LUA_OK);
+    static luabind::function_ref<int(int)> inc;
+    inc = luabind::function_ref<int(int)>(L, "inc");
+    lua_register(L, "incFromCpp", [](lua_State* T) -> int {
+        lua_pushinteger(T, inc.call(T, static_cast<int>(lua_tointeger(T, 1))));
+        return 1;
+    });
+    EXPECT_EQ(runWithResult<int>(
+                  "local co = coroutine.wrap(function() return incFromCpp(coroutine.yield(1)) end) co() return co(41)"),
+              42);
+    inc.reset();
+}
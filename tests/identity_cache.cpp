@@ -0,0 +1,131 @@
+#include "lua_test.hpp"
+
+#include <memory>
+#include <new>
+
+class Node : public luabind::Object {
+public:
+    int value = 0;
+
+    Node* self() {
+        return this;
+    }
+};
+
+class Tree : public luabind::Object {
+public:
+    Node root;
+    std::shared_ptr<Node> shared = std::make_shared<Node>();
+
+    Node* getRoot() {
+        return &root;
+    }
+
+    std::shared_ptr<Node> getShared() {
+        return shared;
+    }
+};
+
+class IdentityCacheTest : public LuaTest {
+protected:
+    void SetUp() override {
+        luabind::identity_cache::enable(L);
+        luabind::class_<Node>(L, "Node")
+            .constructor<>("new")
+            .property<&Node::value>("value")
+            .function<&Node::self>("self");
+        luabind::class_<Tree>(L, "Tree")
+            .constructor<>("new")
+            .function<&Tree::getRoot>("getRoot")
+            .function<&Tree::getShared>("getShared");
+
+        EXPECT_EQ(lua_gettop(L), 0);
+    }
+};
+
+TEST_F(IdentityCacheTest, SameObjectSameUserData) {
+    int r = run(R"--(
+        t = Tree:new()
+        r = t:getRoot()
+        assert(r == t:getRoot())
+        r.custom = 'kept'
+        assert(t:getRoot().custom == 'kept')
+
+        s = t:getShared()
+        assert(s == t:getShared())
+
+        n = Node:new()
+        assert(n:self() == n)
+    )--");
+    EXPECT_EQ(r, LUA_OK);
+}
+
+TEST_F(IdentityCacheTest, NoAllocationOnRepeatedPush) {
+    int r = run(R"--(
+        t = Tree:new()
+        r = t:getRoot()
+        collectgarbage()
+        collectgarbage('stop')
+        local before = collectgarbage('count')
+        for i = 1, 1000 do
+            t:getRoot()
+        end
+        assert(collectgarbage('count') == before)
+        collectgarbage('restart')
+    )--");
+    EXPECT_EQ(r, LUA_OK);
+}
+
+TEST_F(IdentityCacheTest, DeletedAndCollected) {
+    int r = run(R"--(
+        t = Tree:new()
+        r = t:getRoot()
+        r:delete()
+        again = t:getRoot()
+        assert(again ~= r)
+        again.value = 3
+        assert(again.value == 3)
+
+        again = nil
+        r = nil
+        collectgarbage()
+        collectgarbage()
+        assert(t:getRoot().value == 3)
+    )--");
+    EXPECT_EQ(r, LUA_OK);
+}
+
+TEST_F(IdentityCacheTest, RawPointerDoesNotShadowSharedPtr) {
+    int r = run(R"--(
+        t = Tree:new()
+        s = t:getShared()
+        assert(s:self() == s)
+    )--");
+    EXPECT_EQ(r, LUA_OK);
+
+    Tree tree;
+    luabind::value_mirror<Node*>::to_lua(L, tree.shared.get());
+    luabind::value_mirror<std::shared_ptr<Node>>::to_lua(L, tree.shared);
+    EXPECT_FALSE(lua_rawequal(L, -1, -2));
+    // the shared_ptr one replaces the raw pointer in the cache
+    luabind::value_mirror<Node*>::to_lua(L, tree.shared.get());
+    EXPECT_TRUE(lua_rawequal(L, -1, -2));
+    lua_settop(L, 0);
+}
+
+TEST_F(IdentityCacheTest, TypesSharingAnAddress) {
+    // a Tree built in the memory of a Node still referenced from Lua does not replace its userdata
+    alignas(Tree) unsigned char memory[sizeof(Tree) > sizeof(Node) ? sizeof(Tree) : sizeof(Node)];
+    Node* node = new (memory) Node;
+    luabind::value_mirror<Node*>::to_lua(L, node);
+    node->~Node();
+    Tree* tree = new (memory) Tree;
+    luabind::value_mirror<Tree*>::to_lua(L, tree);
+    EXPECT_FALSE(lua_rawequal(L, -1, -2));
+    tree->~Tree();
+    node = new (memory) Node;
+    luabind::value_mirror<Node*>::to_lua(L, node);
+    EXPECT_TRUE(lua_rawequal(L, -1, -3));
+    node->~Node();
+    lua_settop(L, 0);
+}
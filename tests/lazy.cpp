@@ -0,0 +1,138 @@
+#include "lua_test.hpp"
+
+#include <luabind/lazy.hpp>
+#include <luabind/state_pool.hpp>
+
+#include <memory>
+#include <stdexcept>
+
+class Vehicle : public luabind::Object {
+public:
+    int wheels() const {
+        return 4;
+    }
+
+    static inline int bound = 0;
+};
+
+class Truck : public Vehicle {
+public:
+    int load() const {
+        return 10;
+    }
+
+    static inline int bound = 0;
+};
+
+class Boat : public luabind::Object {
+public:
+    int speed = 20;
+};
+
+class Unbound : public luabind::Object {};
+
+void bindVehicle(lua_State* L) {
+    ++Vehicle::bound;
+    luabind::class_<Vehicle>(L, "Vehicle").function<&Vehicle::wheels>("wheels");
+}
+
+void bindTruck(lua_State* L) {
+    ++Truck::bound;
+    luabind::class_<Truck, Vehicle>(L, "Truck").function<&Truck::load>("load");
+}
+
+using BoatDescriptor = luabind::descriptor<Boat>;
+static constexpr auto boat_class = BoatDescriptor::make("Boat", {BoatDescriptor::property<&Boat::speed>("speed")});
+
+class LazyTest : public LuaTest {
+protected:
+    LazyTest() {
+        Vehicle::bound = 0;
+        Truck::bound = 0;
+        luabind::lazy_class<Vehicle>(L, "Vehicle", &bindVehicle);
+        luabind::lazy_class<Truck>(L, "Truck", &bindTruck);
+    }
+};
+
+TEST_F(LazyTest, BoundOnFirstAccess) {
+    EXPECT_EQ(Vehicle::bound, 0);
+    EXPECT_EQ(runWithResult<int>("return Vehicle:new():wheels()"), 4);
+    EXPECT_EQ(runWithResult<int>("return Vehicle:new():wheels()"), 4);
+    EXPECT_EQ(Vehicle::bound, 1);
+    EXPECT_EQ(Truck::bound, 0);
+}
+
+TEST_F(LazyTest, BaseBoundWithDerived) {
+    EXPECT_EQ(runWithResult<int>("local t = Truck:new() return t:load() + t:wheels()"), 14);
+    EXPECT_EQ(Vehicle::bound, 1);
+    EXPECT_EQ(Truck::bound, 1);
+    EXPECT_EQ(runWithResult<int>("return Vehicle:new():wheels()"), 4);
+    EXPECT_EQ(Vehicle::bound, 1);
+}
+
+TEST_F(LazyTest, BoundWhenPushedFromCpp) {
+    Truck truck;
+    luabind::value_mirror<Truck*>::to_lua(L, &truck);
+    lua_setglobal(L, "truck");
+    EXPECT_EQ(Truck::bound, 1);
+    EXPECT_EQ(runWithResult<int>("return truck:load()"), 10);
+}
+
+TEST_F(LazyTest, UnknownGlobals) {
+    EXPECT_EQ(run("assert(Missing == nil)"), LUA_OK);
+    EXPECT_EQ(Vehicle::bound, 0);
+}
+
+TEST_F(LazyTest, PreviousIndexIsKept) {
+    lua_State* S = luaL_newstate();
+    luaL_openlibs(S);
+    luaL_dostring(S, "setmetatable(_G, {__index = function(_, key) return key .. '!' end})");
+    luabind::lazy_class<Vehicle>(S, "Vehicle", &bindVehicle);
+    EXPECT_EQ(luaL_dostring(S, "return Vehicle:new():wheels(), Missing"), LUA_OK);
+    EXPECT_EQ(lua_tointeger(S, -2), 4);
+    EXPECT_STREQ(lua_tostring(S, -1), "Missing!");
+    lua_close(S);
+}
+
+TEST_F(LazyTest, Module) {
+    lua_newtable(L);
+    luabind::lazy_bind<boat_class>(L, -1);
+    lua_setglobal(L, "sea");
+    EXPECT_EQ(runWithResult<int>("return sea.Boat:new().speed"), 20);
+    EXPECT_EQ(run("assert(Boat == nil)"), LUA_OK);
+}
+
+TEST_F(LazyTest, BinderNotBinding) {
+    luabind::lazy_class<Unbound>(L, "Unbound", [](lua_State*) {});
+    runExpectingError("return Unbound", "Lazy binder of 'Unbound' did not bind it.");
+    // the binder is kept, a second read fails the same way
+    runExpectingError("return Unbound", "Lazy binder of 'Unbound' did not bind it.");
+}
+
+TEST_F(LazyTest, BinderThrowing) {
+    static int runs = 0;
+    runs = 0;
+    luabind::lazy_class<Unbound>(L, "Unbound", [](lua_State*) {
+        ++runs;
+        throw std::runtime_error("binder failed");
+    });
+    runExpectingError("return Unbound", "binder failed");
+    runExpectingError("return Unbound", "binder failed");
+    EXPECT_EQ(runs, 2);
+}
+
+TEST(Lazy, StatePool) {
+    luabind::state_pool pool(
+        [](lua_State* L) {
+            luaL_openlibs(L);
+            luabind::lazy_class<Vehicle>(L, "Vehicle", &bindVehicle);
+        },
+        1);
+    for (int i = 0; i < 3; ++i) {
+        auto L = pool.acquire();
+        // the class is bound after the snapshot, the restored globals lose it
+        ASSERT_EQ(luaL_dostring(L, "return Vehicle:new():wheels()"), LUA_OK);
+        EXPECT_EQ(lua_tointeger(L, -1), 4);
+    }
+    EXPECT_EQ(pool.get_metrics().created, 1u);
+}
@@ -18,27 +18,37 @@ protected:
 
 public:
     int run(const char* script) {
-        int r = luaL_dostring(L, script);
+        return run(L, script);
+    }
+
+    template <typename T>
+    T runWithResult(const char* script) {
+        return runWithResult<T>(L, script);
+    }
+
+    // The same for states which are not owned by the test, pooled or worker ones.
+    static int run(lua_State* state, const char* script) {
+        int r = luaL_dostring(state, script);
         if (r != LUA_OK) {
-            const char* error = lua_tostring(L, -1);
+            const char* error = lua_tostring(state, -1);
             std::cerr << "Error: " << error << std::endl;
         }
         return r;
     }
 
     template <typename T>
-    T runWithResult(const char* script) {
-        int r = luaL_dostring(L, script);
+    static T runWithResult(lua_State* state, const char* script) {
+        int r = luaL_dostring(state, script);
         if (r != LUA_OK) {
-            const char* error = lua_tostring(L, -1);
+            const char* error = lua_tostring(state, -1);
             std::cerr << "Error: " << error << std::endl;
             EXPECT_EQ(r, LUA_OK);
             static T t {};
             return t;
         }
-        EXPECT_EQ(lua_gettop(L), 1);
-        T t = luabind::value_mirror<T>::from_lua(L, -1);
-        lua_pop(L, -1);
+        EXPECT_EQ(lua_gettop(state), 1);
+        T t = luabind::value_mirror<T>::from_lua(state, -1);
+        lua_pop(state, -1);
         return t;
     }
 
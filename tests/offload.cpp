@@ -0,0 +1,226 @@
+#include "lua_test.hpp"
+
+#include <luabind/offload.hpp>
+
+#include <atomic>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+// Keeps the jobs until the test runs them, on its own thread and in submission order.
+class manual_pool : public luabind::offload_pool {
+public:
+    void submit(job j) override {
+        jobs.push_back(std::move(j));
+    }
+
+    void run_all() {
+        while (!jobs.empty()) {
+            job j = std::move(jobs.front());
+            jobs.pop_front();
+            j();
+        }
+    }
+
+    std::deque<job> jobs;
+};
+
+static std::atomic<std::thread::id> worker_thread;
+
+static std::string checksum(std::string_view data) {
+    worker_thread = std::this_thread::get_id();
+    unsigned sum = 0;
+    for (char c : data) {
+        sum = sum * 31 + static_cast<unsigned char>(c);
+    }
+    return std::to_string(sum);
+}
+
+static int broken(int) {
+    throw std::runtime_error("offloaded call failed");
+}
+
+static void touch(int) {}
+
+class Image : public luabind::Object {
+public:
+    explicit Image(int width)
+        : width(width) {}
+
+    ~Image() override {
+        ++destroyed;
+    }
+
+    int blur(int radius) const {
+        return width * radius;
+    }
+
+    void resize(int w) {
+        width = w;
+    }
+
+    int width;
+
+    static inline int destroyed = 0;
+};
+
+class OffloadTest : public LuaTest {
+protected:
+    OffloadTest()
+        : queue(std::make_unique<luabind::offload_queue>(L, pool)) {
+        luabind::function<luabind::offload<&checksum>>(L, "checksum");
+        luabind::function<luabind::offload<&broken>>(L, "broken");
+        luabind::function<luabind::offload<&touch>>(L, "touch");
+        luabind::class_<Image>(L, "Image")
+            .constructor<int>("new")
+            .function<luabind::offload<&Image::blur>>("blur")
+            .function<luabind::offload<&Image::resize>>("resize")
+            .property<&Image::width>("width");
+    }
+
+    ~OffloadTest() override {
+        // before the state is closed
+        queue.reset();
+    }
+
+    manual_pool pool;
+    std::unique_ptr<luabind::offload_queue> queue;
+};
+
+TEST_F(OffloadTest, CoroutineWaitsForResult) {
+    ASSERT_EQ(run("co = coroutine.create(function() result = checksum('abc') end) assert(coroutine.resume(co))"),
+              LUA_OK);
+    EXPECT_EQ(runWithResult<std::string>("return coroutine.status(co)"), "suspended");
+    EXPECT_EQ(pool.jobs.size(), 1u);
+    EXPECT_EQ(queue->pending(), 1u);
+    EXPECT_EQ(queue->poll(), 0u);
+
+    pool.run_all();
+    // the result is only delivered by the state's thread
+    EXPECT_EQ(run("assert(result == nil)"), LUA_OK);
+    EXPECT_EQ(queue->poll(), 1u);
+    EXPECT_EQ(runWithResult<std::string>("return result"), checksum("abc"));
+    EXPECT_EQ(runWithResult<std::string>("return coroutine.status(co)"), "dead");
+    EXPECT_EQ(queue->pending(), 0u);
+}
+
+TEST_F(OffloadTest, ArgumentsConvertedBeforeRunning) {
+    ASSERT_EQ(run("s = 'x' coroutine.wrap(function() result = checksum(s .. 'yz') end)() s = nil collectgarbage()"),
+              LUA_OK);
+    pool.run_all();
+    queue->poll();
+    EXPECT_EQ(runWithResult<std::string>("return result"), checksum("xyz"));
+}
+
+TEST_F(OffloadTest, Methods) {
+    ASSERT_EQ(run(R"--(
+        coroutine.wrap(function()
+            local image = Image:new(3)
+            image:resize(5)
+            result = image:blur(2)
+        end)()
+    )--"),
+              LUA_OK);
+    pool.run_all();
+    queue->poll();
+    EXPECT_EQ(run("assert(result == nil)"), LUA_OK);
+    pool.run_all();
+    queue->poll();
+    EXPECT_EQ(runWithResult<int>("return result"), 10);
+}
+
+TEST_F(OffloadTest, VoidResult) {
+    ASSERT_EQ(run("coroutine.wrap(function() done = select('#', touch(1)) end)()"), LUA_OK);
+    pool.run_all();
+    queue->poll();
+    EXPECT_EQ(runWithResult<int>("return done"), 0);
+}
+
+TEST_F(OffloadTest, ExceptionIsLuaError) {
+    ASSERT_EQ(run("coroutine.wrap(function() ok, message = pcall(broken, 1) end)()"), LUA_OK);
+    pool.run_all();
+    queue->poll();
+    EXPECT_EQ(runWithResult<bool>("return ok"), false);
+    EXPECT_EQ(runWithResult<std::string>("return message"), "offloaded call failed");
+}
+
+TEST_F(OffloadTest, Errors) {
+    runExpectingError("checksum('a')",
+                      "The function has to wait for its result, it can only be called from a coroutine.");
+    runExpectingError("error(select(2, coroutine.resume(coroutine.create(checksum))), 0)",
+                      "Invalid number of arguments, should be 1, but 0 were given.");
+    EXPECT_TRUE(pool.jobs.empty());
+    queue.reset();
+    runExpectingError("error(select(2, coroutine.resume(coroutine.create(checksum), 'a')), 0)",
+                      "The function is offloaded, but no offload_queue is attached to the state.");
+}
+
+TEST_F(OffloadTest, ResumedBeforeCompletion) {
+    ASSERT_EQ(run("co = coroutine.create(function() result = touch(1) or 'done' end) coroutine.resume(co)"), LUA_OK);
+    EXPECT_EQ(run("assert(coroutine.resume(co)) assert(coroutine.status(co) == 'suspended')"), LUA_OK);
+    pool.run_all();
+    EXPECT_EQ(run("assert(coroutine.resume(co)) assert(coroutine.status(co) == 'suspended')"), LUA_OK);
+    queue->poll();
+    EXPECT_EQ(runWithResult<std::string>("return result"), "done");
+}
+
+TEST_F(OffloadTest, ArgumentsKeptWhenCoroutineCloses) {
+    Image::destroyed = 0;
+    ASSERT_EQ(run(R"--(
+        co = coroutine.create(function() result = Image:new(4):blur(1) end)
+        coroutine.resume(co)
+        coroutine.close(co)
+        co = nil
+        collectgarbage()
+    )--"),
+              LUA_OK);
+    EXPECT_EQ(Image::destroyed, 0);
+    pool.run_all();
+    EXPECT_EQ(queue->poll(), 1u);
+    EXPECT_EQ(run("collectgarbage() assert(result == nil)"), LUA_OK);
+    EXPECT_EQ(Image::destroyed, 1);
+}
+
+TEST_F(OffloadTest, PendingWhenStateCloses) {
+    ASSERT_EQ(run("for i = 1, 3 do coroutine.wrap(function() checksum('a') end)() end"), LUA_OK);
+    pool.run_all();
+    queue.reset();
+    // the finished calls are released by lua_close
+}
+
+TEST(Offload, ThreadPool) {
+    lua_State* L = luaL_newstate();
+    luaL_openlibs(L);
+    luabind::function<luabind::offload<&checksum>>(L, "checksum");
+    {
+        luabind::thread_pool pool(4);
+        std::atomic<int> notified {0};
+        luabind::offload_queue queue(L, pool, [&notified] { notified.fetch_add(1); });
+        ASSERT_EQ(luaL_dostring(L, R"--(
+            results = {}
+            for i = 1, 100 do
+                coroutine.wrap(function() results[i] = checksum(tostring(i)) end)()
+            end
+        )--"),
+                  LUA_OK);
+        // the interpreter keeps running while the pool works
+        size_t polled = 0;
+        while (polled < 100) {
+            polled += queue.poll();
+            std::this_thread::yield();
+        }
+        EXPECT_EQ(notified.load(), 100);
+        EXPECT_NE(worker_thread.load(), std::this_thread::get_id());
+        for (int i = 1; i <= 100; ++i) {
+            lua_getglobal(L, "results");
+            lua_rawgeti(L, -1, i);
+            EXPECT_EQ(luabind::value_mirror<std::string>::from_lua(L, -1), checksum(std::to_string(i)));
+            lua_pop(L, 2);
+        }
+        EXPECT_EQ(queue.pending(), 0u);
+    }
+    lua_close(L);
+}
@@ -0,0 +1,183 @@
+#include "lua_test.hpp"
+
+#include <string>
+
+class Vec : public luabind::Object {
+public:
+    Vec() = default;
+
+    Vec(int x, int y)
+        : x(x)
+        , y(y) {}
+
+public:
+    int x = 0;
+    int y = 0;
+};
+
+class Sprite : public luabind::Object {
+public:
+    Sprite() = default;
+
+    explicit Sprite(const Vec& v)
+        : x(v.x)
+        , y(v.y) {}
+
+    Sprite(int x, int y)
+        : x(x)
+        , y(y) {}
+
+    void setPos(int px, int py) {
+        x = px;
+        y = py;
+    }
+
+    void setPos(const Vec& v) {
+        x = v.x;
+        y = v.y;
+    }
+
+    void setPos(int px, int py, int pz) {
+        x = px;
+        y = py;
+        z = pz;
+    }
+
+    std::string describe(int v) const {
+        return "int " + std::to_string(v);
+    }
+
+    std::string describe(double) const {
+        return "double";
+    }
+
+    std::string describe(const std::string& s) const {
+        return "string " + s;
+    }
+
+    std::string describe(bool) const {
+        return "bool";
+    }
+
+    static int count(int a) {
+        return a;
+    }
+
+    static int count(int a, int b) {
+        return a + b;
+    }
+
+public:
+    int x = 0;
+    int y = 0;
+    int z = 0;
+};
+
+int scale(int v) {
+    return v * 2;
+}
+
+double scale(double v) {
+    return v * 3;
+}
+
+class OverloadTest : public LuaTest {
+protected:
+    void SetUp() override {
+        luabind::class_<Vec>(L, "Vec").constructor<int, int>("new");
+        luabind::class_<Sprite>(L, "Sprite")
+            .constructor<luabind::signature<>, luabind::signature<int, int>, luabind::signature<const Vec&>>("new")
+            .construct_shared<luabind::signature<int, int>, luabind::signature<const Vec&>>("create")
+            .function<static_cast<void (Sprite::*)(int, int)>(&Sprite::setPos),
+                      static_cast<void (Sprite::*)(const Vec&)>(&Sprite::setPos),
+                      static_cast<void (Sprite::*)(int, int, int)>(&Sprite::setPos)>("setPos")
+            .function<static_cast<std::string (Sprite::*)(int) const>(&Sprite::describe),
+                      static_cast<std::string (Sprite::*)(double) const>(&Sprite::describe),
+                      static_cast<std::string (Sprite::*)(const std::string&) const>(&Sprite::describe),
+                      static_cast<std::string (Sprite::*)(bool) const>(&Sprite::describe)>("describe")
+            .class_function<static_cast<int (*)(int)>(&Sprite::count), static_cast<int (*)(int, int)>(&Sprite::count)>(
+                "count")
+            .property<&Sprite::x>("x")
+            .property<&Sprite::y>("y")
+            .property<&Sprite::z>("z");
+
+        luabind::function<static_cast<int (*)(int)>(&scale), static_cast<double (*)(double)>(&scale)>(L, "scale");
+
+        EXPECT_EQ(lua_gettop(L), 0);
+    }
+};
+
+TEST_F(OverloadTest, Methods) {
+    int r = run(R"--(
+        s = Sprite:new()
+        s:setPos(1, 2)
+        assert(s.x == 1 and s.y == 2)
+        s:setPos(Vec:new(3, 4))
+        assert(s.x == 3 and s.y == 4)
+        s:setPos(5, 6, 7)
+        assert(s.x == 5 and s.y == 6 and s.z == 7)
+
+        assert(s:describe(1) == 'int 1')
+        assert(s:describe(1.5) == 'double')
+        assert(s:describe('a') == 'string a')
+        assert(s:describe(true) == 'bool')
+
+        assert(Sprite:count(1) == 1)
+        assert(Sprite:count(1, 2) == 3)
+    )--");
+    EXPECT_EQ(r, LUA_OK);
+}
+
+TEST_F(OverloadTest, Constructors) {
+    int r = run(R"--(
+        a = Sprite:new()
+        assert(a.x == 0 and a.y == 0)
+        b = Sprite:new(1, 2)
+        assert(b.x == 1 and b.y == 2)
+        c = Sprite:new(Vec:new(3, 4))
+        assert(c.x == 3 and c.y == 4)
+        d = Sprite:create(5, 6)
+        assert(d.x == 5 and d.y == 6)
+        e = Sprite:create(Vec:new(7, 8))
+        assert(e.x == 7 and e.y == 8)
+    )--");
+    EXPECT_EQ(r, LUA_OK);
+}
+
+TEST_F(OverloadTest, FreeFunction) {
+    int r = run(R"--(
+        assert(scale(2) == 4)
+        assert(scale(2.5) == 7.5)
+    )--");
+    EXPECT_EQ(r, LUA_OK);
+}
+
+TEST_F(OverloadTest, Errors) {
+    runExpectingError(
+        R"--(
+        s = Sprite:new()
+        s:setPos(1, 2, 3, 4)
+    )--",
+        "No overload accepts the given 4 arguments.");
+
+    runExpectingError(
+        R"--(
+        s = Sprite:new()
+        s:describe({})
+    )--",
+        "No overload accepts the given 1 arguments.");
+
+    // the only candidate with two arguments reports the conversion error itself
+    runExpectingError(
+        R"--(
+        s = Sprite:new()
+        s:setPos(1, 'a')
+    )--",
+        "Argument at 3 has invalid type. Expecting 'integer', but got 'string'.");
+
+    runExpectingError(
+        R"--(
+        scale('a')
+    )--",
+        "No overload accepts the given 1 arguments.");
+}
@@ -0,0 +1,379 @@
+#include "lua_test.hpp"
+
+#include <luabind/scheduler.hpp>
+#include <luabind/task.hpp>
+
+#include <chrono>
+#include <coroutine>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif // __linux__
+
+using namespace std::chrono_literals;
+
+// Time of the scheduler under test, moved by the tests only.
+static std::chrono::steady_clock::time_point manual_now;
+
+// Resumes the task awaiting it when opened, from a function called by another coroutine.
+struct gate {
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+        waiter = handle;
+    }
+
+    void await_resume() const noexcept {}
+
+    std::coroutine_handle<> waiter;
+};
+
+static gate door;
+
+static luabind::task<int> passDoor(int v) {
+    co_await door;
+    co_return v + 1;
+}
+
+static void openDoor() {
+    std::exchange(door.waiter, nullptr).resume();
+}
+
+// Keeps the jobs until the test runs them.
+class manual_pool : public luabind::offload_pool {
+public:
+    void submit(job j) override {
+        jobs.push_back(std::move(j));
+    }
+
+    void run_all() {
+        while (!jobs.empty()) {
+            job j = std::move(jobs.front());
+            jobs.pop_front();
+            j();
+        }
+    }
+
+    std::deque<job> jobs;
+};
+
+static int slowSquare(int v) {
+    std::this_thread::sleep_for(20ms);
+    return v * v;
+}
+
+class SchedulerTest : public LuaTest {
+protected:
+    SchedulerTest() {
+        manual_now = {};
+        luabind::scheduler_options options;
+        options.now = [] { return manual_now; };
+        start(options);
+        EXPECT_EQ(run("log = {}"), LUA_OK);
+    }
+
+    ~SchedulerTest() override {
+        sched.reset();
+    }
+
+    void start(luabind::scheduler_options options) {
+        sched.reset();
+        sched = std::make_unique<luabind::scheduler>(L, std::move(options));
+    }
+
+    // Moves the clock and runs one tick.
+    size_t tickAt(std::chrono::steady_clock::duration t) {
+        manual_now = std::chrono::steady_clock::time_point {} + t;
+        return sched->run_once();
+    }
+
+    std::string log() {
+        return runWithResult<std::string>("return table.concat(log, ' ')");
+    }
+
+    std::unique_ptr<luabind::scheduler> sched;
+};
+
+TEST_F(SchedulerTest, SpawnRunsWithNextTick) {
+    ASSERT_EQ(run("scheduler.spawn(function(a, b) log[#log + 1] = a .. b end, 'x', 'y')"), LUA_OK);
+    EXPECT_EQ(log(), "");
+    EXPECT_EQ(sched->size(), 1u);
+    EXPECT_EQ(sched->run_once(), 1u);
+    EXPECT_EQ(log(), "xy");
+    EXPECT_EQ(sched->size(), 0u);
+}
+
+TEST_F(SchedulerTest, SpawnFromCpp) {
+    ASSERT_EQ(run("function greet(name) log[#log + 1] = 'hi ' .. name end"), LUA_OK);
+    lua_getglobal(L, "greet");
+    lua_pushstring(L, "lua");
+    sched->spawn(L, 1);
+    EXPECT_EQ(lua_gettop(L), 0);
+    sched->run_once();
+    EXPECT_EQ(log(), "hi lua");
+}
+
+TEST_F(SchedulerTest, SleepWakesAtItsTime) {
+    ASSERT_EQ(run(R"--(
+        for _, d in ipairs({0.005, 0.002, 0.010}) do
+            scheduler.spawn(function()
+                local start = scheduler.now()
+                scheduler.sleep(d)
+                log[#log + 1] = string.format('%g', d)
+                assert(scheduler.now() - start >= d)
+            end)
+        end
+    )--"),
+              LUA_OK);
+    EXPECT_EQ(tickAt(0ms), 3u);
+    EXPECT_EQ(tickAt(1ms), 0u);
+    EXPECT_EQ(tickAt(2ms), 1u);
+    EXPECT_EQ(log(), "0.002");
+    EXPECT_EQ(tickAt(4ms), 0u);
+    // several ticks at once
+    EXPECT_EQ(tickAt(20ms), 2u);
+    EXPECT_EQ(log(), "0.002 0.005 0.01");
+    EXPECT_EQ(sched->size(), 0u);
+}
+
+TEST_F(SchedulerTest, LongSleepsMoveDownTheWheel) {
+    ASSERT_EQ(run(R"--(
+        for _, d in ipairs({0.3, 70, 100000}) do
+            scheduler.spawn(function() scheduler.sleep(d) log[#log + 1] = tostring(d) end)
+        end
+    )--"),
+              LUA_OK);
+    tickAt(0ms);
+    EXPECT_EQ(tickAt(299ms), 0u);
+    EXPECT_EQ(tickAt(300ms), 1u);
+    EXPECT_EQ(tickAt(69999ms), 0u);
+    EXPECT_EQ(tickAt(70000ms), 1u);
+    EXPECT_EQ(tickAt(99999999ms), 0u);
+    EXPECT_EQ(tickAt(100000000ms), 1u);
+    EXPECT_EQ(log(), "0.3 70 100000");
+}
+
+TEST_F(SchedulerTest, FairOrderWithinBudget) {
+    luabind::scheduler_options options;
+    options.now = [] { return manual_now; };
+    options.budget = 2;
+    start(options);
+    ASSERT_EQ(run(R"--(
+        for i = 1, 3 do
+            scheduler.spawn(function()
+                for _ = 1, 2 do
+                    log[#log + 1] = tostring(i)
+                    scheduler.yield()
+                end
+            end)
+        end
+    )--"),
+              LUA_OK);
+    EXPECT_EQ(sched->run_once(), 2u);
+    EXPECT_EQ(log(), "1 2");
+    EXPECT_EQ(sched->run_once(), 2u);
+    EXPECT_EQ(log(), "1 2 3 1");
+    EXPECT_EQ(sched->run_once(), 2u);
+    EXPECT_EQ(log(), "1 2 3 1 2 3");
+    sched->run_once();
+    sched->run_once();
+    EXPECT_EQ(sched->size(), 0u);
+}
+
+TEST_F(SchedulerTest, CoroutineYieldGivesWay) {
+    ASSERT_EQ(run(R"--(
+        scheduler.spawn(function() log[#log + 1] = 'a' coroutine.yield(1) log[#log + 1] = 'c' end)
+        scheduler.spawn(function() log[#log + 1] = 'b' end)
+    )--"),
+              LUA_OK);
+    sched->run_once();
+    sched->run_once();
+    EXPECT_EQ(log(), "a b c");
+}
+
+TEST_F(SchedulerTest, ThreadsAreReused) {
+    ASSERT_EQ(run(R"--(
+        threads = {}
+        for i = 1, 100 do
+            scheduler.spawn(function() threads[coroutine.running()] = true end)
+        end
+    )--"),
+              LUA_OK);
+    sched->run_once();
+    ASSERT_EQ(run("for i = 1, 100 do scheduler.spawn(function() threads[coroutine.running()] = true end) end"),
+              LUA_OK);
+    sched->run_once();
+    EXPECT_EQ(runWithResult<int>("local n = 0 for _ in pairs(threads) do n = n + 1 end return n"), 100);
+    const luabind::scheduler::stats stats = sched->get_stats();
+    EXPECT_EQ(stats.spawned, 200u);
+    EXPECT_EQ(stats.threads, 100u);
+}
+
+TEST_F(SchedulerTest, ErrorsAreWarnings) {
+    static std::string warning;
+    warning.clear();
+    lua_setwarnf(
+        L, [](void*, const char* message, int) { warning += message; }, nullptr);
+    ASSERT_EQ(run("scheduler.spawn(function() scheduler.yield() error('broken', 0) end)"), LUA_OK);
+    sched->run_once();
+    sched->run_once();
+    EXPECT_EQ(warning, "error in scheduled coroutine (broken)");
+    EXPECT_EQ(sched->get_stats().failed, 1u);
+    EXPECT_EQ(sched->size(), 0u);
+    // the thread is clean for the next coroutine
+    ASSERT_EQ(run("scheduler.spawn(function(v) log[#log + 1] = v end, 'next')"), LUA_OK);
+    sched->run_once();
+    EXPECT_EQ(log(), "next");
+    EXPECT_EQ(sched->get_stats().threads, 1u);
+}
+
+#ifdef __linux__
+TEST_F(SchedulerTest, InvalidFd) {
+    static std::string warning;
+    warning.clear();
+    lua_setwarnf(
+        L, [](void*, const char* message, int) { warning += message; }, nullptr);
+    ASSERT_EQ(run("scheduler.spawn(function() scheduler.wait_readable(-1) end)"), LUA_OK);
+    sched->run_once();
+    EXPECT_EQ(warning, "error in scheduled coroutine (Cannot wait for fd -1: Bad file descriptor)");
+}
+#endif // __linux__
+
+TEST_F(SchedulerTest, Errors) {
+    runExpectingError("scheduler.sleep(1)",
+                      "The function can only be called from a coroutine spawned by the scheduler.");
+    runExpectingError("scheduler.spawn(1)", "Expecting a function to spawn, but got 'number'.");
+    ASSERT_EQ(run("spawn = scheduler.spawn"), LUA_OK);
+    sched.reset();
+    runExpectingError("spawn(print)", "No scheduler is attached to the state.");
+}
+
+TEST_F(SchedulerTest, ResumedElsewhereWhileSleeping) {
+    ASSERT_EQ(run("scheduler.spawn(function() co = coroutine.running() scheduler.sleep(10) log[#log + 1] = 'woke' "
+                  "scheduler.sleep(0.001) log[#log + 1] = 'slept' end)"),
+              LUA_OK);
+    tickAt(0ms);
+    // the first sleep is cancelled, the coroutine sleeps again
+    ASSERT_EQ(run("assert(coroutine.resume(co))"), LUA_OK);
+    EXPECT_EQ(log(), "woke");
+    EXPECT_EQ(tickAt(1ms), 1u);
+    EXPECT_EQ(log(), "woke slept");
+    EXPECT_EQ(tickAt(10000ms), 0u);
+    EXPECT_EQ(sched->size(), 0u);
+}
+
+TEST(Scheduler, RunUntilDone) {
+    lua_State* L = luaL_newstate();
+    luaL_openlibs(L);
+    {
+        luabind::scheduler sched(L);
+        ASSERT_EQ(luaL_dostring(L, R"--(
+            done = 0
+            for i = 1, 100 do
+                scheduler.spawn(function()
+                    scheduler.sleep((i % 3) / 1000)
+                    done = done + 1
+                end)
+            end
+        )--"),
+                  LUA_OK);
+        sched.run();
+        EXPECT_EQ(sched.size(), 0u);
+        lua_getglobal(L, "done");
+        EXPECT_EQ(lua_tointeger(L, -1), 100);
+        lua_pop(L, 1);
+    }
+    lua_close(L);
+}
+
+#ifdef __linux__
+TEST_F(SchedulerTest, WaitsForFd) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    lua_pushinteger(L, fds[0]);
+    lua_setglobal(L, "reader");
+    lua_pushinteger(L, fds[1]);
+    lua_setglobal(L, "writer");
+    ASSERT_EQ(run(R"--(
+        scheduler.spawn(function() scheduler.wait_readable(reader) log[#log + 1] = 'readable' end)
+        scheduler.spawn(function() scheduler.wait_writable(writer) log[#log + 1] = 'writable' end)
+    )--"),
+              LUA_OK);
+    sched->run_once();
+    sched->run_once();
+    EXPECT_EQ(log(), "writable");
+    sched->run_once();
+    EXPECT_EQ(log(), "writable");
+    ASSERT_EQ(write(fds[1], "x", 1), 1);
+    sched->run_once();
+    EXPECT_EQ(log(), "writable readable");
+    EXPECT_EQ(sched->size(), 0u);
+    close(fds[0]);
+    close(fds[1]);
+}
+#endif // __linux__
+
+TEST_F(SchedulerTest, TaskWaitIsNotPolled) {
+    luabind::function<&passDoor>(L, "passDoor");
+    luabind::function<&openDoor>(L, "openDoor");
+    ASSERT_EQ(run(R"--(
+        scheduler.spawn(function() local v = passDoor(1) log[#log + 1] = v end)
+        scheduler.spawn(function() scheduler.sleep(0.005) openDoor() log[#log + 1] = 'opened' end)
+    )--"),
+              LUA_OK);
+    tickAt(0ms);
+    for (int i = 1; i < 5; ++i) {
+        EXPECT_EQ(tickAt(std::chrono::milliseconds(i)), 0u);
+    }
+    EXPECT_EQ(sched->ready(), 0u);
+    EXPECT_EQ(tickAt(5ms), 1u);
+    EXPECT_EQ(log(), "opened");
+    // made ready during the tick, resumed by the next one
+    EXPECT_EQ(sched->run_once(), 1u);
+    EXPECT_EQ(log(), "opened 2");
+    EXPECT_EQ(sched->size(), 0u);
+    EXPECT_EQ(sched->get_stats().resumed, 4u);
+}
+
+TEST_F(SchedulerTest, PollsOffloadQueue) {
+    manual_pool pool;
+    int notified = 0;
+    luabind::offload_queue queue(L, pool, [&notified] { ++notified; });
+    luabind::function<luabind::offload<&slowSquare>>(L, "square");
+    ASSERT_EQ(run("scheduler.spawn(function() local v = square(3) log[#log + 1] = v end)"), LUA_OK);
+    EXPECT_EQ(sched->run_once(), 1u);
+    EXPECT_EQ(sched->run_once(), 0u);
+    EXPECT_EQ(sched->ready(), 0u);
+    pool.run_all();
+    EXPECT_EQ(notified, 1);
+    EXPECT_EQ(sched->run_once(), 1u);
+    EXPECT_EQ(log(), "9");
+    EXPECT_EQ(sched->size(), 0u);
+}
+
+TEST(Scheduler, RunSleepsUntilOffloadedCallFinishes) {
+    lua_State* L = luaL_newstate();
+    luaL_openlibs(L);
+    {
+        luabind::thread_pool pool(1);
+        luabind::scheduler sched(L);
+        luabind::offload_queue queue(L, pool, [&sched] { sched.notify(); });
+        luabind::function<luabind::offload<&slowSquare>>(L, "square");
+        ASSERT_EQ(luaL_dostring(L, "scheduler.spawn(function() result = square(4) end)"), LUA_OK);
+        sched.run();
+        EXPECT_EQ(sched.size(), 0u);
+        // started and resumed with the result, not polled meanwhile
+        EXPECT_EQ(sched.get_stats().resumed, 2u);
+        lua_getglobal(L, "result");
+        EXPECT_EQ(lua_tointeger(L, -1), 16);
+        lua_pop(L, 1);
+    }
+    lua_close(L);
+}
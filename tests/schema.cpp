@@ -0,0 +1,129 @@
+#include "lua_test.hpp"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+class Shape : public luabind::Object {
+public:
+    int getId() const {
+        return id;
+    }
+
+    static int count() {
+        return 42;
+    }
+
+    int at(int idx) const {
+        return idx * 10;
+    }
+
+public:
+    int id = 1;
+};
+
+class Circle : public Shape {
+public:
+    explicit Circle(double r)
+        : radius(r) {}
+
+    double area() const {
+        return radius * radius * 3;
+    }
+
+public:
+    double radius;
+};
+
+class Ring : public Circle {
+public:
+    Ring()
+        : Circle(2) {}
+
+    double width() const {
+        return 0.5;
+    }
+};
+
+void bindShapes(lua_State* L) {
+    luabind::class_<Shape>(L, "Shape", luabind::class_options::method_table)
+        .function<&Shape::getId>("getId")
+        .class_function<&Shape::count>("count")
+        .property<&Shape::id>("id")
+        .array_access<&Shape::at>();
+    luabind::class_<Circle, Shape>(L, "Circle").constructor<double>("create").function<&Circle::area>("area");
+}
+
+class SchemaTest : public LuaTest {
+protected:
+    SchemaTest() {
+        lua_State* origin = luaL_newstate();
+        bindShapes(origin);
+        shapes = luabind::schema::capture(origin);
+        lua_close(origin);
+
+        luabind::schema::attach(L, shapes);
+    }
+
+    std::shared_ptr<const luabind::schema> shapes;
+};
+
+TEST_F(SchemaTest, AttachedTypes) {
+    EXPECT_EQ(runWithResult<int>("local s = Shape:new() s.id = 7 return s:getId()"), 7);
+    EXPECT_EQ(runWithResult<int>("return Shape:count()"), 42);
+    EXPECT_EQ(runWithResult<int>("return Shape:new()[3]"), 30);
+    EXPECT_EQ(runWithResult<double>("local c = Circle:create(2) return c:area() + c:getId() + c[1]"), 23.0);
+
+    // the custom table is per object, as without a schema
+    EXPECT_EQ(runWithResult<std::string>("local s = Shape:new() s.tag = 'a' return s.tag"), "a");
+}
+
+TEST_F(SchemaTest, LocalTypesDeriveFromShared) {
+    luabind::class_<Ring, Circle>(L, "Ring").function<&Ring::width>("width");
+    EXPECT_EQ(runWithResult<double>("local r = Ring:new() return r:width() + r:area() + r:getId()"), 13.5);
+}
+
+TEST_F(SchemaTest, SharedTypesAreImmutable) {
+    EXPECT_THROW(luabind::class_<Shape>(L, "Shape").function<&Shape::getId>("other"), luabind::error);
+    EXPECT_THROW(luabind::schema::attach(L, shapes), luabind::error);
+    EXPECT_THROW(luabind::schema::capture(L), luabind::error);
+}
+
+TEST(Schema, CapturedStateKeepsWorking) {
+    lua_State* L = luaL_newstate();
+    bindShapes(L);
+    auto shapes = luabind::schema::capture(L);
+    ASSERT_EQ(luaL_dostring(L, "return Circle:create(1):area()"), LUA_OK);
+    EXPECT_EQ(lua_tonumber(L, -1), 3.0);
+    lua_close(L);
+    EXPECT_EQ(shapes.use_count(), 1);
+    EXPECT_EQ(shapes->get_types().size(), 2u);
+}
+
+TEST(Schema, ConcurrentAttach) {
+    lua_State* origin = luaL_newstate();
+    bindShapes(origin);
+    auto shapes = luabind::schema::capture(origin);
+    lua_close(origin);
+
+    std::vector<int> results(8, 0);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < results.size(); ++i) {
+        threads.emplace_back([&shapes, &results, i] {
+            lua_State* L = luaL_newstate();
+            luaL_openlibs(L);
+            luabind::schema::attach(L, shapes);
+            if (luaL_dostring(L, "local s = 0 for i = 1, 1000 do s = s + Shape:new():getId() end return s") ==
+                LUA_OK) {
+                results[i] = static_cast<int>(lua_tointeger(L, -1));
+            }
+            lua_close(L);
+        });
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    for (int r : results) {
+        EXPECT_EQ(r, 1000);
+    }
+}
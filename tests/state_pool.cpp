@@ -0,0 +1,126 @@
+#include "lua_test.hpp"
+
+#include <luabind/state_pool.hpp>
+
+#include <stdexcept>
+#include <string>
+
+class Counter : public luabind::Object {
+public:
+    int next() {
+        return ++value;
+    }
+
+public:
+    int value = 0;
+};
+
+void initState(lua_State* L) {
+    luaL_openlibs(L);
+    luabind::class_<Counter>(L, "Counter").function<&Counter::next>("next");
+    luaL_dostring(L, "config = {name = 'base'}");
+}
+
+// the state owned by the fixture is not used, the pool creates its own
+class StatePoolTest : public LuaTest {};
+
+TEST_F(StatePoolTest, ReusesStates) {
+    luabind::state_pool pool(&initState, 2);
+    lua_State* first = nullptr;
+    {
+        auto L = pool.acquire();
+        first = L;
+        EXPECT_EQ(run(L, "return Counter:new():next()"), LUA_OK);
+    }
+    EXPECT_EQ(pool.idle_size(), 1u);
+    auto L = pool.acquire();
+    EXPECT_EQ(L.get(), first);
+    EXPECT_EQ(pool.get_metrics().created, 1u);
+}
+
+TEST_F(StatePoolTest, RestoresGlobals) {
+    luabind::state_pool pool(&initState, 1);
+    {
+        auto L = pool.acquire();
+        ASSERT_EQ(run(L, R"(
+            leaked = 1
+            print = nil
+            config = {name = 'changed'}
+            string.extra = true
+            Counter.extra = true
+            package.loaded.module = {}
+        )"),
+                  LUA_OK);
+        lua_pushinteger(L, 1); // left on the stack
+    }
+    auto L = pool.acquire();
+    EXPECT_EQ(lua_gettop(L), 0);
+    EXPECT_EQ(runWithResult<std::string>(L, "return tostring(leaked)"), "nil");
+    EXPECT_EQ(runWithResult<std::string>(L, "return type(print)"), "function");
+    EXPECT_EQ(runWithResult<std::string>(L, "return config.name"), "base");
+    EXPECT_EQ(runWithResult<std::string>(L, "return tostring(string.extra)"), "nil");
+    EXPECT_EQ(runWithResult<std::string>(L, "return tostring(Counter.extra)"), "nil");
+    EXPECT_EQ(runWithResult<std::string>(L, "return tostring(package.loaded.module)"), "nil");
+    EXPECT_EQ(runWithResult<std::string>(L, "return tostring(Counter:new():next())"), "1");
+}
+
+TEST_F(StatePoolTest, RestoresMetatables) {
+    luabind::state_pool pool(&initState, 1);
+    {
+        auto L = pool.acquire();
+        ASSERT_EQ(run(L, R"(
+            setmetatable(_G, {__index = function() return 'leaked' end})
+            setmetatable(config, {__index = {extra = true}})
+            getmetatable('').__call = function() return 'leaked' end
+            debug.setmetatable(0, {__index = {leaked = true}})
+        )"),
+                  LUA_OK);
+    }
+    auto L = pool.acquire();
+    EXPECT_EQ(runWithResult<std::string>(L, "return tostring(missing)"), "nil");
+    EXPECT_EQ(runWithResult<std::string>(L, "return tostring(getmetatable(config))"), "nil");
+    EXPECT_EQ(runWithResult<std::string>(L, "return tostring(getmetatable('').__call)"), "nil");
+    EXPECT_EQ(runWithResult<std::string>(L, "return tostring(getmetatable(0))"), "nil");
+    EXPECT_EQ(runWithResult<std::string>(L, "return ('abc'):upper()"), "ABC");
+}
+
+TEST_F(StatePoolTest, MaxIdle) {
+    luabind::state_pool pool(&initState, 1);
+    {
+        auto a = pool.acquire();
+        auto b = pool.acquire();
+        auto c = pool.acquire();
+    }
+    EXPECT_EQ(pool.idle_size(), 1u);
+    const luabind::state_pool::metrics m = pool.get_metrics();
+    EXPECT_EQ(m.created, 3u);
+    EXPECT_EQ(m.discarded, 2u);
+    EXPECT_EQ(m.acquire.count, 3u);
+    EXPECT_EQ(m.release.count, 3u);
+    EXPECT_GE(m.acquire.max, m.acquire.mean());
+
+    pool.warm_up(5);
+    EXPECT_EQ(pool.idle_size(), 1u);
+}
+
+TEST_F(StatePoolTest, HandleReset) {
+    luabind::state_pool pool(&initState);
+    pool.warm_up(2);
+    EXPECT_EQ(pool.idle_size(), 2u);
+    auto L = pool.acquire();
+    EXPECT_EQ(pool.idle_size(), 1u);
+    auto moved = std::move(L);
+    EXPECT_EQ(L.get(), nullptr);
+    moved.reset();
+    EXPECT_EQ(moved.get(), nullptr);
+    EXPECT_EQ(pool.idle_size(), 2u);
+}
+
+TEST_F(StatePoolTest, InitializerError) {
+    // the state is closed when its initialization fails, the leak checker of sanitized builds sees it otherwise
+    luabind::state_pool pool([](lua_State*) { throw std::runtime_error("init failed"); });
+    EXPECT_THROW(pool.acquire(), std::runtime_error);
+    EXPECT_THROW(pool.warm_up(1), std::runtime_error);
+    EXPECT_EQ(pool.idle_size(), 0u);
+    EXPECT_EQ(pool.get_metrics().created, 0u);
+}
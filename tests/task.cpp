@@ -0,0 +1,205 @@
+#include "lua_test.hpp"
+
+#include <luabind/task.hpp>
+
+#include <coroutine>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Resumes the coroutines awaiting it when fired, as an event loop would.
+struct event {
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+        waiters.push_back(handle);
+    }
+
+    void await_resume() const noexcept {}
+
+    void fire() {
+        for (std::coroutine_handle<> handle : std::exchange(waiters, {})) {
+            handle.resume();
+        }
+    }
+
+    std::vector<std::coroutine_handle<>> waiters;
+};
+
+static event tick;
+
+luabind::task<int> twice(int v) {
+    co_await tick;
+    co_return v * 2;
+}
+
+luabind::task<int> ready(int v) {
+    co_return v + 1;
+}
+
+luabind::task<> waitTick() {
+    co_await tick;
+}
+
+luabind::task<std::string> fail() {
+    co_await tick;
+    throw std::runtime_error("task failed");
+}
+
+luabind::task<int> chained(int v) {
+    const int a = co_await twice(v);
+    const int b = co_await ready(a);
+    co_return b;
+}
+
+class Downloader : public luabind::Object {
+public:
+    luabind::task<std::string> fetch(std::string url) {
+        co_await tick;
+        ++fetched;
+        co_return "content of " + url;
+    }
+
+    int fetched = 0;
+};
+
+class TaskTest : public LuaTest {
+protected:
+    TaskTest() {
+        tick.waiters.clear();
+        luabind::function<&twice>(L, "twice");
+        luabind::function<&ready>(L, "ready");
+        luabind::function<&waitTick>(L, "waitTick");
+        luabind::function<&fail>(L, "fail");
+        luabind::function<&chained>(L, "chained");
+        luabind::class_<Downloader>(L, "Downloader")
+            .function<&Downloader::fetch>("fetch")
+            .property<&Downloader::fetched>("fetched");
+    }
+
+    ~TaskTest() override {
+        lua_close(L);
+        L = nullptr;
+        // frames of tasks destroyed with the state
+        tick.waiters.clear();
+    }
+};
+
+TEST_F(TaskTest, CompletedWithoutSuspending) {
+    EXPECT_EQ(runWithResult<int>("return ready(1)"), 2);
+    EXPECT_EQ(runWithResult<int>("return coroutine.wrap(function() return ready(2) end)()"), 3);
+}
+
+TEST_F(TaskTest, CoroutineWaitsForTask) {
+    ASSERT_EQ(run("result = nil co = coroutine.create(function() result = twice(21) end) coroutine.resume(co)"),
+              LUA_OK);
+    EXPECT_EQ(runWithResult<std::string>("return coroutine.status(co)"), "suspended");
+    EXPECT_EQ(run("assert(result == nil)"), LUA_OK);
+    tick.fire();
+    EXPECT_EQ(runWithResult<int>("return result"), 42);
+    EXPECT_EQ(runWithResult<std::string>("return coroutine.status(co)"), "dead");
+}
+
+TEST_F(TaskTest, ManyWaitsOnOneThread) {
+    ASSERT_EQ(run(R"--(
+        sum, done = 0, 0
+        for i = 1, 1000 do
+            coroutine.wrap(function()
+                local v = twice(i)
+                sum = sum + v
+                waitTick()
+                done = done + 1
+            end)()
+        end
+    )--"),
+              LUA_OK);
+    EXPECT_EQ(tick.waiters.size(), 1000u);
+    tick.fire();
+    EXPECT_EQ(runWithResult<int>("return sum"), 1000 * 1001);
+    EXPECT_EQ(runWithResult<int>("return done"), 0);
+    tick.fire();
+    EXPECT_EQ(runWithResult<int>("return done"), 1000);
+    EXPECT_TRUE(tick.waiters.empty());
+}
+
+TEST_F(TaskTest, Methods) {
+    ASSERT_EQ(run(R"--(
+        d = Downloader:new()
+        coroutine.wrap(function() page = d:fetch('a') .. ', ' .. d:fetch('b') end)()
+    )--"),
+              LUA_OK);
+    tick.fire();
+    tick.fire();
+    EXPECT_EQ(runWithResult<std::string>("return page"), "content of a, content of b");
+    EXPECT_EQ(runWithResult<int>("return d.fetched"), 2);
+}
+
+TEST_F(TaskTest, ChainedTasks) {
+    ASSERT_EQ(run("coroutine.wrap(function() result = chained(5) end)()"), LUA_OK);
+    tick.fire();
+    EXPECT_EQ(runWithResult<int>("return result"), 11);
+}
+
+TEST_F(TaskTest, ExceptionIsLuaError) {
+    ASSERT_EQ(run("coroutine.wrap(function() ok, message = pcall(fail) end)()"), LUA_OK);
+    tick.fire();
+    EXPECT_EQ(runWithResult<bool>("return ok"), false);
+    EXPECT_EQ(runWithResult<std::string>("return message"), "task failed");
+}
+
+TEST_F(TaskTest, OutsideOfCoroutine) {
+    runExpectingError("twice(1)", "The function has to wait for its result, it can only be called from a coroutine.");
+    tick.fire();
+}
+
+TEST_F(TaskTest, ResumedBeforeCompletion) {
+    ASSERT_EQ(run("co = coroutine.create(function() result = twice(2) end) coroutine.resume(co)"), LUA_OK);
+    EXPECT_EQ(run("assert(coroutine.resume(co)) assert(coroutine.status(co) == 'suspended')"), LUA_OK);
+    tick.fire();
+    EXPECT_EQ(runWithResult<int>("return result"), 4);
+}
+
+TEST_F(TaskTest, ClosedWhileWaiting) {
+    ASSERT_EQ(run("co = coroutine.create(function() result = twice(2) end) coroutine.resume(co) coroutine.close(co)"),
+              LUA_OK);
+    tick.fire();
+    EXPECT_EQ(run("assert(result == nil)"), LUA_OK);
+}
+
+TEST_F(TaskTest, ErrorAfterResumeIsWarning) {
+    static std::string warning;
+    warning.clear();
+    lua_setwarnf(
+        L, [](void*, const char* message, int) { warning += message; }, nullptr);
+    ASSERT_EQ(run("coroutine.wrap(function() twice(1) error('after', 0) end)()"), LUA_OK);
+    tick.fire();
+    EXPECT_EQ(warning, "error in resumed coroutine (after)");
+}
+
+struct Guard {
+    ~Guard() {
+        ++released;
+    }
+
+    static inline int released = 0;
+};
+
+luabind::task<> guarded() {
+    Guard guard;
+    co_await tick;
+}
+
+TEST(Task, ReleasedWithState) {
+    Guard::released = 0;
+    lua_State* L = luaL_newstate();
+    luaL_openlibs(L);
+    luabind::function<&guarded>(L, "guarded");
+    ASSERT_EQ(luaL_dostring(L, "for i = 1, 3 do coroutine.wrap(guarded)() end"), LUA_OK);
+    EXPECT_EQ(Guard::released, 0);
+    lua_close(L);
+    EXPECT_EQ(Guard::released, 3);
+    tick.waiters.clear();
+}
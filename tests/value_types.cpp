@@ -0,0 +1,149 @@
+#include "lua_test.hpp"
+
+#include <cmath>
+#include <cstdint>
+
+struct Vec3 final {
+    float x = 0;
+    float y = 0;
+    float z = 0;
+
+    Vec3() = default;
+
+    Vec3(float x, float y, float z)
+        : x(x)
+        , y(y)
+        , z(z) {}
+
+    float length() const {
+        return std::sqrt(x * x + y * y + z * z);
+    }
+
+    void scale(float f) {
+        x *= f;
+        y *= f;
+        z *= f;
+    }
+};
+
+struct Color final {
+    float r = 0;
+    float g = 0;
+    float b = 0;
+    float a = 1;
+};
+
+// large enough to overlap every field of a user_data header
+struct Big final {
+    uint32_t a[12] = {};
+
+    void set(int i, uint32_t v) {
+        a[i] = v;
+    }
+};
+
+class Body : public luabind::Object {
+public:
+    Vec3 getPosition() const {
+        return position;
+    }
+
+    void setPosition(const Vec3& p) {
+        position = p;
+    }
+
+public:
+    Vec3 position;
+};
+
+Vec3 add(Vec3 a, const Vec3& b) {
+    return {a.x + b.x, a.y + b.y, a.z + b.z};
+}
+
+float sumOf(const Vec3* v) {
+    return v->x + v->y + v->z;
+}
+
+void takeBody(Body*) {}
+
+static_assert(luabind::is_value_type_v<Vec3>);
+static_assert(!luabind::is_value_type_v<Body>);
+
+class ValueTypeTest : public LuaTest {
+protected:
+    ValueTypeTest() {
+        luabind::class_<Vec3>(L, "Vec3")
+            .constructor<float, float, float>("create")
+            .property<&Vec3::x>("x")
+            .property<&Vec3::y>("y")
+            .property<&Vec3::z>("z")
+            .function<&Vec3::length>("length")
+            .function<&Vec3::scale>("scale");
+        luabind::class_<Color>(L, "Color").property<&Color::r>("r").property<&Color::a>("a");
+        luabind::class_<Big>(L, "Big").function<&Big::set>("set");
+        luabind::class_<Body>(L, "Body").property<&Body::getPosition, &Body::setPosition>("position");
+        luabind::function<&add>(L, "add");
+        luabind::function<&sumOf>(L, "sumOf");
+        luabind::function<&takeBody>(L, "takeBody");
+    }
+};
+
+TEST_F(ValueTypeTest, Members) {
+    EXPECT_EQ(runWithResult<float>("local v = Vec3:create(3, 4, 0) return v:length()"), 5.0f);
+    EXPECT_EQ(runWithResult<float>("local v = Vec3:new() v.y = 2 return v.y"), 2.0f);
+    EXPECT_EQ(runWithResult<float>("local v = Vec3:create(1, 2, 3) v:scale(2) return v.z"), 6.0f);
+    EXPECT_EQ(runWithResult<float>("local c = Color:new() c.r = 0.5 return c.r + c.a"), 1.5f);
+}
+
+TEST_F(ValueTypeTest, Arguments) {
+    EXPECT_EQ(runWithResult<float>("return add(Vec3:create(1, 2, 3), Vec3:create(1, 1, 1)).z"), 4.0f);
+    EXPECT_EQ(runWithResult<float>("return sumOf(Vec3:create(1, 2, 3))"), 6.0f);
+
+    const Vec3 v = runWithResult<Vec3>("return Vec3:create(7, 8, 9)");
+    EXPECT_EQ(v.y, 8.0f);
+}
+
+TEST_F(ValueTypeTest, CopiedToObjects) {
+    // a value read from a C++ object is a copy, changing it does not change the object
+    EXPECT_EQ(runWithResult<float>(R"(
+        local b = Body:new()
+        b.position = Vec3:create(1, 2, 3)
+        local p = b.position
+        p.x = 100
+        return b.position.x
+    )"),
+              1.0f);
+}
+
+TEST_F(ValueTypeTest, InlineStorage) {
+    ASSERT_EQ(run("v = Vec3:new()"), LUA_OK);
+    lua_getglobal(L, "v");
+    EXPECT_LE(lua_rawlen(L, -1), sizeof(Vec3) + 8);
+    EXPECT_NE(luabind::value_user_data<Vec3>::from_lua(L, -1), nullptr);
+    EXPECT_EQ(luabind::value_user_data<Color>::from_lua(L, -1), nullptr);
+    EXPECT_EQ(luabind::user_data::from_lua(L, -1), nullptr);
+    lua_pop(L, 1);
+}
+
+TEST_F(ValueTypeTest, Errors) {
+    runExpectingError("local v = Vec3:new() v.w = 1", "Type 'Vec3' has no member named 'w'.");
+    runExpectingError("return sumOf(Color:new())",
+                      "Argument at 1 has invalid type. Expecting value of type 'Vec3', but got lua type 'userdata'");
+    runExpectingError("return sumOf({})",
+                      "Argument at 1 has invalid type. Expecting value of type 'Vec3', but got lua type 'table'");
+    runExpectingError(
+        "takeBody(Vec3:new())",
+        "Argument at 1 has invalid type. Expecting user_data of type 'Body', but got lua type 'userdata'");
+}
+
+TEST_F(ValueTypeTest, ForgedHeader) {
+    // the payload of a value type is written by scripts, it is never read as a user_data header
+    static_assert(sizeof(Big) >= sizeof(luabind::user_data));
+    runExpectingError(
+        "local b = Big:new() for i = 0, 11 do b:set(i, 0x4C42554D) end takeBody(b)",
+        "Argument at 1 has invalid type. Expecting user_data of type 'Body', but got lua type 'userdata'");
+    ASSERT_EQ(run("b = Big:new() for i = 0, 11 do b:set(i, 0x4C42554D) end"), LUA_OK);
+    lua_getglobal(L, "b");
+    EXPECT_EQ(luabind::user_data::from_lua(L, -1), nullptr);
+    lua_pop(L, 1);
+}
@@ -0,0 +1,9 @@
+#ifndef LUABIND_USERSTATE_H
+#define LUABIND_USERSTATE_H
+
+// Force-included into Lua sources when LUABIND_USE_EXTRASPACE is ON.
+// Lua does not initialize the main thread's extra space, but copies it into every new thread,
+// so zeroing it once lets luabind tell whether its type storage pointer is already cached there.
+#define luai_userstateopen(L) (*(void**)lua_getextraspace(L) = NULL)
+
+#endif // LUABIND_USERSTATE_H